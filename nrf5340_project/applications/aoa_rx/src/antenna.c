@@ -0,0 +1,5 @@
+#include "antenna.h"
+
+const uint8_t aoa_ant_patterns[AOA_ANT_MAX] = {
+    0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf,
+};
@@ -0,0 +1,35 @@
+#ifndef AOA_RX_ANTENNA_H_
+#define AOA_RX_ANTENNA_H_
+
+#include <stdint.h>
+#include <zephyr/toolchain.h>
+#include <zephyr/bluetooth/direction.h>
+
+#include <aoa/array.h>
+
+/* The core codes slot durations as the controller does */
+BUILD_ASSERT(AOA_SLOT_DURATION_1US == BT_DF_ANTENNA_SWITCHING_SLOT_1US &&
+             AOA_SLOT_DURATION_2US == BT_DF_ANTENNA_SWITCHING_SLOT_2US,
+             "Slot duration codes differ from the controller's");
+
+/* Antenna switching pattern (antenna matrix GPIO codes); the first AOA_ANT_COUNT are used */
+extern const uint8_t aoa_ant_patterns[AOA_ANT_MAX];
+
+/*
+ * CTE type and receive antenna pattern for the CTE RX parameters. For AoD
+ * the transmitter switches its antennas and this device samples one, so
+ * the array settings describe the transmitter's array and no pattern is
+ * given to the controller.
+ */
+#if defined(CONFIG_AOA_RX_AOD)
+#define AOA_CTE_TYPE (AOA_SLOT_DURATION == AOA_SLOT_DURATION_2US ? BT_DF_CTE_TYPE_AOD_2US \
+                                                                 : BT_DF_CTE_TYPE_AOD_1US)
+#define AOA_RX_ANT_IDS_COUNT 0
+#define AOA_RX_ANT_IDS NULL
+#else
+#define AOA_CTE_TYPE BT_DF_CTE_TYPE_AOA
+#define AOA_RX_ANT_IDS_COUNT AOA_ANT_COUNT
+#define AOA_RX_ANT_IDS aoa_ant_patterns
+#endif
+
+#endif /* AOA_RX_ANTENNA_H_ */
@@ -0,0 +1,14 @@
+#ifndef AOA_RX_H_
+#define AOA_RX_H_
+
+/* Name advertised by the AoA tags this locator tracks */
+#define AOA_TAG_NAME "AoA_TX_Sim"
+
+/**
+ * @brief (Re)start passive scanning for tags.
+ *
+ * Safe to call while scanning is already active.
+ */
+int aoa_rx_scan_start(void);
+
+#endif /* AOA_RX_H_ */
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+
+#include "calib.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+#define CALIB_SUBTREE "aoa/cal"
+
+// Read by the DSP thread; written at boot and, when measuring, by the DSP thread
+static struct aoa_calib calib;
+
+const struct aoa_calib *calib_get(void)
+{
+    return &calib;
+}
+
+// "<channel>": the channel's weights, element 0 first
+static int calib_set(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    char *end;
+    const unsigned long chan = strtoul(key, &end, 10);
+
+    if (end == key || *end || chan >= AOA_CALIB_CHANNELS) {
+        return -ENOENT;
+    }
+    if (len != sizeof(calib.w[chan])) {
+        // Measured on an array with another element count
+        LOG_WRN("Calibration for channel %lu does not fit this array", chan);
+        return 0;
+    }
+
+    const ssize_t ret = read_cb(cb_arg, calib.w[chan], len);
+    if (ret < 0) {
+        return ret;
+    }
+    calib.channels |= BIT64(chan);
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(aoa_calib, CALIB_SUBTREE, NULL, calib_set, NULL, NULL);
+
+#if defined(CONFIG_AOA_RX_CALIB_MEASURE)
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+#define CALIB_ELEVATION_DEG CONFIG_AOA_RX_CALIB_ELEVATION_DEG
+#else
+#define CALIB_ELEVATION_DEG 0
+#endif
+
+static struct aoa_calib_acc acc;
+
+void calib_measure(const struct aoa_iq_report *report)
+{
+    const uint8_t chan = report->chan_idx;
+
+    if (aoa_calib_measure(&acc, report) || acc.count[chan] != CONFIG_AOA_RX_CALIB_REPORTS) {
+        return;
+    }
+
+    struct aoa_iq_sample w[AOA_ANT_COUNT];
+    int err = aoa_calib_solve(&acc, chan, CONFIG_AOA_RX_CALIB_AZIMUTH_DEG, CALIB_ELEVATION_DEG, w);
+    if (err) {
+        LOG_WRN("Calibration of channel %u failed (err %d)", chan, err);
+        return;
+    }
+    memcpy(calib.w[chan], w, sizeof(w));
+    calib.channels |= BIT64(chan);
+
+    char key[sizeof(CALIB_SUBTREE "/39")];
+    snprintk(key, sizeof(key), CALIB_SUBTREE "/%u", chan);
+    err = settings_save_one(key, w, sizeof(w));
+    LOG_INF("Channel %u calibrated, %d of %d (save err %d)", chan,
+            __builtin_popcountll(calib.channels), AOA_CALIB_CHANNELS, err);
+}
+
+#endif /* CONFIG_AOA_RX_CALIB_MEASURE */
+
+// Before the DSP thread starts
+static int calib_init(void)
+{
+    aoa_calib_reset(&calib);
+
+    int err = settings_subsys_init();
+    if (!err) {
+        err = settings_load_subtree(CALIB_SUBTREE);
+    }
+    if (err) {
+        LOG_ERR("Calibration not loaded (err %d)", err);
+        return 0;
+    }
+    LOG_INF("Calibration loaded for %d channels", __builtin_popcountll(calib.channels));
+    return 0;
+}
+
+SYS_INIT(calib_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
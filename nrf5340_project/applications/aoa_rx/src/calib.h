@@ -0,0 +1,51 @@
+#ifndef AOA_RX_CALIB_H_
+#define AOA_RX_CALIB_H_
+
+#include <zephyr/sys/util.h>
+
+#include <aoa/calib.h>
+
+#include "iq_report.h"
+
+/*
+ * Array calibration tables in settings, one key per BLE channel
+ * ("aoa/cal/<channel>", AOA_ANT_COUNT Q14 weights). They are loaded into
+ * RAM at boot and the estimator applies them to every snapshot. With
+ * CONFIG_AOA_RX_CALIB_MEASURE the DSP thread also measures them, taking
+ * every report as one from a reference tag at the configured direction.
+ */
+
+#if defined(CONFIG_AOA_RX_CALIB)
+
+/** @brief The loaded tables, for aoa_state.calib. */
+const struct aoa_calib *calib_get(void);
+
+#else
+
+static inline const struct aoa_calib *calib_get(void)
+{
+    return NULL;
+}
+
+#endif /* CONFIG_AOA_RX_CALIB */
+
+#if defined(CONFIG_AOA_RX_CALIB_MEASURE)
+
+/**
+ * @brief Fold a reference tag report into its channel's sums.
+ *
+ * Once a channel has CONFIG_AOA_RX_CALIB_REPORTS reports its weights are
+ * solved, take effect and are saved. Only called from the DSP thread.
+ */
+void calib_measure(const struct aoa_iq_report *report);
+
+#else
+
+static inline void calib_measure(const struct aoa_iq_report *report)
+{
+    ARG_UNUSED(report);
+}
+
+#endif /* CONFIG_AOA_RX_CALIB_MEASURE */
+
+#endif /* AOA_RX_CALIB_H_ */
@@ -0,0 +1,144 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/direction.h>
+#include <zephyr/logging/log.h>
+
+#include "antenna.h"
+#include "aoa_rx.h"
+#include "conn_cte.h"
+#include "ipc_link.h"
+#include "stats.h"
+#include "tag.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+static const struct bt_le_conn_param conn_param =
+    BT_LE_CONN_PARAM_INIT(CONFIG_AOA_RX_CONN_INTERVAL, CONFIG_AOA_RX_CONN_INTERVAL, 0, 400);
+
+static atomic_t conn_count;
+
+bool conn_cte_slot_available(void)
+{
+    return atomic_get(&conn_count) < CONFIG_BT_MAX_CONN && tag_available();
+}
+
+int conn_cte_connect(const bt_addr_le_t *addr, uint8_t sid)
+{
+    if (atomic_get(&conn_count) >= CONFIG_BT_MAX_CONN) {
+        return -ENOMEM;
+    }
+
+    struct aoa_tag *tag = tag_alloc(addr, sid, AOA_IQ_SOURCE_CONN);
+    if (!tag) {
+        return -ENOMEM;
+    }
+
+    // The reference returned here is owned by the tag until disconnection
+    int err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, &conn_param, &tag->conn);
+    if (err) {
+        tag_free(tag);
+        return err;
+    }
+    atomic_inc(&conn_count);
+    return 0;
+}
+
+static void conn_tag_release(struct aoa_tag *tag)
+{
+    bt_conn_unref(tag->conn);
+    tag_free(tag);
+    atomic_dec(&conn_count);
+}
+
+static int cte_request_enable(struct bt_conn *conn)
+{
+    const struct bt_df_conn_cte_rx_param cte_rx_param = {
+        .cte_types = AOA_CTE_TYPE,
+        .slot_durations = AOA_SLOT_DURATION,
+        .num_ant_ids = AOA_RX_ANT_IDS_COUNT,
+        .ant_ids = AOA_RX_ANT_IDS,
+    };
+    const struct bt_df_conn_cte_req_params cte_req_params = {
+        .interval = CONFIG_AOA_RX_CONN_CTE_REQ_INTERVAL,
+        .cte_length = CONFIG_AOA_RX_CTE_LEN,
+        .cte_type = AOA_CTE_TYPE,
+    };
+
+    int err = bt_df_conn_cte_rx_enable(conn, &cte_rx_param);
+    if (err) {
+        LOG_ERR("Connection CTE RX enable failed (err %d)", err);
+        return err;
+    }
+
+    err = bt_df_conn_cte_req_enable(conn, &cte_req_params);
+    if (err) {
+        LOG_ERR("CTE request enable failed (err %d)", err);
+    }
+    return err;
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    struct aoa_tag *tag = tag_find_conn(conn);
+    if (!tag) {
+        return; // Not a tag connection
+    }
+
+    if (err) {
+        LOG_WRN("Tag connection failed (err 0x%02x)", err);
+        conn_tag_release(tag);
+    } else {
+        tag->state = AOA_TAG_SYNCED;
+        LOG_INF("Connected to tag, requesting CTE every %d event(s)",
+                CONFIG_AOA_RX_CONN_CTE_REQ_INTERVAL);
+        if (cte_request_enable(conn)) {
+            bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+        }
+    }
+
+    aoa_rx_scan_start();
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    struct aoa_tag *tag = tag_find_conn(conn);
+    if (!tag) {
+        return;
+    }
+
+    LOG_INF("Tag disconnected (reason 0x%02x)", reason);
+    conn_tag_release(tag);
+
+    aoa_rx_scan_start();
+}
+
+static void cte_report_cb(struct bt_conn *conn,
+                          const struct bt_df_conn_iq_samples_report *report)
+{
+    if (report->err != BT_DF_IQ_REPORT_ERR_SUCCESS) {
+        LOG_DBG("CTE request failed (err %d)", report->err);
+        return;
+    }
+
+    struct aoa_tag *tag = tag_find_conn(conn);
+    if (!tag) {
+        return;
+    }
+    tag->last_report = k_uptime_get_32();
+    stats_cte(tag, report->conn_evt_counter);
+
+    struct aoa_iq_report *dst = ipc_link_report_alloc();
+    if (dst) {
+        iq_report_from_conn(dst, tag->id, report);
+        dst->priority = tag->priority;
+        dst->generation = tag->generation;
+        ipc_link_report_send(dst);
+    }
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .cte_report_cb = cte_report_cb,
+};
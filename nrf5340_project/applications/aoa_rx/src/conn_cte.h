@@ -0,0 +1,24 @@
+#ifndef AOA_RX_CONN_CTE_H_
+#define AOA_RX_CONN_CTE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+/**
+ * @brief Connect to a tag and request CTEs on every connection event.
+ *
+ * Scanning must already be stopped. The CTE request is enabled from the
+ * connected callback once the link is up.
+ *
+ * The tag takes a block of the tag pool for as long as it stays connected.
+ *
+ * @return 0 on success, -ENOMEM if all connection or tag slots are in use,
+ *         or a negative error from bt_conn_le_create().
+ */
+int conn_cte_connect(const bt_addr_le_t *addr, uint8_t sid);
+
+/** @brief True if another tag can be tracked over a connection. */
+bool conn_cte_slot_available(void);
+
+#endif /* AOA_RX_CONN_CTE_H_ */
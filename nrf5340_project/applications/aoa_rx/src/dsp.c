@@ -0,0 +1,54 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include <aoa/dsp.h>
+
+#include "calib.h"
+#include "ipc_link.h"
+#include "sched.h"
+#include "stats.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+// Per-tag estimator state, owned by the DSP thread
+static struct aoa_state state;
+
+static void dsp_thread(void *p1, void *p2, void *p3)
+{
+    state.calib = calib_get();
+
+    while (1) {
+        // Drain the ring into the scheduler, and block only once nothing is left to estimate
+        struct aoa_iq_report *report =
+            ipc_link_report_recv(sched_pending() ? K_NO_WAIT : K_FOREVER);
+        while (report) {
+            sched_admit(report);
+            report = ipc_link_report_recv(K_NO_WAIT);
+        }
+
+        bool downgrade;
+        report = sched_next(&downgrade);
+        if (!report) {
+            continue;
+        }
+
+        calib_measure(report);
+
+        struct aoa_angle_result *result = ipc_link_result_alloc();
+        if (result) {
+            const uint64_t start = stats_now();
+            const int err = aoa_process(&state, report, downgrade, result);
+
+            stats_estimate(start, downgrade);
+            if (err == 0) {
+                ipc_link_result_send(result);
+            } else {
+                ipc_link_result_free(result);
+            }
+        }
+        ipc_link_report_free(report);
+    }
+}
+
+K_THREAD_DEFINE(dsp_tid, CONFIG_AOA_RX_DSP_STACK_SIZE, dsp_thread, NULL, NULL, NULL,
+                CONFIG_AOA_RX_DSP_PRIORITY, K_FP_REGS, 0);
@@ -0,0 +1,222 @@
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+
+#include "aoa_rx.h"
+#include "duty.h"
+#include "ipc_link.h"
+#include "resync.h"
+#include "tag.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+#define MOTION_ALPHA 0.25f              // Smoothing of the angular speed estimate
+#define MOTION_WINDOW_S 1.0f            // Baseline of each speed sample; shorter ones measure noise
+#define MOTION_GAP_MAX 1000             // Events; a longer gap restarts the estimate
+#define LOAD_LEVEL_MAX 3                // Tolerated angle change per update doubles per level
+
+struct motion {
+    bool valid;
+    uint16_t event_counter;             // Start of the current baseline
+    float azimuth;
+    float elevation;
+    float speed;                        // Degrees per second
+    uint8_t hold;                       // Evaluations a higher skip has been wanted
+};
+
+// Only touched from the system work queue: the result handler and the evaluation below
+static struct motion motions[CONFIG_AOA_RX_MAX_TAGS];
+static uint8_t load_level;
+
+// Ids whose tag left or was replaced since their motion was last touched
+static ATOMIC_DEFINE(forgotten, CONFIG_AOA_RX_MAX_TAGS);
+
+static atomic_t load_percent;
+static atomic_t skip_changes;
+
+void duty_forget(const struct aoa_tag *tag)
+{
+    atomic_set_bit(forgotten, tag->id);
+}
+
+// Motion of tag @p id, restarted if the id changed hands since
+static struct motion *motion_get(uint8_t id)
+{
+    struct motion *m = &motions[id];
+
+    if (atomic_test_and_clear_bit(forgotten, id)) {
+        *m = (struct motion){ 0 };
+    }
+    return m;
+}
+
+void duty_result(const struct aoa_angle_result *result)
+{
+    if (result->source != AOA_IQ_SOURCE_PER_ADV || result->tag_id >= ARRAY_SIZE(motions)) {
+        return;
+    }
+
+    tag_lock();
+    struct aoa_tag *tag = tag_get(result->tag_id);
+    const uint16_t interval = tag ? tag->interval : 0;
+    tag_unlock();
+
+    struct motion *m = motion_get(result->tag_id);
+    const uint16_t events = result->event_counter - m->event_counter;
+
+    if (!interval) {
+        return;
+    }
+    if (!m->valid || events > MOTION_GAP_MAX) {
+        *m = (struct motion){
+            .valid = true,
+            .event_counter = result->event_counter,
+            .azimuth = result->azimuth,
+            .elevation = result->elevation,
+        };
+        return;
+    }
+    // Event counters advance on skipped events too; interval is in 1.25 ms units
+    const float dt = events * interval * 1.25e-3f;
+    if (dt < MOTION_WINDOW_S) {
+        return;
+    }
+
+    float d_az = fabsf(result->azimuth - m->azimuth);
+    d_az = fminf(d_az, 360.0f - d_az);
+    const float d_el = result->elevation - m->elevation;
+
+    m->speed += MOTION_ALPHA * (hypotf(d_az, d_el) / dt - m->speed);
+    m->event_counter = result->event_counter;
+    m->azimuth = result->azimuth;
+    m->elevation = result->elevation;
+}
+
+// Skip that keeps the angle change between updates within the tolerance
+static uint16_t skip_for(const struct aoa_tag *tag, float speed)
+{
+    const float event_rate = 800.0f / tag->interval;
+    const float tolerance = (float)(CONFIG_AOA_RX_DUTY_DEG_PER_UPDATE << load_level);
+    const float update_rate = speed / tolerance;
+
+    if (update_rate * (CONFIG_AOA_RX_DUTY_SKIP_MAX + 1) <= event_rate) {
+        return CONFIG_AOA_RX_DUTY_SKIP_MAX;
+    }
+    return MAX((int)(event_rate / update_rate) - 1, 0);
+}
+
+static uint32_t load_sample(void)
+{
+    uint32_t load = 0;
+
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+    static k_thread_runtime_stats_t prev;
+    k_thread_runtime_stats_t now;
+
+    // total_cycles excludes idle, execution_cycles includes it
+    if (k_thread_runtime_stats_all_get(&now) == 0) {
+        const uint64_t busy = now.total_cycles - prev.total_cycles;
+        const uint64_t all = now.execution_cycles - prev.execution_cycles;
+
+        load = all ? (uint32_t)(busy * 100 / all) : 0;
+        prev = now;
+    }
+#endif
+
+    // A backlog of reports means the estimator, maybe on the other core, is behind
+    struct aoa_pool_stats reports;
+    ipc_link_report_stats(&reports);
+    if (reports.capacity) {
+        load = MAX(load, reports.used * 100 / reports.capacity);
+    }
+    return load;
+}
+
+static void duty_evaluate(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(duty_work, duty_evaluate);
+
+static void duty_evaluate(struct k_work *work)
+{
+    const uint32_t load = load_sample();
+
+    atomic_set(&load_percent, load);
+    if (load >= CONFIG_AOA_RX_DUTY_LOAD_HIGH && load_level < LOAD_LEVEL_MAX) {
+        load_level++;
+    } else if (load <= CONFIG_AOA_RX_DUTY_LOAD_LOW && load_level > 0) {
+        load_level--;
+    }
+
+    tag_lock();
+    for (uint8_t id = 0; id < CONFIG_AOA_RX_MAX_TAGS; id++) {
+        struct aoa_tag *tag = tag_get(id);
+        struct motion *m = motion_get(id);
+
+        if (!tag || tag->source != AOA_IQ_SOURCE_PER_ADV || tag->state != AOA_TAG_SYNCED ||
+            !m->valid) {
+            continue;
+        }
+
+        // Each change costs a resync, so only speed up at once and slow down after a hold
+        const uint16_t skip = skip_for(tag, m->speed);
+        if (skip < tag->target_skip) {
+            tag->target_skip = skip;
+            m->hold = 0;
+        } else if (skip > tag->target_skip && ++m->hold >= CONFIG_AOA_RX_DUTY_HOLD) {
+            tag->target_skip = skip;
+            m->hold = 0;
+        } else if (skip == tag->target_skip) {
+            m->hold = 0;
+        }
+    }
+    tag_unlock();
+
+    k_work_reschedule(&duty_work, K_MSEC(CONFIG_AOA_RX_DUTY_PERIOD_MS));
+}
+
+void duty_report(struct aoa_tag *tag)
+{
+    if (tag->state != AOA_TAG_SYNCED || tag->skip == tag->target_skip) {
+        return;
+    }
+
+    LOG_INF("Tag %u: sync skip %u -> %u", tag->id, tag->skip, tag->target_skip);
+    // The host does not touch the sync again after its report callbacks return
+    int err = bt_le_per_adv_sync_delete(tag->sync);
+    if (err) {
+        LOG_WRN("Sync delete failed (err %d)", err);
+        return;
+    }
+    atomic_inc(&skip_changes);
+
+    // The controller needs the scanner to find the tag again
+    resync_requeue(tag);
+    aoa_rx_scan_start();
+}
+
+void duty_log_stats(void)
+{
+    uint32_t skipping = 0;
+
+    tag_lock();
+    for (uint8_t id = 0; id < CONFIG_AOA_RX_MAX_TAGS; id++) {
+        struct aoa_tag *tag = tag_get(id);
+        if (tag && tag->skip) {
+            skipping++;
+        }
+    }
+    tag_unlock();
+    LOG_INF("Duty cycle: load %u%%, %u tag(s) skipping events, %u skip changes",
+            (uint32_t)atomic_get(&load_percent), skipping, (uint32_t)atomic_get(&skip_changes));
+}
+
+static int duty_init(void)
+{
+    k_work_schedule(&duty_work, K_MSEC(CONFIG_AOA_RX_DUTY_PERIOD_MS));
+    return 0;
+}
+
+SYS_INIT(duty_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
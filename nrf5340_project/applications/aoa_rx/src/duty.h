@@ -0,0 +1,63 @@
+#ifndef AOA_RX_DUTY_H_
+#define AOA_RX_DUTY_H_
+
+#include <zephyr/sys/util.h>
+
+#include "iq_report.h"
+#include "tag.h"
+
+/*
+ * Per-tag duty cycling of periodic advertising syncs. Each tag's angular
+ * speed, measured from its results, sets how many periodic events its sync
+ * may skip, and high CPU load or a backlog of IQ reports raises the
+ * skip of every tag further. Stationary tags then cost a fraction of the
+ * radio and CPU time of moving ones.
+ */
+
+#if defined(CONFIG_AOA_RX_DUTY_CYCLE)
+
+/** @brief Update the motion estimate of the result's tag. Runs in the result handler. */
+void duty_result(const struct aoa_angle_result *result);
+
+/**
+ * @brief Apply a new skip to @p tag if the policy changed it.
+ *
+ * The controller cannot change the skip of a running sync, so the sync is
+ * deleted and created again through the resync path. Runs in the Bluetooth
+ * RX thread, from the CTE report callback.
+ */
+void duty_report(struct aoa_tag *tag);
+
+/**
+ * @brief Drop the motion estimate of @p tag as it enters or leaves the tag table.
+ *
+ * The estimate itself is reset in the system work queue, the next time it is used.
+ */
+void duty_forget(const struct aoa_tag *tag);
+
+void duty_log_stats(void);
+
+#else
+
+static inline void duty_result(const struct aoa_angle_result *result)
+{
+    ARG_UNUSED(result);
+}
+
+static inline void duty_report(struct aoa_tag *tag)
+{
+    ARG_UNUSED(tag);
+}
+
+static inline void duty_forget(const struct aoa_tag *tag)
+{
+    ARG_UNUSED(tag);
+}
+
+static inline void duty_log_stats(void)
+{
+}
+
+#endif /* CONFIG_AOA_RX_DUTY_CYCLE */
+
+#endif /* AOA_RX_DUTY_H_ */
@@ -0,0 +1,141 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+
+#include <aoa/frame.h>
+#include <aoa/record.h>
+
+#include "forward.h"
+#include "ipc_link.h"
+#include "quality.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+/*
+ * Forward thread of a thin locator, in the DSP thread's place at the far
+ * end of the report ring. Each report that passes the quality gate is
+ * encoded as an IQ record, packed with CONFIG_AOA_RX_FORWARD_PACKED,
+ * framed (see aoa/frame.h) and sent with the asynchronous UART API, so
+ * the thread sleeps while DMA drains the frame.
+ * The report goes back to its pool as soon as it is encoded. When the
+ * link is slower than the tags, reports queue in the ring and then fail
+ * to allocate, which the pool statistics show.
+ */
+
+#define UART_NODE DT_CHOSEN(aoa_forward_uart)
+
+BUILD_ASSERT(DT_NODE_HAS_STATUS(UART_NODE, okay),
+             "The thin locator needs a UART chosen as aoa,forward-uart");
+
+static const struct device *const uart = DEVICE_DT_GET(UART_NODE);
+
+static uint8_t record_buf[AOA_FRAME_PAYLOAD_MAX];
+static uint8_t frame_buf[AOA_FRAME_SIZE_MAX];
+static K_SEM_DEFINE(tx_done, 0, 1);
+static bool tx_aborted;
+
+static atomic_t frames;
+static atomic_t headers;
+static atomic_t bytes;
+static atomic_t errors;
+
+static void uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+    if (evt->type == UART_TX_DONE || evt->type == UART_TX_ABORTED) {
+        tx_aborted = evt->type == UART_TX_ABORTED;
+        k_sem_give(&tx_done);
+    }
+}
+
+static int frame_send(const uint8_t *payload, size_t len)
+{
+    const int n = aoa_frame_encode(payload, len, frame_buf, sizeof(frame_buf));
+    if (n < 0) {
+        return n;
+    }
+
+    int err = uart_tx(uart, frame_buf, n, SYS_FOREVER_US);
+    if (!err) {
+        k_sem_take(&tx_done, K_FOREVER);
+        err = tx_aborted ? -EIO : 0;
+    }
+    if (err) {
+        atomic_inc(&errors);
+        return err;
+    }
+    atomic_add(&bytes, n);
+    return 0;
+}
+
+static void forward_thread(void *p1, void *p2, void *p3)
+{
+    if (!device_is_ready(uart)) {
+        LOG_ERR("Forward UART %s not ready", uart->name);
+        return;
+    }
+    int err = uart_callback_set(uart, uart_cb, NULL);
+    if (err) {
+        LOG_ERR("Forward UART has no async API (err %d)", err);
+        return;
+    }
+
+    int64_t header_due = 0;
+
+    while (1) {
+        struct aoa_iq_report *report = ipc_link_report_recv(K_FOREVER);
+        if (!report) {
+            continue;
+        }
+        if (quality_check(report) == QUALITY_DROP) {
+            ipc_link_report_free(report);
+            continue;
+        }
+
+#if defined(CONFIG_AOA_RX_FORWARD_PACKED)
+        const int len = aoa_record_encode_iq_packed(report, record_buf, sizeof(record_buf));
+#else
+        const int len = aoa_record_encode_iq(report, record_buf, sizeof(record_buf));
+#endif
+        ipc_link_report_free(report);
+        if (len < 0) {
+            continue;
+        }
+
+        // Repeat the header so a server that attaches mid-stream learns the array
+        if (k_uptime_get() >= header_due) {
+            uint8_t header[AOA_RECORD_HEADER_SIZE];
+
+            aoa_record_header_encode(header, sizeof(header));
+            if (frame_send(header, sizeof(header)) == 0) {
+                atomic_inc(&headers);
+                header_due = k_uptime_get() + CONFIG_AOA_RX_FORWARD_HEADER_S * MSEC_PER_SEC;
+            }
+        }
+        if (frame_send(record_buf, len) == 0) {
+            atomic_inc(&frames);
+        }
+    }
+}
+
+K_THREAD_DEFINE(forward_tid, CONFIG_AOA_RX_DSP_STACK_SIZE, forward_thread, NULL, NULL, NULL,
+                CONFIG_AOA_RX_DSP_PRIORITY, 0, 0);
+
+void forward_stats_get(struct forward_stats *stats)
+{
+    stats->frames = atomic_get(&frames);
+    stats->headers = atomic_get(&headers);
+    stats->bytes = atomic_get(&bytes);
+    stats->errors = atomic_get(&errors);
+}
+
+void forward_log_stats(void)
+{
+    struct forward_stats stats;
+
+    forward_stats_get(&stats);
+    LOG_INF("Forward: %u reports, %u headers, %u bytes, %u errors", stats.frames,
+            stats.headers, stats.bytes, stats.errors);
+}
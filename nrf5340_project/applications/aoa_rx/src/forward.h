@@ -0,0 +1,33 @@
+#ifndef AOA_RX_FORWARD_H_
+#define AOA_RX_FORWARD_H_
+
+#include <stdint.h>
+#include <zephyr/toolchain.h>
+
+/*
+ * Thin locator (CONFIG_AOA_RX_ROLE_THIN): reports go to an estimation
+ * server over a UART instead of to the DSP thread.
+ */
+
+struct forward_stats {
+    uint32_t frames;            // IQ records sent
+    uint32_t headers;           // Stream headers sent
+    uint32_t bytes;             // On the wire, framing included
+    uint32_t errors;            // Frames the UART failed or aborted
+};
+
+#if defined(CONFIG_AOA_RX_ROLE_THIN)
+
+void forward_stats_get(struct forward_stats *stats);
+
+void forward_log_stats(void);
+
+#else
+
+static inline void forward_log_stats(void)
+{
+}
+
+#endif /* CONFIG_AOA_RX_ROLE_THIN */
+
+#endif /* AOA_RX_FORWARD_H_ */
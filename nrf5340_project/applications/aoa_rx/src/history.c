@@ -0,0 +1,412 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/fs/fcb.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+
+#include <aoa/frame.h>
+#include <aoa/history.h>
+#include <aoa/record.h>
+
+#include "history.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+/*
+ * The result handler encodes each angle into a batch in RAM. A full
+ * batch, or a partial one once it is CONFIG_AOA_RX_HISTORY_FLUSH_S old,
+ * goes to a flash circular buffer (FCB) with a single append, so the
+ * flash is programmed a batch at a time rather than an angle at a time,
+ * and a sector is only erased when the ring wraps onto it, oldest first.
+ * Batches decode on their own, so erasing one loses nothing else.
+ *
+ * Two batch buffers alternate: the result handler fills one while the
+ * history thread writes the other, so an erase never holds up results.
+ * Angles that find both full are dropped and counted.
+ *
+ * A reader sends AOA_HISTORY_READOUT_REQUEST on the history UART. The
+ * thread writes out the batch in progress and sends the whole log,
+ * oldest first, as history records straight from flash, at the UART's
+ * full rate. Nothing is written to the FCB while it is walked, since an
+ * append could rotate away the sector being read: angles logged
+ * meanwhile wait in the two batch buffers, are sent from RAM at the end
+ * of the walk and only then written. Once both buffers are full, further
+ * angles are dropped until the walk ends. The log is left in place;
+ * batches carry the boot and uptime they were logged at, so the reader
+ * can tell what it has seen.
+ */
+
+#define PARTITION_NODE DT_CHOSEN(aoa_history_partition)
+#define UART_NODE DT_CHOSEN(aoa_history_uart)
+
+BUILD_ASSERT(DT_NODE_EXISTS(PARTITION_NODE),
+             "The angle history needs a partition chosen as aoa,history-partition");
+BUILD_ASSERT(DT_NODE_HAS_STATUS(UART_NODE, okay),
+             "The angle history needs a UART chosen as aoa,history-uart");
+
+#define SECTOR_COUNT (DT_REG_SIZE(PARTITION_NODE) / CONFIG_AOA_RX_HISTORY_SECTOR_SIZE)
+
+BUILD_ASSERT(SECTOR_COUNT >= 2 && SECTOR_COUNT <= UINT8_MAX,
+             "The history partition must hold 2 to 255 sectors");
+
+#define HISTORY_MAGIC 0x54534841                // "AHST"
+
+static const struct device *const uart = DEVICE_DT_GET(UART_NODE);
+
+static struct fcb fcb;
+static struct flash_sector sectors[SECTOR_COUNT];
+
+// Shared with the result handler; the thread takes whichever batch is pending
+static struct k_spinlock lock;
+static uint8_t batch_bufs[2][CONFIG_AOA_RX_HISTORY_BATCH_SIZE];
+static struct aoa_history_encoder enc;
+static uint32_t batch_ms;               // Uptime of the filling batch's first angle
+static uint8_t *pending;                // A batch waiting for flash, or NULL
+static size_t pending_len;
+static uint16_t boot;
+static bool log_ready;
+
+static K_SEM_DEFINE(wake, 0, 1);
+static atomic_t readout_requested;
+
+// The thread's own: flash reads and read-out frames
+static uint8_t read_buf[AOA_HISTORY_BATCH_MAX];
+static uint8_t record_buf[AOA_RECORD_HISTORY_SIZE_MAX];
+static uint8_t frame_buf[AOA_FRAME_SIZE(AOA_RECORD_HISTORY_SIZE_MAX)];
+static uint8_t rx_bufs[2][8];
+static uint8_t rx_next;
+static K_SEM_DEFINE(tx_done, 0, 1);
+static bool tx_aborted;
+
+static atomic_t angles;
+static atomic_t dropped;
+static atomic_t batches;
+static atomic_t bytes;
+static atomic_t erases;
+static atomic_t readouts;
+static atomic_t errors;
+
+static uint8_t batch_flags(void)
+{
+    return IS_ENABLED(CONFIG_AOA_RX_ARRAY_URA) ? AOA_HISTORY_ELEVATION : 0;
+}
+
+// Hands the filling batch to the thread and starts the other one; false if it is still busy
+static bool batch_swap_locked(void)
+{
+    if (pending) {
+        return false;
+    }
+    pending = enc.buf;
+    pending_len = enc.len;
+    aoa_history_encoder_init(&enc, enc.buf == batch_bufs[0] ? batch_bufs[1] : batch_bufs[0],
+                             CONFIG_AOA_RX_HISTORY_BATCH_SIZE, boot, batch_flags());
+    return true;
+}
+
+void history_result(const struct aoa_angle_result *result)
+{
+    const struct aoa_history_entry entry = {
+        .time_ms = k_uptime_get_32(),
+        .tag_id = result->tag_id,
+        .azimuth = result->azimuth,
+        .elevation = result->elevation,
+        .quality = result->quality,
+    };
+    bool wake_thread = false;
+    int err = -EAGAIN;
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (log_ready) {
+        err = aoa_history_append(&enc, &entry);
+        if (err == -ENOSPC && batch_swap_locked()) {
+            wake_thread = true;
+            err = aoa_history_append(&enc, &entry);
+        }
+        if (!err && enc.count == 1) {
+            batch_ms = entry.time_ms;
+        }
+    }
+    k_spin_unlock(&lock, key);
+
+    atomic_inc(err ? &dropped : &angles);
+    if (wake_thread) {
+        k_sem_give(&wake);
+    }
+}
+
+static int batch_write(const uint8_t *data, size_t len)
+{
+    struct fcb_entry loc;
+
+    int err = fcb_append(&fcb, len, &loc);
+    if (err == -ENOSPC) {
+        // The ring is full: erase its oldest sector and carry on
+        err = fcb_rotate(&fcb);
+        if (!err) {
+            atomic_inc(&erases);
+            err = fcb_append(&fcb, len, &loc);
+        }
+    }
+    if (!err) {
+        err = flash_area_write(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), data, len);
+    }
+    if (!err) {
+        err = fcb_append_finish(&fcb, &loc);
+    }
+    if (err) {
+        atomic_inc(&errors);
+        return err;
+    }
+    atomic_inc(&batches);
+    atomic_add(&bytes, len);
+    return 0;
+}
+
+static void uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+    switch (evt->type) {
+    case UART_TX_DONE:
+    case UART_TX_ABORTED:
+        tx_aborted = evt->type == UART_TX_ABORTED;
+        k_sem_give(&tx_done);
+        break;
+    case UART_RX_RDY:
+        for (size_t i = 0; i < evt->data.rx.len; i++) {
+            if (evt->data.rx.buf[evt->data.rx.offset + i] == AOA_HISTORY_READOUT_REQUEST) {
+                atomic_set(&readout_requested, 1);
+                k_sem_give(&wake);
+            }
+        }
+        break;
+    case UART_RX_BUF_REQUEST:
+        uart_rx_buf_rsp(dev, rx_bufs[rx_next], sizeof(rx_bufs[0]));
+        rx_next ^= 1;
+        break;
+    case UART_RX_DISABLED:
+        rx_next = 1;
+        uart_rx_enable(dev, rx_bufs[0], sizeof(rx_bufs[0]), SYS_FOREVER_US);
+        break;
+    default:
+        break;
+    }
+}
+
+static int frame_send(const uint8_t *payload, size_t len)
+{
+    const int n = aoa_frame_encode(payload, len, frame_buf, sizeof(frame_buf));
+    if (n < 0) {
+        return n;
+    }
+
+    int err = uart_tx(uart, frame_buf, n, SYS_FOREVER_US);
+    if (!err) {
+        k_sem_take(&tx_done, K_FOREVER);
+        err = tx_aborted ? -EIO : 0;
+    }
+    return err;
+}
+
+static int batch_send(const uint8_t *batch, size_t len)
+{
+    const int n = aoa_record_encode_history(batch, len, record_buf, sizeof(record_buf));
+    return n < 0 ? n : frame_send(record_buf, n);
+}
+
+// Writes the pending batch, then with @p partial the one being filled as well. With @p send
+// each is sent to the reader first; returns the first send error.
+static int batches_flush(bool partial, bool send)
+{
+    int send_err = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        k_spinlock_key_t key = k_spin_lock(&lock);
+        if (!pending && partial && enc.count) {
+            batch_swap_locked();
+            partial = false;
+        }
+        const uint8_t *data = pending;
+        const size_t len = pending_len;
+        k_spin_unlock(&lock, key);
+
+        if (!data) {
+            break;
+        }
+        if (send && !send_err) {
+            send_err = batch_send(data, len);
+        }
+        const int err = batch_write(data, len);
+        if (err) {
+            LOG_WRN("History batch not written (err %d)", err);
+        }
+        key = k_spin_lock(&lock);
+        pending = NULL;
+        k_spin_unlock(&lock, key);
+    }
+    return send_err;
+}
+
+static int readout_cb(struct fcb_entry_ctx *ctx, void *arg)
+{
+    const size_t len = ctx->loc.fe_data_len;
+
+    // Anything else was not written by this module, or by another version of it
+    if (len < AOA_HISTORY_HEADER_SIZE || len > sizeof(read_buf) ||
+        flash_area_read(ctx->fap, FCB_ENTRY_FA_DATA_OFF(ctx->loc), read_buf, len)) {
+        return 0;
+    }
+    return batch_send(read_buf, len);
+}
+
+static void readout(void)
+{
+    uint8_t header[AOA_RECORD_HEADER_SIZE];
+    uint8_t end[AOA_HISTORY_HEADER_SIZE];
+    struct aoa_history_encoder end_enc;
+
+    batches_flush(true, false);
+
+    const int64_t start = k_uptime_get();
+    aoa_record_header_encode(header, sizeof(header));
+    int err = frame_send(header, sizeof(header));
+    if (!err) {
+        err = fcb_walk(&fcb, NULL, readout_cb, NULL);
+    }
+    if (!err) {
+        // A full log takes a while at UART speed; angles logged meanwhile follow it
+        err = batches_flush(true, true);
+    } else {
+        batches_flush(true, false);
+    }
+    if (!err) {
+        // A batch without angles ends the read-out
+        aoa_history_encoder_init(&end_enc, end, sizeof(end), boot, batch_flags());
+        err = batch_send(end, end_enc.len);
+    }
+    if (err) {
+        atomic_inc(&errors);
+        LOG_WRN("History read-out failed (err %d)", err);
+        return;
+    }
+    atomic_inc(&readouts);
+    LOG_INF("History read out in %lld ms", k_uptime_get() - start);
+}
+
+static int last_boot_cb(struct fcb_entry_ctx *ctx, void *arg)
+{
+    uint8_t header[AOA_HISTORY_HEADER_SIZE];
+    uint16_t *last = arg;
+
+    if (ctx->loc.fe_data_len >= sizeof(header) &&
+        !flash_area_read(ctx->fap, FCB_ENTRY_FA_DATA_OFF(ctx->loc), header, sizeof(header))) {
+        *last = header[2] | (uint16_t)header[3] << 8;
+    }
+    return 0;
+}
+
+static int log_open(void)
+{
+    const int id = DT_FIXED_PARTITION_ID(PARTITION_NODE);
+
+    // Sectors larger than the erase page, to keep the array small on a large flash
+    for (size_t i = 0; i < ARRAY_SIZE(sectors); i++) {
+        sectors[i].fs_off = i * CONFIG_AOA_RX_HISTORY_SECTOR_SIZE;
+        sectors[i].fs_size = CONFIG_AOA_RX_HISTORY_SECTOR_SIZE;
+    }
+    fcb.f_magic = HISTORY_MAGIC;
+    fcb.f_version = AOA_HISTORY_VERSION;
+    fcb.f_sector_cnt = ARRAY_SIZE(sectors);
+    fcb.f_scratch_cnt = 0;
+    fcb.f_sectors = sectors;
+    int err = fcb_init(id, &fcb);
+    if (err) {
+        // Not a log of this layout: start afresh
+        LOG_WRN("History log unreadable (err %d), erasing it", err);
+        const struct flash_area *fa;
+
+        err = flash_area_open(id, &fa);
+        if (!err) {
+            err = flash_area_erase(fa, 0, fa->fa_size);
+            flash_area_close(fa);
+        }
+        if (!err) {
+            err = fcb_init(id, &fcb);
+        }
+        if (err) {
+            return err;
+        }
+    }
+
+    // This boot's number follows the newest batch's; only its sector is read, if it has one
+    uint16_t last = 0;
+    fcb_walk(&fcb, fcb.f_active.fe_sector, last_boot_cb, &last);
+    if (!last && !fcb_is_empty(&fcb)) {
+        fcb_walk(&fcb, NULL, last_boot_cb, &last);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    boot = last + 1;
+    aoa_history_encoder_init(&enc, batch_bufs[0], CONFIG_AOA_RX_HISTORY_BATCH_SIZE, boot,
+                             batch_flags());
+    log_ready = true;
+    k_spin_unlock(&lock, key);
+    LOG_INF("History log open, boot %u", boot);
+    return 0;
+}
+
+static void history_thread(void *p1, void *p2, void *p3)
+{
+    int err = log_open();
+    if (err) {
+        LOG_ERR("History log not opened (err %d)", err);
+        return;
+    }
+
+    rx_next = 1;
+    if (!device_is_ready(uart) || uart_callback_set(uart, uart_cb, NULL) ||
+        uart_rx_enable(uart, rx_bufs[0], sizeof(rx_bufs[0]), SYS_FOREVER_US)) {
+        LOG_ERR("History UART %s unusable, logging without read-out", uart->name);
+    }
+
+    while (1) {
+        k_sem_take(&wake, K_SECONDS(CONFIG_AOA_RX_HISTORY_FLUSH_S));
+        if (atomic_clear(&readout_requested)) {
+            readout();
+            continue;
+        }
+
+        // A partial batch goes too once it is old enough
+        k_spinlock_key_t key = k_spin_lock(&lock);
+        const uint32_t age_ms = enc.count ? k_uptime_get_32() - batch_ms : 0;
+        k_spin_unlock(&lock, key);
+        batches_flush(age_ms >= CONFIG_AOA_RX_HISTORY_FLUSH_S * MSEC_PER_SEC, false);
+    }
+}
+
+K_THREAD_DEFINE(history_tid, CONFIG_AOA_RX_HISTORY_STACK_SIZE, history_thread, NULL, NULL, NULL,
+                K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+
+void history_stats_get(struct history_stats *stats)
+{
+    stats->angles = atomic_get(&angles);
+    stats->dropped = atomic_get(&dropped);
+    stats->batches = atomic_get(&batches);
+    stats->bytes = atomic_get(&bytes);
+    stats->erases = atomic_get(&erases);
+    stats->readouts = atomic_get(&readouts);
+    stats->errors = atomic_get(&errors);
+    stats->boot = boot;
+}
+
+void history_log_stats(void)
+{
+    struct history_stats stats;
+
+    history_stats_get(&stats);
+    LOG_INF("History: boot %u, %u angles (%u dropped), %u batches, %u bytes, %u erases, "
+            "%u read-outs, %u errors", stats.boot, stats.angles, stats.dropped, stats.batches,
+            stats.bytes, stats.erases, stats.readouts, stats.errors);
+}
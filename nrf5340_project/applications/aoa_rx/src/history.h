@@ -0,0 +1,48 @@
+#ifndef AOA_RX_HISTORY_H_
+#define AOA_RX_HISTORY_H_
+
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+#include "iq_report.h"
+
+/*
+ * Angle history in flash (CONFIG_AOA_RX_HISTORY): every angle is logged,
+ * delta encoded in batches (aoa/history.h), to a ring that keeps the
+ * latest hours, and sent back in one go when host/aoa_history asks.
+ */
+
+struct history_stats {
+    uint32_t angles;                    // Logged
+    uint32_t dropped;                   // Both batch buffers full, or the log not open
+    uint32_t batches;                   // Written to flash
+    uint32_t bytes;                     // Of batches written
+    uint32_t erases;                    // Sectors erased as the ring wrapped
+    uint32_t readouts;
+    uint32_t errors;                    // Flash writes or read-out frames that failed
+    uint16_t boot;
+};
+
+#if defined(CONFIG_AOA_RX_HISTORY)
+
+/** @brief Log the result's angle. Runs in the result handler and never waits for flash. */
+void history_result(const struct aoa_angle_result *result);
+
+void history_stats_get(struct history_stats *stats);
+
+void history_log_stats(void);
+
+#else
+
+static inline void history_result(const struct aoa_angle_result *result)
+{
+    ARG_UNUSED(result);
+}
+
+static inline void history_log_stats(void)
+{
+}
+
+#endif /* CONFIG_AOA_RX_HISTORY */
+
+#endif /* AOA_RX_HISTORY_H_ */
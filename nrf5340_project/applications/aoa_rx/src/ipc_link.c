@@ -0,0 +1,237 @@
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/mbox.h>
+#endif
+
+#include "ipc_link.h"
+#include "pool.h"
+#include "shm_ring.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+// Rings carry buffer pointers and can hold every buffer of their pool
+#define REPORT_RING_SLOTS NHPOT(AOA_RX_REPORT_POOL_SIZE)
+#define RESULT_RING_SLOTS NHPOT(AOA_RX_RESULT_POOL_SIZE)
+#define REPORT_RING_SIZE SHM_RING_SIZE(sizeof(uintptr_t), REPORT_RING_SLOTS)
+#define RESULT_RING_SIZE SHM_RING_SIZE(sizeof(uintptr_t), RESULT_RING_SLOTS)
+#define REPORT_BUF_SIZE (ROUND_UP(sizeof(struct aoa_iq_report), 4) * AOA_RX_REPORT_POOL_SIZE)
+#define RESULT_BUF_SIZE (ROUND_UP(sizeof(struct aoa_angle_result), 4) * AOA_RX_RESULT_POOL_SIZE)
+
+// Layout shared by both images: the four rings followed by the two pools
+#define OFF_REPORT_RING 0
+#define OFF_REPORT_RETURN (OFF_REPORT_RING + REPORT_RING_SIZE)
+#define OFF_RESULT_RING (OFF_REPORT_RETURN + REPORT_RING_SIZE)
+#define OFF_RESULT_RETURN (OFF_RESULT_RING + RESULT_RING_SIZE)
+#define OFF_REPORT_BUF (OFF_RESULT_RETURN + RESULT_RING_SIZE)
+#define OFF_RESULT_BUF (OFF_REPORT_BUF + REPORT_BUF_SIZE)
+#define LINK_MEM_SIZE (OFF_RESULT_BUF + RESULT_BUF_SIZE)
+
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+// Both images see the link memory at the same address in the aoa_shm region
+#define SHM_NODE DT_NODELABEL(aoa_shm)
+BUILD_ASSERT(DT_REG_SIZE(SHM_NODE) >= LINK_MEM_SIZE, "aoa_shm is too small for the configured pools");
+#define LINK_BASE ((uint8_t *)DT_REG_ADDR(SHM_NODE))
+
+static const struct mbox_dt_spec mbox_tx = MBOX_DT_SPEC_GET(DT_PATH(zephyr_user), tx);
+static const struct mbox_dt_spec mbox_rx = MBOX_DT_SPEC_GET(DT_PATH(zephyr_user), rx);
+#else
+static uint32_t link_mem[LINK_MEM_SIZE / sizeof(uint32_t)];
+#define LINK_BASE ((uint8_t *)link_mem)
+#endif
+
+static struct shm_ring *const report_ring = (struct shm_ring *)(LINK_BASE + OFF_REPORT_RING);
+static struct shm_ring *const result_ring = (struct shm_ring *)(LINK_BASE + OFF_RESULT_RING);
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+static struct shm_ring *const report_return = (struct shm_ring *)(LINK_BASE + OFF_REPORT_RETURN);
+static struct shm_ring *const result_return = (struct shm_ring *)(LINK_BASE + OFF_RESULT_RETURN);
+#endif
+
+// Each pool is only allocated from and freed into by the core that owns it
+static struct aoa_pool report_pool;
+static struct aoa_pool result_pool;
+
+static K_SEM_DEFINE(report_sem, 0, 1);
+static ipc_link_result_handler_t result_handler;
+
+static void ring_put(struct shm_ring *ring, const void *buf)
+{
+    uintptr_t *slot = shm_ring_claim(ring);
+
+    // Cannot fail: the ring has a slot for every buffer in the pool
+    __ASSERT_NO_MSG(slot);
+    *slot = (uintptr_t)buf;
+    shm_ring_commit(ring);
+}
+
+static void *ring_get(struct shm_ring *ring)
+{
+    uintptr_t *slot = shm_ring_peek(ring);
+    if (!slot) {
+        return NULL;
+    }
+
+    void *buf = (void *)*slot;
+    shm_ring_release(ring);
+    return buf;
+}
+
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+static void reclaim(struct shm_ring *ring, struct aoa_pool *pool)
+{
+    void *buf;
+
+    while ((buf = ring_get(ring)) != NULL) {
+        aoa_pool_free(pool, buf);
+    }
+}
+
+static void mbox_rx_cb(const struct device *dev, mbox_channel_id_t channel_id,
+                       void *user_data, struct mbox_msg *data)
+{
+    // Doorbell from the other core: new reports for the DSP, new results for the host
+    if (IS_ENABLED(CONFIG_AOA_RX_ROLE_DSP)) {
+        k_sem_give(&report_sem);
+    } else if (result_handler) {
+        result_handler();
+    }
+}
+#endif
+
+struct aoa_iq_report *ipc_link_report_alloc(void)
+{
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+    // Until the DSP core has formatted the rings there is nowhere to send to
+    if (!shm_ring_ready(report_ring)) {
+        return NULL;
+    }
+    reclaim(report_return, &report_pool);
+#endif
+    return aoa_pool_alloc(&report_pool);
+}
+
+void ipc_link_report_send(struct aoa_iq_report *report)
+{
+    ring_put(report_ring, report);
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+    mbox_send_dt(&mbox_tx, NULL);
+#else
+    k_sem_give(&report_sem);
+#endif
+}
+
+void ipc_link_report_stats(struct aoa_pool_stats *stats)
+{
+    aoa_pool_stats_get(&report_pool, stats);
+}
+
+void ipc_link_depth(uint32_t *reports, uint32_t *results)
+{
+    // Both rings live in the link memory, so either core can count them
+    const bool ready = shm_ring_ready(report_ring);
+
+    *reports = ready ? shm_ring_count(report_ring) : 0;
+    *results = ready ? shm_ring_count(result_ring) : 0;
+}
+
+void ipc_link_result_handler_set(ipc_link_result_handler_t handler)
+{
+    result_handler = handler;
+}
+
+struct aoa_angle_result *ipc_link_result_recv(void)
+{
+    return shm_ring_ready(result_ring) ? ring_get(result_ring) : NULL;
+}
+
+void ipc_link_result_free(struct aoa_angle_result *result)
+{
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+    ring_put(result_return, result);
+#else
+    aoa_pool_free(&result_pool, result);
+#endif
+}
+
+struct aoa_iq_report *ipc_link_report_recv(k_timeout_t timeout)
+{
+    struct aoa_iq_report *report = ring_get(report_ring);
+
+    if (!report && k_sem_take(&report_sem, timeout) == 0) {
+        report = ring_get(report_ring);
+    }
+    return report;
+}
+
+void ipc_link_report_free(struct aoa_iq_report *report)
+{
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+    ring_put(report_return, report);
+#else
+    aoa_pool_free(&report_pool, report);
+#endif
+}
+
+struct aoa_angle_result *ipc_link_result_alloc(void)
+{
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+    reclaim(result_return, &result_pool);
+#endif
+    return aoa_pool_alloc(&result_pool);
+}
+
+void ipc_link_result_send(struct aoa_angle_result *result)
+{
+    ring_put(result_ring, result);
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+    mbox_send_dt(&mbox_tx, NULL);
+#else
+    if (result_handler) {
+        result_handler();
+    }
+#endif
+}
+
+static int ipc_link_init(void)
+{
+    int err;
+
+    // The DSP side formats the rings; the host waits until they are ready
+    if (!IS_ENABLED(CONFIG_AOA_RX_ROLE_HOST)) {
+        shm_ring_init(report_ring, sizeof(uintptr_t), REPORT_RING_SLOTS);
+        shm_ring_init(result_ring, sizeof(uintptr_t), RESULT_RING_SLOTS);
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+        shm_ring_init(report_return, sizeof(uintptr_t), REPORT_RING_SLOTS);
+        shm_ring_init(result_return, sizeof(uintptr_t), RESULT_RING_SLOTS);
+#endif
+        err = aoa_pool_init(&result_pool, "result", LINK_BASE + OFF_RESULT_BUF,
+                            sizeof(struct aoa_angle_result), AOA_RX_RESULT_POOL_SIZE);
+        if (err) {
+            return err;
+        }
+    }
+
+    if (!IS_ENABLED(CONFIG_AOA_RX_ROLE_DSP)) {
+        err = aoa_pool_init(&report_pool, "iq_report", LINK_BASE + OFF_REPORT_BUF,
+                            sizeof(struct aoa_iq_report), AOA_RX_REPORT_POOL_SIZE);
+        if (err) {
+            return err;
+        }
+    }
+
+#if defined(CONFIG_AOA_RX_IPC_LINK_MBOX)
+    err = mbox_register_callback_dt(&mbox_rx, mbox_rx_cb, NULL);
+    if (!err) {
+        err = mbox_set_enabled_dt(&mbox_rx, true);
+    }
+    if (err) {
+        LOG_ERR("IPC link mbox setup failed (err %d)", err);
+        return err;
+    }
+#endif
+    return 0;
+}
+
+SYS_INIT(ipc_link_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,47 @@
+#ifndef AOA_RX_IPC_LINK_H_
+#define AOA_RX_IPC_LINK_H_
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#include "iq_report.h"
+#include "pool.h"
+
+/*
+ * IQ reports flow from the BLE host to the DSP and angle results flow back.
+ * Both come from fixed pools owned by their producer; the rings only carry
+ * buffer pointers. With CONFIG_AOA_RX_ROLE_FULL both ends run on this core
+ * in different threads and consumers free straight into the pool; so they
+ * do with CONFIG_AOA_RX_ROLE_THIN, where the forward thread drains reports. With the
+ * HOST/DSP roles the pools and rings sit in shared SRAM, each send rings
+ * the other core's mbox, and consumed buffers travel back to their owner
+ * on a return ring.
+ */
+
+/* Buffers per pool: every tag can have this many CTEs in flight */
+#define AOA_RX_REPORT_POOL_SIZE \
+    (CONFIG_AOA_RX_MAX_TAGS * CONFIG_AOA_RX_CTE_COUNT * CONFIG_AOA_RX_IQ_EVENTS_BUFFERED)
+#define AOA_RX_RESULT_POOL_SIZE CONFIG_AOA_RX_RESULT_POOL_SIZE
+
+typedef void (*ipc_link_result_handler_t)(void);
+
+/* Host side */
+struct aoa_iq_report *ipc_link_report_alloc(void);
+void ipc_link_report_send(struct aoa_iq_report *report);
+void ipc_link_result_handler_set(ipc_link_result_handler_t handler);
+struct aoa_angle_result *ipc_link_result_recv(void);
+void ipc_link_result_free(struct aoa_angle_result *result);
+
+/** @brief Report pool usage; reports in use are waiting for or inside the estimator. */
+void ipc_link_report_stats(struct aoa_pool_stats *stats);
+
+/** @brief Reports waiting on the report ring and results waiting on the result ring. */
+void ipc_link_depth(uint32_t *reports, uint32_t *results);
+
+/* DSP side */
+struct aoa_iq_report *ipc_link_report_recv(k_timeout_t timeout);
+void ipc_link_report_free(struct aoa_iq_report *report);
+struct aoa_angle_result *ipc_link_result_alloc(void);
+void ipc_link_result_send(struct aoa_angle_result *result);
+
+#endif /* AOA_RX_IPC_LINK_H_ */
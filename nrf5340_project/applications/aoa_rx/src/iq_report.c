@@ -0,0 +1,77 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/direction.h>
+
+#include "iq_report.h"
+
+static inline struct aoa_iq_sample sample_get(enum bt_df_iq_sample type,
+                                              const struct bt_hci_le_iq_sample *s8,
+                                              const struct bt_hci_le_iq_sample16 *s16, int n)
+{
+    if (type == BT_DF_IQ_SAMPLE_16_BITS_INT) {
+        return (struct aoa_iq_sample){ s16[n].i, s16[n].q };
+    }
+    return (struct aoa_iq_sample){ s8[n].i, s8[n].q };
+}
+
+/*
+ * Front end: copy the reference period as is and average the
+ * AOA_SLOT_SAMPLES samples the controller takes in each sample slot into
+ * one. Samples in a slot sit symmetrically around its middle, so the
+ * average keeps the phase at the middle of the slot, where the estimators
+ * place every sample, and cuts the noise by the square root of the count.
+ * A trailing partial slot is dropped.
+ */
+static uint8_t samples_copy(struct aoa_iq_sample *dst, enum bt_df_iq_sample type,
+                            const struct bt_hci_le_iq_sample *s8,
+                            const struct bt_hci_le_iq_sample16 *s16, uint8_t count)
+{
+    const int ref = MIN(count, AOA_REF_SAMPLES);
+    for (int n = 0; n < ref; n++) {
+        dst[n] = sample_get(type, s8, s16, n);
+    }
+
+    const int slots = MIN((count - ref) / AOA_SLOT_SAMPLES, AOA_IQ_SAMPLES_MAX - AOA_REF_SAMPLES);
+    for (int k = 0; k < slots; k++) {
+        const int first = ref + k * AOA_SLOT_SAMPLES;
+        int32_t i = 0;
+        int32_t q = 0;
+
+        for (int n = first; n < first + AOA_SLOT_SAMPLES; n++) {
+            const struct aoa_iq_sample s = sample_get(type, s8, s16, n);
+            i += s.i;
+            q += s.q;
+        }
+        dst[ref + k] = (struct aoa_iq_sample){ i / AOA_SLOT_SAMPLES, q / AOA_SLOT_SAMPLES };
+    }
+    return ref + slots;
+}
+
+void iq_report_from_per_adv(struct aoa_iq_report *dst, uint8_t tag_id,
+                            const struct bt_df_per_adv_sync_iq_samples_report *src)
+{
+    dst->timestamp = k_cycle_get_32();
+    dst->event_counter = src->per_evt_counter;
+    dst->rssi = src->rssi;
+    dst->source = AOA_IQ_SOURCE_PER_ADV;
+    dst->tag_id = tag_id;
+    dst->chan_idx = src->chan_idx;
+    dst->slot_durations = src->slot_durations;
+    dst->packet_status = src->packet_status;
+    dst->sample_count = samples_copy(dst->samples, src->sample_type, src->sample,
+                                     src->sample16, src->sample_count);
+}
+
+void iq_report_from_conn(struct aoa_iq_report *dst, uint8_t tag_id,
+                         const struct bt_df_conn_iq_samples_report *src)
+{
+    dst->timestamp = k_cycle_get_32();
+    dst->event_counter = src->conn_evt_counter;
+    dst->rssi = src->rssi;
+    dst->source = AOA_IQ_SOURCE_CONN;
+    dst->tag_id = tag_id;
+    dst->chan_idx = src->chan_idx;
+    dst->slot_durations = src->slot_durations;
+    dst->packet_status = src->packet_status;
+    dst->sample_count = samples_copy(dst->samples, src->sample_type, src->sample,
+                                     src->sample16, src->sample_count);
+}
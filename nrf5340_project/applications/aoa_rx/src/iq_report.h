@@ -0,0 +1,17 @@
+#ifndef AOA_RX_IQ_REPORT_H_
+#define AOA_RX_IQ_REPORT_H_
+
+#include <stdint.h>
+
+#include <aoa/report.h>
+
+struct bt_df_per_adv_sync_iq_samples_report;
+struct bt_df_conn_iq_samples_report;
+
+void iq_report_from_per_adv(struct aoa_iq_report *dst, uint8_t tag_id,
+                            const struct bt_df_per_adv_sync_iq_samples_report *src);
+
+void iq_report_from_conn(struct aoa_iq_report *dst, uint8_t tag_id,
+                         const struct bt_df_conn_iq_samples_report *src);
+
+#endif /* AOA_RX_IQ_REPORT_H_ */
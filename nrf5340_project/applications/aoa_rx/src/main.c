@@ -4,20 +4,26 @@
 #include <zephyr/bluetooth/direction.h>
 #include <zephyr/sys/printk.h>
 #include <zephyr/logging/log.h>
+#include <stdlib.h>
 #include <string.h>
-// #include <math.h> // Uncomment if using math functions like M_PI
 
-LOG_MODULE_REGISTER(aoa_rx, LOG_LEVEL_DBG);
-
-static struct bt_le_per_adv_sync *per_adv_sync;
+#include "antenna.h"
+#include "aoa_rx.h"
+#include "conn_cte.h"
+#include "duty.h"
+#include "forward.h"
+#include "history.h"
+#include "ipc_link.h"
+#include "past.h"
+#include "pool.h"
+#include "quality.h"
+#include "resync.h"
+#include "sched.h"
+#include "stats.h"
+#include "tag.h"
+#include "warm.h"
 
-// --- Angle estimation function (commented out due to M_PI error) ---
-// static float estimate_angle(float delta_phase) {
-//     float angle;
-//     // angle = delta_phase * (180.0f / M_PI); // Convert to degrees
-//     // return angle;
-//     return 0.0f;
-// }
+LOG_MODULE_REGISTER(aoa_rx, LOG_LEVEL_DBG);
 
 // --- Encryption function (commented out due to struct errors) ---
 // static int encrypt_angle(float angle, uint8_t *out_buf, size_t out_buf_len) {
@@ -33,54 +39,136 @@ static struct bt_le_per_adv_sync *per_adv_sync;
 //     return -ENOTSUP;
 // }
 
-// --- CTE IQ report callback (commented out due to undefined types) ---
-// static void cte_report_cb(struct bt_le_per_adv_sync *sync,
-//                           const struct bt_df_per_adv_sync_iq_samples_report *report)
-// {
-//     // Example: process IQ samples
-//     // for (int i = 0; i < report->sample_count; ++i) {
-//     //     buf.i[i] = report->sample[i].i;
-//     //     buf.q[i] = report->sample[i].q;
-//     // }
-//     // float angle = estimate_angle(...);
-//     // LOG_INF("Estimated AoA: %.2f degrees", angle);
-// }
+// Runs in the BT RX thread: copy the samples into the ring and let the DSP side estimate
+static void cte_report_cb(struct bt_le_per_adv_sync *sync,
+                          const struct bt_df_per_adv_sync_iq_samples_report *report)
+{
+    struct aoa_tag *tag = tag_find_sync(sync);
+    if (!tag) {
+        return;
+    }
+    tag->last_report = k_uptime_get_32();
+    stats_cte(tag, report->per_evt_counter);
+
+    // Dropped if the report pool is exhausted; the pool counts the failure
+    struct aoa_iq_report *dst = ipc_link_report_alloc();
+    if (dst) {
+        iq_report_from_per_adv(dst, tag->id, report);
+        dst->priority = tag->priority;
+        dst->generation = tag->generation;
+        ipc_link_report_send(dst);
+    }
+
+    duty_report(tag);
+}
+
+static void result_work_handler(struct k_work *work)
+{
+    struct aoa_angle_result *result;
+
+    while ((result = ipc_link_result_recv()) != NULL) {
+        int deci_deg = (int)(result->azimuth * 10.0f);
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+        int deci_el = (int)(result->elevation * 10.0f);
+        printk("Tag %u: AoA %d.%d deg, elevation %d.%d deg (quality %u%%)\n", result->tag_id,
+               deci_deg / 10, abs(deci_deg % 10), deci_el / 10, abs(deci_el % 10),
+               (unsigned int)(result->quality * 100.0f));
+#else
+        printk("Tag %u: AoA %d.%d deg (quality %u%%)\n", result->tag_id,
+               deci_deg / 10, abs(deci_deg % 10), (unsigned int)(result->quality * 100.0f));
+#endif
+        duty_result(result);
+        warm_result(result);
+        history_result(result);
+        ipc_link_result_free(result);
+    }
+}
+
+static K_WORK_DEFINE(result_work, result_work_handler);
+
+static void result_ready(void)
+{
+    k_work_submit(&result_work);
+}
 
 static void sync_cb(struct bt_le_per_adv_sync *sync,
                     struct bt_le_per_adv_sync_synced_info *info)
 {
-    printk("Synced to periodic advertiser\n");
+    struct aoa_tag *tag = tag_find_sync(sync);
+    if (!tag) {
+        tag = resync_synced(sync, info->addr, info->sid);
+    }
+    if (!tag) {
+        tag = past_synced(sync, info);
+    }
+    if (!tag) {
+        bt_le_per_adv_sync_delete(sync);
+        resync_kick();
+        return;
+    }
+    printk("Synced to periodic advertiser (tag %u)\n", tag->id);
+
+    tag->state = AOA_TAG_SYNCED;
+    tag->interval = info->interval;
+    tag->synced_at = k_uptime_get_32();
+    tag->last_report = tag->synced_at;
+    warm_synced(tag);
 
     struct bt_df_per_adv_sync_cte_rx_param cte_rx_param = {
-        .cte_types = BT_DF_CTE_TYPE_AOA,
-        .slot_durations = BT_DF_ANTENNA_SWITCHING_SLOT_1US,
-        .max_cte_count = 0,
-        .num_ant_ids = 0,
-        .ant_ids = NULL,
+        .cte_types = AOA_CTE_TYPE,
+        .slot_durations = AOA_SLOT_DURATION,
+        .max_cte_count = CONFIG_AOA_RX_CTE_COUNT, // The report pool is sized for this many
+        .num_ant_ids = AOA_RX_ANT_IDS_COUNT,
+        .ant_ids = AOA_RX_ANT_IDS,
     };
     int err = bt_df_per_adv_sync_cte_rx_enable(sync, &cte_rx_param);
     printk("CTE RX enable: %d\n", err);
+
+    // The sync create slot is free again
+    resync_kick();
+
+    // Keep scanning while more tags fit or any sync is still being established
+    if (!tag_available() && !tag_establishing()) {
+        bt_le_scan_stop();
+    }
+    past_update();
 }
 
 static void term_cb(struct bt_le_per_adv_sync *sync,
                     const struct bt_le_per_adv_sync_term_info *info)
 {
     printk("Sync terminated (reason: %d)\n", info->reason);
+
+    // Lost syncs are reacquired from the cached address and SID; a tag that
+    // never synced is dropped and rediscovered by scanning
+    if (!resync_terminated(sync)) {
+        struct aoa_tag *tag = tag_find_sync(sync);
+        if (tag && tag->state == AOA_TAG_SYNCED) {
+            resync_start(tag);
+        } else if (tag) {
+            tag_free(tag);
+        }
+    }
+
+    // Both need the scanner: the controller only establishes syncs while scanning
+    resync_kick();
+    aoa_rx_scan_start();
+    past_update();
 }
 
 static void recv_cb(struct bt_le_per_adv_sync *sync,
                     const struct bt_le_per_adv_sync_recv_info *info,
                     struct net_buf_simple *buf)
 {
-    printk("Received periodic advertising data (len=%u)\n", buf->len);
-    // If your SDK delivers CTE IQ samples here, parse them in this callback.
+    // Counted rather than printed: a console line per packet costs more than its CTE report
+    stats_adv(tag_find_sync(sync));
 }
 
 static struct bt_le_per_adv_sync_cb per_adv_sync_cbs = {
     .synced = sync_cb,
     .term = term_cb,
     .recv = recv_cb,
-    // .cte_report = cte_report_cb, // Commented out: not available in this SDK
+    .cte_report_cb = cte_report_cb,
 };
 
 static bool ad_parse_cb(struct bt_data *data, void *user_data)
@@ -95,42 +183,110 @@ static bool ad_parse_cb(struct bt_data *data, void *user_data)
     return true; // Continue parsing
 }
 
-static void scan_cb(const bt_addr_le_t *addr, int8_t rssi, uint8_t type, struct net_buf_simple *ad)
+static void scan_recv(const struct bt_le_scan_recv_info *info, struct net_buf_simple *ad)
 {
     char dev_name[32] = {0};
+    struct net_buf_simple_state state;
+
+    // Parsing consumes the buffer; PAST parses it again for the other locator's load
+    net_buf_simple_save(ad, &state);
     bt_data_parse(ad, ad_parse_cb, dev_name);
-    if (strcmp(dev_name, "AoA_TX_Sim") == 0) {
-        printk("Found AoA_TX_Sim, creating sync...\n");
-        struct bt_le_per_adv_sync_param sync_create_param = {
-            .addr = *addr,
-            .sid = 0,
-            .skip = 0,
-            .timeout = 400,
-            .options = 0,
-        };
-        int err = bt_le_per_adv_sync_create(&sync_create_param, &per_adv_sync);
-        printk("Sync create: %d\n", err);
+    net_buf_simple_restore(ad, &state);
+    if (past_scan_recv(info, dev_name, ad)) {
+        return;
+    }
+    if (strcmp(dev_name, AOA_TAG_NAME) != 0 || tag_find_addr(info->addr, info->sid)) {
+        return;
+    }
+
+#if defined(CONFIG_AOA_RX_CONN_CTE)
+    // Tags that advertise connectable ask to be tracked over a connection
+    if (info->adv_props & BT_GAP_ADV_PROP_CONNECTABLE) {
+        if (!conn_cte_slot_available()) {
+            return;
+        }
+        printk("Found connectable %s, connecting...\n", AOA_TAG_NAME);
         bt_le_scan_stop();
+        int err = conn_cte_connect(info->addr, info->sid);
+        printk("Connection create: %d\n", err);
+        if (err) {
+            aoa_rx_scan_start();
+        }
+        return;
+    }
+#endif
+
+    if (info->interval == 0) {
+        return;
+    }
+
+    struct aoa_tag *tag = tag_alloc(info->addr, info->sid, AOA_IQ_SOURCE_PER_ADV);
+    if (!tag) {
+        return;
     }
+    tag->interval = info->interval;
+
+    printk("Found %s, creating sync...\n", AOA_TAG_NAME);
+    struct bt_le_per_adv_sync_param sync_create_param = {
+        .addr = *info->addr,
+        .sid = info->sid,
+        .skip = 0,
+        .timeout = resync_sync_timeout(tag, 0),
+        .options = 0,
+    };
+    // Scanning stays on until sync_cb: the controller needs it to establish the sync
+    int err = bt_le_per_adv_sync_create(&sync_create_param, &tag->sync);
+    printk("Sync create: %d\n", err);
+    if (err) {
+        // Typically -EBUSY while another sync is being established
+        tag_free(tag);
+    }
+}
+
+static struct bt_le_scan_cb scan_callbacks = {
+    .recv = scan_recv,
+};
+
+int aoa_rx_scan_start(void)
+{
+    int err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, NULL);
+    return err == -EALREADY ? 0 : err;
 }
 
 // Use 'int main(void)' for Zephyr simulation builds
 int main(void)
 {
+    ipc_link_result_handler_set(result_ready);
+
     int err = bt_enable(NULL);
     if (err) {
         printk("Bluetooth init failed (err %d)\n", err);
         return -1;
     }
     bt_le_per_adv_sync_cb_register(&per_adv_sync_cbs);
-    err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, scan_cb);
+    err = past_init();
+    if (err) {
+        printk("Sync transfer subscribe failed (err %d)\n", err);
+    }
+    bt_le_scan_cb_register(&scan_callbacks);
+    // Tags tracked before the reset resync from the list while the scanner looks for new ones
+    warm_restore();
+    err = aoa_rx_scan_start();
     if (err) {
         printk("Scan start failed (err %d)\n", err);
         return -1;
     }
-    printk("Scanning for AoA_TX_Sim...\n");
+    printk("Scanning for %s...\n", AOA_TAG_NAME);
     while (1) {
-        k_sleep(K_SECONDS(1));
+        k_sleep(K_SECONDS(CONFIG_AOA_RX_STATS_INTERVAL));
+        aoa_pool_log_all();
+        resync_log_stats();
+        duty_log_stats();
+        quality_log_stats();
+        sched_log_stats();
+        forward_log_stats();
+        warm_log_stats();
+        history_log_stats();
     }
     return 0;
 }
@@ -0,0 +1,23 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/logging/log.h>
+
+#include "pool.h"
+#include "quality.h"
+#include "sched.h"
+
+LOG_MODULE_REGISTER(aoa_rx, LOG_LEVEL_DBG);
+
+// DSP role: the BLE host runs on the other core and feeds the IQ ring.
+// The estimator thread in dsp.c starts on its own; this only reports statistics.
+int main(void)
+{
+    printk("AoA DSP core ready, waiting for IQ reports\n");
+    while (1) {
+        k_sleep(K_SECONDS(CONFIG_AOA_RX_STATS_INTERVAL));
+        aoa_pool_log_all();
+        quality_log_stats();
+        sched_log_stats();
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+#include "aoa_rx.h"
+#include "iq_report.h"
+#include "past.h"
+#include "resync.h"
+#include "tag.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+// Manufacturer data advertising our load: company ID, synced tags, longest interval
+#define LOAD_COMPANY_ID 0x0059 // Nordic Semiconductor
+#define LOAD_LEN        5
+
+struct load {
+    uint8_t synced;
+    uint16_t interval;                  // 1.25 ms units
+};
+
+static uint8_t load_data[LOAD_LEN];
+
+static const struct bt_data ad[] = {
+    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+    BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+    BT_DATA(BT_DATA_MANUFACTURER_DATA, load_data, LOAD_LEN),
+};
+
+// Connection to the locator we take syncs from, and when we last asked for them
+static struct bt_conn *donor_conn;
+static int64_t last_request;
+static bool advertising;
+
+static void donor_disconnect(struct k_work *work)
+{
+    if (donor_conn) {
+        bt_conn_disconnect(donor_conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(donor_work, donor_disconnect);
+
+static struct load load_get(void)
+{
+    struct load load = {0};
+
+    for (uint8_t id = 0; id < CONFIG_AOA_RX_MAX_TAGS; id++) {
+        struct aoa_tag *tag = tag_get(id);
+        if (tag && tag->source == AOA_IQ_SOURCE_PER_ADV && tag->state == AOA_TAG_SYNCED) {
+            load.synced++;
+            load.interval = MAX(load.interval, tag->interval);
+        }
+    }
+    return load;
+}
+
+static bool load_parse(struct bt_data *data, void *user_data)
+{
+    struct load *load = user_data;
+
+    if (data->type == BT_DATA_MANUFACTURER_DATA && data->data_len == LOAD_LEN &&
+        sys_get_le16(data->data) == LOAD_COMPANY_ID) {
+        load->synced = data->data[2];
+        load->interval = sys_get_le16(&data->data[3]);
+        return false;
+    }
+    return true;
+}
+
+// Transfers carry no timeout of their own, so the subscription sets one for the
+// syncs about to arrive, counted like a scanned tag's from the longest interval
+static int transfer_subscribe(uint16_t interval)
+{
+    const struct aoa_tag donor_tag = {
+        .interval = interval,
+    };
+    const struct bt_le_per_adv_sync_transfer_param param = {
+        .skip = 0,
+        .timeout = resync_sync_timeout(&donor_tag, 0),
+        .options = BT_LE_PER_ADV_SYNC_TRANSFER_OPT_NONE,
+    };
+
+    // Subscribing without a connection applies to every later connection, so no
+    // transfer can arrive before the subscription
+    return bt_le_per_adv_sync_transfer_subscribe(NULL, &param);
+}
+
+int past_init(void)
+{
+    // Until a locator advertises its intervals, allow for the longest one
+    return transfer_subscribe(BT_GAP_PER_ADV_MAX_INTERVAL);
+}
+
+bool past_scan_recv(const struct bt_le_scan_recv_info *info, const char *name,
+                    struct net_buf_simple *ad)
+{
+    struct load theirs = {0};
+
+    if (strcmp(name, CONFIG_BT_DEVICE_NAME) != 0) {
+        return false;
+    }
+    if (!(info->adv_props & BT_GAP_ADV_PROP_CONNECTABLE) || donor_conn) {
+        return true;
+    }
+
+    // Only a locator tracking fewer tags than the other asks, and not more often than the
+    // retry period; syncs it already holds are turned down as they arrive
+    bt_data_parse(ad, load_parse, &theirs);
+    if (theirs.synced <= load_get().synced || !tag_available() ||
+        (last_request && k_uptime_get() - last_request < CONFIG_AOA_RX_PAST_RETRY_S * MSEC_PER_SEC)) {
+        return true;
+    }
+    last_request = k_uptime_get();
+
+    int err = transfer_subscribe(theirs.interval);
+    if (err) {
+        LOG_WRN("Sync transfer subscribe failed (err %d)", err);
+        return true;
+    }
+
+    LOG_INF("Found a locator tracking %u tag(s), asking for its syncs", theirs.synced);
+    bt_le_scan_stop();
+    err = bt_conn_le_create(info->addr, BT_CONN_LE_CREATE_CONN, BT_LE_CONN_PARAM_DEFAULT,
+                                &donor_conn);
+    if (err) {
+        LOG_WRN("Locator connection failed (err %d)", err);
+        donor_conn = NULL;
+        aoa_rx_scan_start();
+    }
+    return true;
+}
+
+struct aoa_tag *past_synced(struct bt_le_per_adv_sync *sync,
+                            const struct bt_le_per_adv_sync_synced_info *info)
+{
+    if (!info->conn || tag_find_addr(info->addr, info->sid)) {
+        return NULL;
+    }
+
+    struct aoa_tag *tag = tag_alloc(info->addr, info->sid, AOA_IQ_SOURCE_PER_ADV);
+    if (!tag) {
+        return NULL;
+    }
+    tag->sync = sync;
+
+    LOG_INF("Tag %u: sync received from another locator", tag->id);
+    return tag;
+}
+
+void past_update(void)
+{
+    const struct load load = load_get();
+    const bool wanted = load.synced > 0;
+
+    sys_put_le16(LOAD_COMPANY_ID, &load_data[0]);
+    load_data[2] = load.synced;
+    sys_put_le16(load.interval, &load_data[3]);
+
+    if (wanted && advertising) {
+        bt_le_adv_update_data(ad, ARRAY_SIZE(ad), NULL, 0);
+    } else if (wanted) {
+        int err = bt_le_adv_start(BT_LE_ADV_PARAM(BT_LE_ADV_OPT_CONN, BT_GAP_ADV_SLOW_INT_MIN,
+                                                  BT_GAP_ADV_SLOW_INT_MAX, NULL),
+                                  ad, ARRAY_SIZE(ad), NULL, 0);
+        advertising = (err == 0 || err == -EALREADY);
+    } else if (!wanted && advertising) {
+        bt_le_adv_stop();
+        advertising = false;
+    }
+}
+
+// Another locator connected to our advertising: hand it every sync we hold
+static void syncs_transfer(struct bt_conn *conn)
+{
+    unsigned int sent = 0;
+
+    for (uint8_t id = 0; id < CONFIG_AOA_RX_MAX_TAGS; id++) {
+        struct aoa_tag *tag = tag_get(id);
+        if (!tag || tag->source != AOA_IQ_SOURCE_PER_ADV || tag->state != AOA_TAG_SYNCED) {
+            continue;
+        }
+        int err = bt_le_per_adv_sync_transfer(tag->sync, conn, tag->id);
+        if (err) {
+            LOG_WRN("Tag %u: sync transfer failed (err %d)", tag->id, err);
+            continue;
+        }
+        sent++;
+    }
+    LOG_INF("Transferred %u sync(s) to another locator", sent);
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    struct bt_conn_info info;
+
+    if (conn == donor_conn) {
+        if (err) {
+            bt_conn_unref(donor_conn);
+            donor_conn = NULL;
+        } else {
+            // Transfers arrive as sync callbacks; the link is only needed until then
+            k_work_reschedule(&donor_work, K_MSEC(CONFIG_AOA_RX_PAST_WINDOW_MS));
+        }
+        aoa_rx_scan_start();
+        return;
+    }
+
+    // Tags are connected as central, so a peripheral link comes from our advertising
+    if (err || bt_conn_get_info(conn, &info) || info.role != BT_CONN_ROLE_PERIPHERAL) {
+        return;
+    }
+    advertising = false; // Connectable advertising stops once connected
+    syncs_transfer(conn);
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    if (conn == donor_conn) {
+        k_work_cancel_delayable(&donor_work);
+        bt_conn_unref(donor_conn);
+        donor_conn = NULL;
+        aoa_rx_scan_start();
+    }
+}
+
+static void recycled(void)
+{
+    past_update();
+}
+
+BT_CONN_CB_DEFINE(past_conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .recycled = recycled,
+};
@@ -0,0 +1,73 @@
+#ifndef AOA_RX_PAST_H_
+#define AOA_RX_PAST_H_
+
+#include <stdbool.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+#include "tag.h"
+
+/*
+ * Periodic Advertising Sync Transfer between locators. A locator that
+ * tracks tags advertises connectable under CONFIG_BT_DEVICE_NAME, with
+ * how many it tracks, and transfers every sync it holds to any locator
+ * that connects. A locator that hears one tracking more tags than itself
+ * connects and takes over the syncs it lacks without scanning for the
+ * tags themselves.
+ *
+ * Everything here runs in the Bluetooth RX thread.
+ */
+
+#if defined(CONFIG_AOA_RX_PAST)
+
+/** @brief Subscribe to transfers on all connections. Call after bt_enable(). */
+int past_init(void);
+
+/**
+ * @brief Handle a scanned advertisement that may come from another locator.
+ *
+ * @param ad The advertising data @p name was parsed from, to read the other
+ *           locator's load from.
+ *
+ * @return true if @p name is a locator's, whether or not a connection was made.
+ */
+bool past_scan_recv(const struct bt_le_scan_recv_info *info, const char *name,
+                    struct net_buf_simple *ad);
+
+/**
+ * @brief Claim a sync that arrived by transfer.
+ *
+ * @return A new tag for the sync, or NULL if it did not arrive by
+ *         transfer, the tag is already tracked or no tag slot is free.
+ */
+struct aoa_tag *past_synced(struct bt_le_per_adv_sync *sync,
+                            const struct bt_le_per_adv_sync_synced_info *info);
+
+/** @brief Advertise to other locators while any tag is synced. */
+void past_update(void);
+
+#else
+
+static inline int past_init(void)
+{
+    return 0;
+}
+
+static inline bool past_scan_recv(const struct bt_le_scan_recv_info *info, const char *name,
+                                  struct net_buf_simple *ad)
+{
+    return false;
+}
+
+static inline struct aoa_tag *past_synced(struct bt_le_per_adv_sync *sync,
+                                          const struct bt_le_per_adv_sync_synced_info *info)
+{
+    return NULL;
+}
+
+static inline void past_update(void)
+{
+}
+
+#endif /* CONFIG_AOA_RX_PAST */
+
+#endif /* AOA_RX_PAST_H_ */
@@ -0,0 +1,105 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/logging/log.h>
+
+#include "pool.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+// Report, result and tag pools
+#define AOA_POOL_MAX 4
+
+static struct aoa_pool *pools[AOA_POOL_MAX];
+static atomic_t pool_count;
+
+int aoa_pool_init(struct aoa_pool *pool, const char *name, void *buffer,
+                  size_t block_size, uint32_t count)
+{
+    block_size = ROUND_UP(block_size, 4);
+
+    int err = k_mem_slab_init(&pool->slab, buffer, block_size, count);
+    if (err) {
+        return err;
+    }
+
+    pool->name = name;
+    pool->buffer = buffer;
+    pool->block_size = block_size;
+    pool->capacity = count;
+    atomic_clear(&pool->used);
+    atomic_clear(&pool->peak);
+    atomic_clear(&pool->failures);
+
+    atomic_val_t slot = atomic_inc(&pool_count);
+    if (slot < AOA_POOL_MAX) {
+        pools[slot] = pool;
+    }
+    return 0;
+}
+
+void *aoa_pool_alloc(struct aoa_pool *pool)
+{
+    void *block;
+
+    if (k_mem_slab_alloc(&pool->slab, &block, K_NO_WAIT)) {
+        atomic_inc(&pool->failures);
+        return NULL;
+    }
+
+    atomic_val_t used = atomic_inc(&pool->used) + 1;
+    atomic_val_t peak = atomic_get(&pool->peak);
+    while (used > peak && !atomic_cas(&pool->peak, peak, used)) {
+        peak = atomic_get(&pool->peak);
+    }
+    return block;
+}
+
+void aoa_pool_free(struct aoa_pool *pool, void *block)
+{
+    atomic_dec(&pool->used);
+    k_mem_slab_free(&pool->slab, block);
+}
+
+uint32_t aoa_pool_index(const struct aoa_pool *pool, const void *block)
+{
+    return ((const uint8_t *)block - pool->buffer) / pool->block_size;
+}
+
+void *aoa_pool_block(const struct aoa_pool *pool, uint32_t index)
+{
+    return &pool->buffer[index * pool->block_size];
+}
+
+void aoa_pool_stats_get(const struct aoa_pool *pool, struct aoa_pool_stats *stats)
+{
+    stats->name = pool->name;
+    stats->capacity = pool->capacity;
+    stats->used = atomic_get(&pool->used);
+    stats->peak = atomic_get(&pool->peak);
+    stats->failures = atomic_get(&pool->failures);
+}
+
+void aoa_pool_foreach(void (*cb)(const struct aoa_pool_stats *stats, void *user_data),
+                      void *user_data)
+{
+    atomic_val_t count = MIN(atomic_get(&pool_count), AOA_POOL_MAX);
+
+    for (atomic_val_t i = 0; i < count; i++) {
+        struct aoa_pool_stats stats;
+
+        aoa_pool_stats_get(pools[i], &stats);
+        cb(&stats, user_data);
+    }
+}
+
+static void pool_stats_log(const struct aoa_pool_stats *stats, void *user_data)
+{
+    LOG_INF("Pool %s: %u/%u used, peak %u, alloc failures %u", stats->name, stats->used,
+            stats->capacity, stats->peak, stats->failures);
+}
+
+void aoa_pool_log_all(void)
+{
+    aoa_pool_foreach(pool_stats_log, NULL);
+}
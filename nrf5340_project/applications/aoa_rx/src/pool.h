@@ -0,0 +1,65 @@
+#ifndef AOA_RX_POOL_H_
+#define AOA_RX_POOL_H_
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+/*
+ * Fixed-block pool: a k_mem_slab plus usage counters. Every buffer on the
+ * report path comes from one of these, so RAM use is fixed at build time
+ * and the high-watermarks show how much of it is actually needed.
+ */
+struct aoa_pool {
+    struct k_mem_slab slab;
+    const char *name;
+    uint8_t *buffer;
+    size_t block_size;
+    uint32_t capacity;
+    atomic_t used;
+    atomic_t peak;
+    atomic_t failures;
+};
+
+struct aoa_pool_stats {
+    const char *name;
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t peak;
+    uint32_t failures;
+};
+
+/* Static backing store for a pool of @p count blocks of @p block_size bytes */
+#define AOA_POOL_BUF_DEFINE(name, block_size, count) \
+    static uint8_t __aligned(4) name[ROUND_UP(block_size, 4) * (count)]
+
+/**
+ * @brief Set up a pool over @p buffer and register it for statistics.
+ *
+ * @p buffer may be a static AOA_POOL_BUF_DEFINE() array or any other
+ * memory of the same size, such as a shared SRAM region.
+ */
+int aoa_pool_init(struct aoa_pool *pool, const char *name, void *buffer,
+                  size_t block_size, uint32_t count);
+
+/** @brief Take a block without waiting; NULL (and a failure count) if empty. */
+void *aoa_pool_alloc(struct aoa_pool *pool);
+
+void aoa_pool_free(struct aoa_pool *pool, void *block);
+
+/** @brief Stable index of @p block within its pool, 0..capacity-1. */
+uint32_t aoa_pool_index(const struct aoa_pool *pool, const void *block);
+
+/** @brief Block at @p index, as returned by aoa_pool_index(). */
+void *aoa_pool_block(const struct aoa_pool *pool, uint32_t index);
+
+void aoa_pool_stats_get(const struct aoa_pool *pool, struct aoa_pool_stats *stats);
+
+/** @brief Call @p cb for every registered pool. */
+void aoa_pool_foreach(void (*cb)(const struct aoa_pool_stats *stats, void *user_data),
+                      void *user_data);
+
+/** @brief Log the statistics of every registered pool. */
+void aoa_pool_log_all(void);
+
+#endif /* AOA_RX_POOL_H_ */
@@ -0,0 +1,34 @@
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/timing/timing.h>
+
+#include <aoa/simd.h>
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+static uint64_t cycles_now(void)
+{
+    return timing_counter_get();
+}
+
+// Before any report reaches the kernels
+static int q15_selftest(void)
+{
+    struct aoa_q15_timing timing;
+
+    timing_init();
+    timing_start();
+    const int err = aoa_q15_check(cycles_now, &timing);
+    timing_stop();
+
+    if (err) {
+        LOG_ERR("Q15 kernels differ from plain C");
+        return 0;
+    }
+    LOG_INF("Q15 kernels (%s) bit-exact: %u cycles, plain C %u",
+            timing.dsp ? "DSP extension" : "portable", (uint32_t)timing.kernels,
+            (uint32_t)timing.reference);
+    return 0;
+}
+
+SYS_INIT(q15_selftest, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,160 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+
+#include <aoa/dsp.h>
+
+#include "quality.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+// BT_DF_CTE_CRC_OK; the DSP image is built without the Bluetooth headers
+#define PACKET_STATUS_CRC_OK 0
+
+// Reference samples are narrowed to this many bits so the coherence test fits 64 bits
+#define REF_BITS 10
+
+static atomic_t checked;
+static atomic_t downgraded;
+static atomic_t dropped[QUALITY_REASON_COUNT];
+
+static const char *const reason_names[QUALITY_REASON_COUNT] = {
+    [QUALITY_REASON_CRC] = "CRC",
+    [QUALITY_REASON_RSSI] = "RSSI",
+    [QUALITY_REASON_WEAK] = "weak",
+    [QUALITY_REASON_SATURATED] = "saturated",
+    [QUALITY_REASON_INCOHERENT] = "incoherent",
+};
+
+/*
+ * Lag-one correlation of the reference period. The carrier offset turns
+ * every step by the same angle, so for a clean tone |c|^2 equals the
+ * product of the two energies, and noise or interference pulls it below.
+ */
+struct ref_coherence {
+    uint64_t c2;                // |sum of s[n+1] * conj(s[n])|^2
+    uint64_t energy2;           // Energy of s[0..6] times energy of s[1..7]
+};
+
+static inline uint32_t sample_abs(int16_t v)
+{
+    return v < 0 ? -(int32_t)v : v;
+}
+
+static void ref_correlate(const struct aoa_iq_sample *s, int shift, struct ref_coherence *coh)
+{
+    int32_t c_re = 0;
+    int32_t c_im = 0;
+    uint32_t e_a = 0;
+    uint32_t e_b = 0;
+
+    AOA_UNROLL
+    for (int n = 0; n < AOA_REF_SAMPLES - 1; n++) {
+        const int32_t a_i = s[n].i >> shift;
+        const int32_t a_q = s[n].q >> shift;
+        const int32_t b_i = s[n + 1].i >> shift;
+        const int32_t b_q = s[n + 1].q >> shift;
+
+        c_re += b_i * a_i + b_q * a_q;
+        c_im += b_q * a_i - b_i * a_q;
+        e_a += a_i * a_i + a_q * a_q;
+        e_b += b_i * b_i + b_q * b_q;
+    }
+    coh->c2 = (uint64_t)((int64_t)c_re * c_re) + (uint64_t)((int64_t)c_im * c_im);
+    coh->energy2 = (uint64_t)e_a * e_b;
+}
+
+// Coherence of at least @p percent, without a square root or division
+static inline bool ref_coherent(const struct ref_coherence *coh, uint32_t percent)
+{
+    return coh->c2 * 10000 >= (uint64_t)(percent * percent) * coh->energy2;
+}
+
+static enum quality_verdict drop(enum quality_reason reason)
+{
+    atomic_inc(&dropped[reason]);
+    return QUALITY_DROP;
+}
+
+enum quality_verdict quality_check(const struct aoa_iq_report *report)
+{
+    atomic_inc(&checked);
+
+    // Free checks on the report header first
+    if (IS_ENABLED(CONFIG_AOA_RX_QUALITY_DROP_CRC) &&
+        report->packet_status != PACKET_STATUS_CRC_OK) {
+        return drop(QUALITY_REASON_CRC);
+    }
+    if (report->rssi < CONFIG_AOA_RX_QUALITY_MIN_RSSI * 10) {
+        return drop(QUALITY_REASON_RSSI);
+    }
+    if (report->sample_count <= AOA_REF_SAMPLES) {
+        // Too short to judge; snapshot_build() rejects it
+        return QUALITY_PASS;
+    }
+
+    uint32_t saturated = 0;
+    for (int n = 0; n < report->sample_count; n++) {
+        const uint32_t peak = MAX(sample_abs(report->samples[n].i),
+                                  sample_abs(report->samples[n].q));
+        saturated += peak >= CONFIG_AOA_RX_QUALITY_SAT_LEVEL;
+    }
+    if (saturated * 100 > CONFIG_AOA_RX_QUALITY_SAT_PERCENT * report->sample_count) {
+        return drop(QUALITY_REASON_SATURATED);
+    }
+
+    uint32_t amplitude = 0;
+    uint32_t peak = 0;
+    AOA_UNROLL
+    for (int n = 0; n < AOA_REF_SAMPLES; n++) {
+        const uint32_t i = sample_abs(report->samples[n].i);
+        const uint32_t q = sample_abs(report->samples[n].q);
+        amplitude += i + q;
+        peak = MAX(peak, MAX(i, q));
+    }
+    if (amplitude < CONFIG_AOA_RX_QUALITY_MIN_AMPLITUDE * AOA_REF_SAMPLES) {
+        return drop(QUALITY_REASON_WEAK);
+    }
+
+    const int bits = 32 - __builtin_clz(peak);
+    struct ref_coherence coh;
+    ref_correlate(report->samples, MAX(bits - REF_BITS, 0), &coh);
+    if (!ref_coherent(&coh, CONFIG_AOA_RX_QUALITY_MIN_COHERENCE)) {
+        return drop(QUALITY_REASON_INCOHERENT);
+    }
+
+#if defined(CONFIG_AOA_RX_QUALITY_FULL_COHERENCE)
+    if (!ref_coherent(&coh, CONFIG_AOA_RX_QUALITY_FULL_COHERENCE)) {
+        atomic_inc(&downgraded);
+        return QUALITY_DOWNGRADE;
+    }
+#endif
+    return QUALITY_PASS;
+}
+
+void quality_stats_get(struct quality_stats *stats)
+{
+    stats->checked = atomic_get(&checked);
+    stats->downgraded = atomic_get(&downgraded);
+    for (int r = 0; r < QUALITY_REASON_COUNT; r++) {
+        stats->dropped[r] = atomic_get(&dropped[r]);
+    }
+}
+
+void quality_log_stats(void)
+{
+    struct quality_stats stats;
+    uint32_t total = 0;
+
+    quality_stats_get(&stats);
+    for (int r = 0; r < QUALITY_REASON_COUNT; r++) {
+        total += stats.dropped[r];
+    }
+    LOG_INF("Quality: %u checked, %u dropped, %u downgraded", stats.checked, total,
+            stats.downgraded);
+    for (int r = 0; r < QUALITY_REASON_COUNT; r++) {
+        if (stats.dropped[r]) {
+            LOG_INF("  %s: %u", reason_names[r], stats.dropped[r]);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef AOA_RX_QUALITY_H_
+#define AOA_RX_QUALITY_H_
+
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+#include "iq_report.h"
+
+/*
+ * Report quality gate ahead of the estimator. A few integer checks on
+ * the raw report (CRC status, RSSI, sample amplitude and the phase
+ * coherence of the reference period) decide whether a report is worth
+ * estimating at all, and whether the configured estimator is worth its
+ * cost or the phase-difference estimator will do. Runs in the DSP thread.
+ */
+
+enum quality_verdict {
+    QUALITY_PASS,
+    QUALITY_DOWNGRADE,          // Estimate with the phase-difference estimator
+    QUALITY_DROP,
+};
+
+enum quality_reason {
+    QUALITY_REASON_CRC,
+    QUALITY_REASON_RSSI,
+    QUALITY_REASON_WEAK,        // Reference period amplitude too low
+    QUALITY_REASON_SATURATED,
+    QUALITY_REASON_INCOHERENT,  // Reference period phase too noisy to estimate from
+    QUALITY_REASON_COUNT,
+};
+
+struct quality_stats {
+    uint32_t checked;
+    uint32_t downgraded;
+    uint32_t dropped[QUALITY_REASON_COUNT];
+};
+
+#if defined(CONFIG_AOA_RX_QUALITY_GATE)
+
+/** @brief Classify @p report and count the reason if it is dropped. */
+enum quality_verdict quality_check(const struct aoa_iq_report *report);
+
+void quality_stats_get(struct quality_stats *stats);
+
+void quality_log_stats(void);
+
+#else
+
+static inline enum quality_verdict quality_check(const struct aoa_iq_report *report)
+{
+    ARG_UNUSED(report);
+    return QUALITY_PASS;
+}
+
+static inline void quality_log_stats(void)
+{
+}
+
+#endif /* CONFIG_AOA_RX_QUALITY_GATE */
+
+#endif /* AOA_RX_QUALITY_H_ */
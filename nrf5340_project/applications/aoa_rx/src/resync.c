@@ -0,0 +1,247 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+
+#include "resync.h"
+#include "tag.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+#define SYNC_TIMEOUT_MIN 10             // 100 ms, the spec minimum (10 ms units)
+#define SYNC_TIMEOUT_MAX 0x4000         // 163.84 s
+#define SYNC_TIMEOUT_SHIFT_MAX 3        // At most eight times the base timeout
+#define SYNC_STABLE_MS (60 * MSEC_PER_SEC)
+
+// List-based sync create in progress, NULL if none, and the skip it asked for. Like the tags
+// the attempt covers, both are only used under tag_lock()
+static struct bt_le_per_adv_sync *pending;
+static uint16_t pending_skip;
+static int64_t pending_until;           // End of the attempt's window
+
+static atomic_t losses;
+static atomic_t reacquired;
+static atomic_t fallbacks;
+static atomic_t last_ms;
+static atomic_t max_ms;
+static atomic_t total_ms;
+
+static void attempt_timeout(struct k_work *work)
+{
+    tag_lock();
+    // Cancelling the work does not stop a handler that is already running, so the attempt
+    // may have ended, and another started, while this waited for the lock. Deleting the sync
+    // ends the attempt through term_cb and resync_terminated()
+    if (pending && k_uptime_get() >= pending_until) {
+        bt_le_per_adv_sync_delete(pending);
+    }
+    tag_unlock();
+}
+
+static K_WORK_DELAYABLE_DEFINE(attempt_work, attempt_timeout);
+
+uint16_t resync_sync_timeout(const struct aoa_tag *tag, uint16_t skip)
+{
+    // Counted in received events; interval is in 1.25 ms units, the timeout in 10 ms units
+    const uint32_t events = (CONFIG_AOA_RX_SYNC_TIMEOUT_EVENTS << tag->timeout_shift) * (skip + 1);
+    const uint32_t timeout = DIV_ROUND_UP((uint32_t)tag->interval * events, 8);
+
+    return CLAMP(timeout, SYNC_TIMEOUT_MIN, SYNC_TIMEOUT_MAX);
+}
+
+static void fall_back(struct aoa_tag *tag)
+{
+    LOG_INF("Tag %u: resync failed %u times, back to scanning", tag->id,
+            tag->resync_failures);
+    if (tag->listed) {
+        bt_le_per_adv_list_remove(&tag->addr, tag->sid);
+    }
+    tag_free(tag);
+    atomic_inc(&fallbacks);
+}
+
+static void kick(void)
+{
+    uint16_t timeout = 0;
+    uint16_t skip = UINT16_MAX;
+    uint8_t failures = 0;
+
+    if (pending) {
+        return;
+    }
+
+    // The list cannot change while a list-based create is pending, so add tags lost since now
+    for (uint8_t id = 0; id < CONFIG_AOA_RX_MAX_TAGS; id++) {
+        struct aoa_tag *tag = tag_get(id);
+        if (!tag || tag->state != AOA_TAG_RESYNCING) {
+            continue;
+        }
+        if (!tag->listed) {
+            int err = bt_le_per_adv_list_add(&tag->addr, tag->sid);
+            if (err) {
+                LOG_WRN("Periodic advertiser list add failed (err %d)", err);
+                fall_back(tag);
+                continue;
+            }
+            tag->listed = true;
+        }
+        // One create covers every listed tag; the duty cycle policy adjusts them afterwards
+        skip = MIN(skip, tag->target_skip);
+        failures = MAX(failures, tag->resync_failures);
+    }
+    if (skip == UINT16_MAX) {
+        return;
+    }
+
+    for (uint8_t id = 0; id < CONFIG_AOA_RX_MAX_TAGS; id++) {
+        struct aoa_tag *tag = tag_get(id);
+        if (tag && tag->state == AOA_TAG_RESYNCING) {
+            timeout = MAX(timeout, resync_sync_timeout(tag, skip));
+        }
+    }
+
+    const struct bt_le_per_adv_sync_param param = {
+        .options = BT_LE_PER_ADV_SYNC_OPT_USE_PER_ADV_LIST,
+        .skip = skip,
+        .timeout = timeout,
+    };
+    int err = bt_le_per_adv_sync_create(&param, &pending);
+    if (err) {
+        // -EBUSY while a new tag's sync is pending; kicked again when it finishes
+        LOG_DBG("Resync create deferred (err %d)", err);
+        pending = NULL;
+        return;
+    }
+    pending_skip = skip;
+
+    // Each failed attempt doubles the window of the next
+    const uint32_t window_ms = CONFIG_AOA_RX_RESYNC_WINDOW_MS << failures;
+    pending_until = k_uptime_get() + window_ms;
+    k_work_reschedule(&attempt_work, K_MSEC(window_ms));
+}
+
+void resync_kick(void)
+{
+    tag_lock();
+    kick();
+    tag_unlock();
+}
+
+void resync_start(struct aoa_tag *tag)
+{
+    const uint32_t lived = k_uptime_get_32() - tag->synced_at;
+
+    tag_lock();
+    // Quick losses lengthen the supervision timeout, long-lived syncs shorten it again
+    if (lived < SYNC_STABLE_MS) {
+        tag->timeout_shift = MIN(tag->timeout_shift + 1, SYNC_TIMEOUT_SHIFT_MAX);
+    } else if (tag->timeout_shift) {
+        tag->timeout_shift--;
+    }
+
+    tag->lost = true;
+    atomic_inc(&losses);
+    resync_requeue(tag);
+    tag_unlock();
+}
+
+void resync_requeue(struct aoa_tag *tag)
+{
+    tag_lock();
+    tag->state = AOA_TAG_RESYNCING;
+    tag->sync = NULL;
+    tag->resync_failures = 0;
+
+    kick();
+    tag_unlock();
+}
+
+// Called with the lock held
+static struct aoa_tag *synced(struct bt_le_per_adv_sync *sync, const bt_addr_le_t *addr,
+                              uint8_t sid)
+{
+    if (!pending || sync != pending) {
+        return NULL;
+    }
+    k_work_cancel_delayable(&attempt_work);
+    pending = NULL;
+
+    struct aoa_tag *tag = tag_find_addr(addr, sid);
+    if (!tag || tag->state != AOA_TAG_RESYNCING) {
+        return NULL;
+    }
+    bt_le_per_adv_list_remove(&tag->addr, tag->sid);
+    tag->listed = false;
+    tag->sync = sync;
+    tag->skip = pending_skip;
+    tag->resync_failures = 0;
+    if (!tag->lost) {
+        return tag;
+    }
+    tag->lost = false;
+
+    // What the dashboards see: no reports from the last one before the loss until now
+    const uint32_t gap = k_uptime_get_32() - tag->last_report;
+    atomic_set(&last_ms, gap);
+    atomic_add(&total_ms, gap);
+    if (gap > (uint32_t)atomic_get(&max_ms)) {
+        atomic_set(&max_ms, gap);
+    }
+    atomic_inc(&reacquired);
+
+    LOG_INF("Tag %u: resynced, %u ms without reports", tag->id, gap);
+    return tag;
+}
+
+struct aoa_tag *resync_synced(struct bt_le_per_adv_sync *sync, const bt_addr_le_t *addr,
+                              uint8_t sid)
+{
+    tag_lock();
+    struct aoa_tag *tag = synced(sync, addr, sid);
+    tag_unlock();
+    return tag;
+}
+
+bool resync_terminated(const struct bt_le_per_adv_sync *sync)
+{
+    tag_lock();
+    if (!pending || sync != pending) {
+        tag_unlock();
+        return false;
+    }
+    k_work_cancel_delayable(&attempt_work);
+    pending = NULL;
+
+    // Only tags that were on the list during the attempt count it as a failure
+    for (uint8_t id = 0; id < CONFIG_AOA_RX_MAX_TAGS; id++) {
+        struct aoa_tag *tag = tag_get(id);
+        if (!tag || tag->state != AOA_TAG_RESYNCING || !tag->listed) {
+            continue;
+        }
+        if (++tag->resync_failures >= CONFIG_AOA_RX_RESYNC_ATTEMPTS) {
+            fall_back(tag);
+        }
+    }
+    tag_unlock();
+    return true;
+}
+
+void resync_stats_get(struct resync_stats *stats)
+{
+    stats->losses = atomic_get(&losses);
+    stats->reacquired = atomic_get(&reacquired);
+    stats->fallbacks = atomic_get(&fallbacks);
+    stats->last_ms = atomic_get(&last_ms);
+    stats->max_ms = atomic_get(&max_ms);
+    stats->mean_ms = stats->reacquired ? (uint32_t)atomic_get(&total_ms) / stats->reacquired : 0;
+}
+
+void resync_log_stats(void)
+{
+    struct resync_stats stats;
+
+    resync_stats_get(&stats);
+    LOG_INF("Resync: %u lost, %u reacquired (last %u ms, mean %u ms, max %u ms), "
+            "%u back to scanning", stats.losses, stats.reacquired, stats.last_ms,
+            stats.mean_ms, stats.max_ms, stats.fallbacks);
+}
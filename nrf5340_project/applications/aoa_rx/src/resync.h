@@ -0,0 +1,69 @@
+#ifndef AOA_RX_RESYNC_H_
+#define AOA_RX_RESYNC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+#include "tag.h"
+
+/*
+ * Reacquisition of periodic advertising tags whose sync was lost. Lost
+ * tags stay in the tag table and go on the controller's periodic
+ * advertiser list, and a single list-based sync create brings back
+ * whichever is heard first. Tags that fail CONFIG_AOA_RX_RESYNC_ATTEMPTS
+ * attempts are dropped and rediscovered by scanning.
+ *
+ * The sync callbacks call in from the Bluetooth RX thread, the duty
+ * cycle policy from the system work queue and the warm start from
+ * main(), and the attempt times out on the system work queue. Every
+ * entry point takes tag_lock(), which also covers the pending attempt,
+ * so a caller may already hold it. The statistics are atomics.
+ */
+
+struct resync_stats {
+    uint32_t losses;
+    uint32_t reacquired;
+    uint32_t fallbacks;                 // Gave up and went back to scanning
+    uint32_t last_ms;                   // Gap from the last report before the loss to the resync
+    uint32_t mean_ms;
+    uint32_t max_ms;
+};
+
+/** @brief Supervision timeout for a sync to @p tag skipping @p skip events, in 10 ms units. */
+uint16_t resync_sync_timeout(const struct aoa_tag *tag, uint16_t skip);
+
+/** @brief Start reacquiring @p tag after its sync was lost. */
+void resync_start(struct aoa_tag *tag);
+
+/**
+ * @brief Sync to @p tag again with its target skip.
+ *
+ * The caller has already deleted the tag's sync. Unlike resync_start()
+ * this is not counted as a loss.
+ */
+void resync_requeue(struct aoa_tag *tag);
+
+/**
+ * @brief Claim a sync established by the resync attempt.
+ *
+ * @return The reacquired tag, or NULL if @p sync was not created here.
+ */
+struct aoa_tag *resync_synced(struct bt_le_per_adv_sync *sync, const bt_addr_le_t *addr,
+                              uint8_t sid);
+
+/** @brief Handle the end of a failed or cancelled attempt; false if @p sync is not ours. */
+bool resync_terminated(const struct bt_le_per_adv_sync *sync);
+
+/**
+ * @brief Start another attempt if tags are waiting and no sync create is pending.
+ *
+ * Only one sync create may be pending, so call this whenever one finishes.
+ */
+void resync_kick(void);
+
+void resync_stats_get(struct resync_stats *stats);
+
+void resync_log_stats(void);
+
+#endif /* AOA_RX_RESYNC_H_ */
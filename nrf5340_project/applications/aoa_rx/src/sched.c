@@ -0,0 +1,175 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+
+#include "ipc_link.h"
+#include "quality.h"
+#include "sched.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+// A tag's share of the report pool, and at least one report behind the one being estimated
+#define QUEUE_DEPTH MAX(CONFIG_AOA_RX_CTE_COUNT * CONFIG_AOA_RX_IQ_EVENTS_BUFFERED, 2)
+
+// A tag is falling behind once this many reports wait behind the one being estimated,
+// or once that one has used up half its time to CONFIG_AOA_RX_SCHED_MAX_AGE_MS
+#define BACKLOG_DEPTH (QUEUE_DEPTH / 2)
+#define BACKLOG_AGE_MS (CONFIG_AOA_RX_SCHED_MAX_AGE_MS / 2)
+
+struct tag_queue {
+    struct aoa_iq_report *report[QUEUE_DEPTH];   // Oldest first
+    uint32_t arrived[QUEUE_DEPTH];               // k_uptime_get_32() at admission
+    bool downgrade[QUEUE_DEPTH];                 // The quality gate's verdict
+    uint8_t count;
+    uint8_t generation;                          // Of the tag the queued reports belong to
+    uint32_t served;                             // k_uptime_get_32() of the latest estimate
+
+    atomic_t admitted;
+    atomic_t estimated;
+    atomic_t downgraded;
+    atomic_t decimated;
+    atomic_t expired;
+};
+
+static struct tag_queue queues[CONFIG_AOA_RX_MAX_TAGS];
+static int pending;
+
+// Ties go to the tag after the one served last, so equal tags take turns
+static size_t next_tag;
+
+static struct aoa_iq_report *queue_pop(struct tag_queue *q, bool *downgrade)
+{
+    struct aoa_iq_report *report = q->report[0];
+
+    if (downgrade) {
+        *downgrade = q->downgrade[0];
+    }
+    q->count--;
+    memmove(&q->report[0], &q->report[1], q->count * sizeof(q->report[0]));
+    memmove(&q->arrived[0], &q->arrived[1], q->count * sizeof(q->arrived[0]));
+    memmove(&q->downgrade[0], &q->downgrade[1], q->count * sizeof(q->downgrade[0]));
+    pending--;
+    return report;
+}
+
+void sched_admit(struct aoa_iq_report *report)
+{
+    if (report->tag_id >= ARRAY_SIZE(queues)) {
+        ipc_link_report_free(report);
+        return;
+    }
+
+    // Cheap enough to run on every report, and junk never takes a queue slot
+    const enum quality_verdict verdict = quality_check(report);
+    if (verdict == QUALITY_DROP) {
+        ipc_link_report_free(report);
+        return;
+    }
+
+    struct tag_queue *q = &queues[report->tag_id];
+
+    // The tag id was freed and given to another tag: what the last one left is stale
+    if (report->generation != q->generation) {
+        while (q->count) {
+            ipc_link_report_free(queue_pop(q, NULL));
+            atomic_inc(&q->expired);
+        }
+        q->generation = report->generation;
+    }
+
+    if (q->count == QUEUE_DEPTH) {
+        ipc_link_report_free(queue_pop(q, NULL));
+        atomic_inc(&q->decimated);
+    }
+    q->report[q->count] = report;
+    q->arrived[q->count] = k_uptime_get_32();
+    q->downgrade[q->count] = verdict == QUALITY_DOWNGRADE;
+    q->count++;
+    pending++;
+    atomic_inc(&q->admitted);
+}
+
+bool sched_pending(void)
+{
+    return pending > 0;
+}
+
+struct aoa_iq_report *sched_next(bool *downgrade)
+{
+    const uint32_t now = k_uptime_get_32();
+    struct tag_queue *best = NULL;
+    uint64_t best_score = 0;
+    size_t best_tag = 0;
+
+    for (size_t n = 0; n < ARRAY_SIZE(queues); n++) {
+        const size_t t = (next_tag + n) % ARRAY_SIZE(queues);
+        struct tag_queue *q = &queues[t];
+
+        while (q->count && now - q->arrived[0] > CONFIG_AOA_RX_SCHED_MAX_AGE_MS) {
+            ipc_link_report_free(queue_pop(q, NULL));
+            atomic_inc(&q->expired);
+        }
+        if (!q->count) {
+            continue;
+        }
+
+        // Time since the tag's last estimate, so a tag that is rarely served rises to the top
+        const uint32_t weight = q->report[0]->priority ? CONFIG_AOA_RX_SCHED_PRIORITY_WEIGHT : 1;
+        const uint64_t score = (uint64_t)(now - q->served + 1) * weight;
+        if (!best || score > best_score) {
+            best = q;
+            best_score = score;
+            best_tag = t;
+        }
+    }
+    if (!best) {
+        return NULL;
+    }
+
+    const uint32_t age = now - best->arrived[0];
+    struct aoa_iq_report *report = queue_pop(best, downgrade);
+
+    // Falling behind: catch up with the cheap estimator. A few reports waiting behind this
+    // one are only the other CTEs of its event, which the configured estimator keeps up with
+    if (!*downgrade && (best->count >= BACKLOG_DEPTH || age > BACKLOG_AGE_MS)) {
+        *downgrade = true;
+        if (!IS_ENABLED(CONFIG_AOA_RX_EST_PHASE_DIFF)) {
+            atomic_inc(&best->downgraded);
+        }
+    }
+    best->served = now;
+    next_tag = (best_tag + 1) % ARRAY_SIZE(queues);
+    atomic_inc(&best->estimated);
+    return report;
+}
+
+void sched_stats_get(uint8_t tag_id, struct sched_stats *stats)
+{
+    const struct tag_queue *q = &queues[tag_id];
+
+    // count is a byte only the DSP thread writes, so it reads whole without a lock
+    *stats = (struct sched_stats){
+        .queued = q->count,
+        .admitted = atomic_get(&q->admitted),
+        .estimated = atomic_get(&q->estimated),
+        .downgraded = atomic_get(&q->downgraded),
+        .decimated = atomic_get(&q->decimated),
+        .expired = atomic_get(&q->expired),
+    };
+}
+
+void sched_log_stats(void)
+{
+    for (size_t t = 0; t < ARRAY_SIZE(queues); t++) {
+        struct sched_stats stats;
+
+        sched_stats_get(t, &stats);
+        if (!stats.admitted) {
+            continue;
+        }
+        LOG_INF("Sched tag %u: %u admitted, %u estimated, %u downgraded, %u decimated, "
+                "%u expired", (unsigned int)t, stats.admitted, stats.estimated, stats.downgraded,
+                stats.decimated, stats.expired);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef AOA_RX_SCHED_H_
+#define AOA_RX_SCHED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+#include "iq_report.h"
+
+/*
+ * Admission control between the report ring and the estimator, so that
+ * overload degrades gracefully instead of by whichever report the pool
+ * happens to refuse. The DSP thread drains the ring into a short queue
+ * per tag and estimates one report at a time from the tag that has
+ * waited longest since its last estimate, weighted by its priority. A
+ * tag whose queue is half full, or whose report has waited half of
+ * CONFIG_AOA_RX_SCHED_MAX_AGE_MS, gets the phase-difference estimator
+ * until it has caught up; only when its queue is full is its oldest
+ * report dropped, so one busy tag never costs another tag a report.
+ * Reports that waited longer than CONFIG_AOA_RX_SCHED_MAX_AGE_MS are
+ * dropped unestimated, as are those still queued for a tag whose id has
+ * been given to a new tag. Runs in the DSP thread.
+ */
+
+struct sched_stats {
+    uint32_t queued;            // Waiting now
+    uint32_t admitted;          // Passed the quality gate into the queue
+    uint32_t estimated;
+    uint32_t downgraded;        // Estimated with the phase-difference estimator to catch up
+    uint32_t decimated;         // Dropped for a newer report of the same tag
+    uint32_t expired;           // Dropped after CONFIG_AOA_RX_SCHED_MAX_AGE_MS
+};
+
+#if !defined(CONFIG_AOA_RX_ROLE_HOST) && !defined(CONFIG_AOA_RX_ROLE_THIN)
+
+/** @brief Queue @p report for estimation, or free it if the quality gate drops it. */
+void sched_admit(struct aoa_iq_report *report);
+
+/** @brief True if any report is queued. */
+bool sched_pending(void);
+
+/**
+ * @brief Take the next report to estimate.
+ *
+ * @param downgrade Set if the report should get the phase-difference
+ *                  estimator instead of the configured one.
+ *
+ * @return The report, for ipc_link_report_free() once estimated, or NULL
+ *         if nothing is queued.
+ */
+struct aoa_iq_report *sched_next(bool *downgrade);
+
+/** @brief Counters for the tag with pool index @p tag_id. */
+void sched_stats_get(uint8_t tag_id, struct sched_stats *stats);
+
+void sched_log_stats(void);
+
+#else
+
+static inline void sched_log_stats(void)
+{
+}
+
+#endif
+
+#endif /* AOA_RX_SCHED_H_ */
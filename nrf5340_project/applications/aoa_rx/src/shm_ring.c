@@ -0,0 +1,68 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/barrier.h>
+#include <zephyr/sys/util.h>
+
+#include "shm_ring.h"
+
+#define SHM_RING_MAGIC 0x414f4152 // "AOAR"
+
+static inline uint8_t *slot_at(struct shm_ring *ring, uint32_t index)
+{
+    return &ring->data[(index & (ring->capacity - 1)) * ring->elem_size];
+}
+
+void shm_ring_init(struct shm_ring *ring, size_t elem_size, uint32_t capacity)
+{
+    __ASSERT((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    ring->magic = 0;
+    ring->elem_size = ROUND_UP(elem_size, 4);
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->tail = 0;
+
+    // The other core polls magic, so it must be the last field to land
+    barrier_dmem_fence_full();
+    ring->magic = SHM_RING_MAGIC;
+}
+
+bool shm_ring_ready(const struct shm_ring *ring)
+{
+    return ring->magic == SHM_RING_MAGIC;
+}
+
+void *shm_ring_claim(struct shm_ring *ring)
+{
+    if (ring->head - ring->tail >= ring->capacity) {
+        return NULL;
+    }
+    return slot_at(ring, ring->head);
+}
+
+void shm_ring_commit(struct shm_ring *ring)
+{
+    // Slot contents must be visible before the new head
+    barrier_dmem_fence_full();
+    ring->head = ring->head + 1;
+}
+
+void *shm_ring_peek(struct shm_ring *ring)
+{
+    if (ring->tail == ring->head) {
+        return NULL;
+    }
+    // Do not read slot contents ahead of the head that published them
+    barrier_dmem_fence_full();
+    return slot_at(ring, ring->tail);
+}
+
+void shm_ring_release(struct shm_ring *ring)
+{
+    barrier_dmem_fence_full();
+    ring->tail = ring->tail + 1;
+}
+
+uint32_t shm_ring_count(const struct shm_ring *ring)
+{
+    return ring->head - ring->tail;
+}
@@ -0,0 +1,49 @@
+#ifndef AOA_RX_SHM_RING_H_
+#define AOA_RX_SHM_RING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+/*
+ * Single-producer/single-consumer ring of fixed-size slots. The header and
+ * slots live in one contiguous block, so the ring can be placed in SRAM
+ * shared between the nRF5340 cores and used from both sides without locks.
+ * Slots are filled and drained in place (claim/commit, peek/release) so a
+ * report is copied exactly once, by the producer.
+ */
+struct shm_ring {
+    uint32_t magic;
+    uint32_t elem_size;
+    uint32_t capacity;       // Power of two
+    volatile uint32_t head;  // Written by the producer only
+    volatile uint32_t tail;  // Written by the consumer only
+    uint8_t data[];
+};
+
+#define SHM_RING_SIZE(elem_size, capacity) \
+    (sizeof(struct shm_ring) + ROUND_UP(elem_size, 4) * (capacity))
+
+/** @brief Format a ring in @p ring; the memory must be SHM_RING_SIZE() bytes. */
+void shm_ring_init(struct shm_ring *ring, size_t elem_size, uint32_t capacity);
+
+/** @brief True once the ring has been formatted, possibly by the other core. */
+bool shm_ring_ready(const struct shm_ring *ring);
+
+/** @brief Producer: next free slot, or NULL if the ring is full. */
+void *shm_ring_claim(struct shm_ring *ring);
+
+/** @brief Producer: publish the slot returned by shm_ring_claim(). */
+void shm_ring_commit(struct shm_ring *ring);
+
+/** @brief Consumer: oldest published slot, or NULL if the ring is empty. */
+void *shm_ring_peek(struct shm_ring *ring);
+
+/** @brief Consumer: hand the slot returned by shm_ring_peek() back. */
+void shm_ring_release(struct shm_ring *ring);
+
+/** @brief Number of published slots not yet released. */
+uint32_t shm_ring_count(const struct shm_ring *ring);
+
+#endif /* AOA_RX_SHM_RING_H_ */
@@ -0,0 +1,297 @@
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/timing/timing.h>
+
+#include "forward.h"
+#include "history.h"
+#include "ipc_link.h"
+#include "pool.h"
+#include "resync.h"
+#include "sched.h"
+#include "stats.h"
+#include "tag.h"
+
+// Report rates are averaged over this, and a tag silent for twice as long shows none
+#define RATE_WINDOW_MS 1000
+
+struct tag_stats {
+    atomic_t active;                    // In the tag table
+    atomic_t reports;                   // CTE reports
+    atomic_t events;                    // Distinct events among them
+    atomic_t missed;                    // Events expected between them but not reported
+    atomic_t adv;                       // Periodic advertising packets
+    atomic_t rate;                      // Reports per second over the last window, x10
+    atomic_t last_ms;                   // k_uptime_get_32() of the latest report
+
+    // Bluetooth RX thread only
+    uint32_t synced_at;                 // Of the sync the event chain below belongs to
+    uint32_t window_start;
+    uint32_t window_reports;
+    uint16_t last_event;
+    bool chained;                       // last_event is from the current sync
+};
+
+struct est_stats {
+    atomic_t count;
+    atomic_t max;                       // Cycles
+    atomic_t hist[STATS_EST_BUCKETS];
+};
+
+static struct tag_stats tags[CONFIG_AOA_RX_MAX_TAGS];
+
+// Written by the DSP thread: the configured estimator, then the phase-difference stand-in
+static struct est_stats est[2];
+
+void stats_track(const struct aoa_tag *tag)
+{
+    struct tag_stats *s = &tags[tag->id];
+
+    atomic_clear(&s->reports);
+    atomic_clear(&s->events);
+    atomic_clear(&s->missed);
+    atomic_clear(&s->adv);
+    atomic_clear(&s->rate);
+    atomic_set(&s->last_ms, k_uptime_get_32());
+    s->window_start = k_uptime_get_32();
+    s->window_reports = 0;
+    s->chained = false;
+    atomic_set(&s->active, 1);
+}
+
+void stats_forget(const struct aoa_tag *tag)
+{
+    atomic_clear(&tags[tag->id].active);
+}
+
+void stats_adv(const struct aoa_tag *tag)
+{
+    if (tag) {
+        atomic_inc(&tags[tag->id].adv);
+    }
+}
+
+// Events from one report of the tag to the next when none is missed
+static uint16_t event_step(const struct aoa_tag *tag)
+{
+#if defined(CONFIG_AOA_RX_CONN_CTE)
+    if (tag->conn) {
+        return CONFIG_AOA_RX_CONN_CTE_REQ_INTERVAL;
+    }
+#endif
+    return tag->skip + 1;
+}
+
+void stats_cte(const struct aoa_tag *tag, uint16_t event_counter)
+{
+    struct tag_stats *s = &tags[tag->id];
+    const uint32_t now = k_uptime_get_32();
+
+    atomic_inc(&s->reports);
+    atomic_set(&s->last_ms, now);
+
+    // A new sync, after a loss or a skip change, starts a new event chain
+    if (s->chained && s->synced_at == tag->synced_at) {
+        // The counter wraps at 16 bits, so a gap of more than 65535 events is undercounted
+        const uint16_t delta = event_counter - s->last_event;
+        const uint16_t step = event_step(tag);
+
+        if (delta) {
+            atomic_inc(&s->events);
+            if (delta > step) {
+                atomic_add(&s->missed, delta / step - 1);
+            }
+        }
+    } else {
+        atomic_inc(&s->events);
+    }
+    s->synced_at = tag->synced_at;
+    s->last_event = event_counter;
+    s->chained = true;
+
+    s->window_reports++;
+    const uint32_t elapsed = now - s->window_start;
+    if (elapsed >= RATE_WINDOW_MS) {
+        atomic_set(&s->rate, s->window_reports * 10000 / elapsed);
+        s->window_start = now;
+        s->window_reports = 0;
+    }
+}
+
+void stats_estimate(uint64_t start, bool downgrade)
+{
+    timing_t end = timing_counter_get();
+    timing_t begin = start;
+    const uint32_t cycles = MIN(timing_cycles_get(&begin, &end), UINT32_MAX);
+    // With the phase-difference estimator configured, downgrading changes nothing
+    struct est_stats *e = &est[downgrade && !IS_ENABLED(CONFIG_AOA_RX_EST_PHASE_DIFF)];
+
+    // The DSP thread is the only writer, so max needs no compare and swap
+    if (cycles > (uint32_t)atomic_get(&e->max)) {
+        atomic_set(&e->max, cycles);
+    }
+    const unsigned int bucket = cycles ? 31 - __builtin_clz(cycles) : 0;
+    atomic_inc(&e->hist[MIN(bucket, STATS_EST_BUCKETS - 1)]);
+    atomic_inc(&e->count);
+}
+
+static uint32_t cycles_to_us(uint64_t cycles)
+{
+    return timing_cycles_to_ns(cycles) / 1000;
+}
+
+static int cmd_tags(const struct shell *sh, size_t argc, char **argv)
+{
+    const uint32_t now = k_uptime_get_32();
+
+    shell_print(sh, "tag  rate/s  reports   events   missed  miss%%      adv  last ms");
+    for (size_t i = 0; i < ARRAY_SIZE(tags); i++) {
+        const struct tag_stats *s = &tags[i];
+        if (!atomic_get(&s->active)) {
+            continue;
+        }
+
+        const uint32_t age = now - (uint32_t)atomic_get(&s->last_ms);
+        const uint32_t rate = age > 2 * RATE_WINDOW_MS ? 0 : atomic_get(&s->rate);
+        const uint32_t events = atomic_get(&s->events);
+        const uint32_t missed = atomic_get(&s->missed);
+        const uint32_t expected = events + missed;
+
+        shell_print(sh, "%3u  %4u.%u %8u %8u %8u  %3u.%u %8u %8u", (unsigned int)i, rate / 10,
+                    rate % 10, (uint32_t)atomic_get(&s->reports), events, missed,
+                    expected ? (uint32_t)(missed * 100ull / expected) : 0,
+                    expected ? (uint32_t)(missed * 1000ull / expected % 10) : 0,
+                    (uint32_t)atomic_get(&s->adv), age);
+    }
+    return 0;
+}
+
+static int cmd_queues(const struct shell *sh, size_t argc, char **argv)
+{
+    uint32_t reports, results;
+
+    ipc_link_depth(&reports, &results);
+    shell_print(sh, "Report ring: %u waiting for the %s", reports,
+                IS_ENABLED(CONFIG_AOA_RX_ROLE_THIN) ? "forward thread" : "DSP");
+    shell_print(sh, "Result ring: %u waiting for the result handler", results);
+
+#if !defined(CONFIG_AOA_RX_ROLE_HOST) && !defined(CONFIG_AOA_RX_ROLE_THIN)
+    shell_print(sh, "tag  queued  admitted  estimated  downgraded  decimated   expired");
+    for (size_t i = 0; i < ARRAY_SIZE(tags); i++) {
+        struct sched_stats stats;
+
+        sched_stats_get(i, &stats);
+        if (!stats.admitted) {
+            continue;
+        }
+        shell_print(sh, "%3u  %6u  %8u  %9u  %10u  %9u  %8u", (unsigned int)i, stats.queued,
+                    stats.admitted, stats.estimated, stats.downgraded, stats.decimated,
+                    stats.expired);
+    }
+#endif
+    return 0;
+}
+
+static void pool_print(const struct aoa_pool_stats *stats, void *user_data)
+{
+    const struct shell *sh = user_data;
+
+    shell_print(sh, "%-12s %5u %5u %5u %8u", stats->name, stats->used, stats->peak,
+                stats->capacity, stats->failures);
+}
+
+static int cmd_pools(const struct shell *sh, size_t argc, char **argv)
+{
+    shell_print(sh, "%-12s %5s %5s %5s %8s", "pool", "used", "peak", "size", "failures");
+    aoa_pool_foreach(pool_print, (void *)sh);
+    return 0;
+}
+
+static void est_print(const struct shell *sh, const char *name, const struct est_stats *e)
+{
+    const uint32_t count = atomic_get(&e->count);
+
+    shell_print(sh, "%s: %u reports, max %u us", name, count,
+                cycles_to_us((uint32_t)atomic_get(&e->max)));
+    if (!count) {
+        return;
+    }
+    shell_print(sh, "  from cycles   from us   reports");
+    for (size_t i = 0; i < STATS_EST_BUCKETS; i++) {
+        const uint32_t n = atomic_get(&e->hist[i]);
+        if (n) {
+            const uint32_t from = i ? BIT(i) : 0;
+            shell_print(sh, "  %11u  %8u  %8u", from, cycles_to_us(from), n);
+        }
+    }
+}
+
+static int cmd_est(const struct shell *sh, size_t argc, char **argv)
+{
+    if (IS_ENABLED(CONFIG_AOA_RX_ROLE_HOST) || IS_ENABLED(CONFIG_AOA_RX_ROLE_THIN)) {
+        shell_print(sh, "No estimator runs on this core");
+        return 0;
+    }
+    est_print(sh, "Configured estimator", &est[0]);
+    est_print(sh, "Phase-difference stand-in", &est[1]);
+    return 0;
+}
+
+static int cmd_sync(const struct shell *sh, size_t argc, char **argv)
+{
+    struct resync_stats stats;
+
+    resync_stats_get(&stats);
+    shell_print(sh, "Lost: %u", stats.losses);
+    shell_print(sh, "Reacquired: %u (last %u ms, mean %u ms, max %u ms)", stats.reacquired,
+                stats.last_ms, stats.mean_ms, stats.max_ms);
+    shell_print(sh, "Back to scanning: %u", stats.fallbacks);
+    return 0;
+}
+
+static int cmd_out(const struct shell *sh, size_t argc, char **argv)
+{
+    uint32_t reports, results;
+
+    ipc_link_depth(&reports, &results);
+#if defined(CONFIG_AOA_RX_ROLE_THIN)
+    struct forward_stats fwd;
+
+    forward_stats_get(&fwd);
+    shell_print(sh, "Reports waiting to be forwarded: %u", reports);
+    shell_print(sh, "Forwarded: %u frames, %u headers, %u bytes, %u errors", fwd.frames,
+                fwd.headers, fwd.bytes, fwd.errors);
+#else
+    shell_print(sh, "Results waiting for output: %u", results);
+#endif
+#if defined(CONFIG_AOA_RX_HISTORY)
+    struct history_stats hist;
+
+    history_stats_get(&hist);
+    shell_print(sh, "History: %u angles, %u dropped, %u batches (%u bytes), %u errors",
+                hist.angles, hist.dropped, hist.batches, hist.bytes, hist.errors);
+#endif
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(aoa_cmds,
+    SHELL_CMD(tags, NULL, "Report rate and CTE events missed per tag", cmd_tags),
+    SHELL_CMD(queues, NULL, "Reports and results waiting between threads", cmd_queues),
+    SHELL_CMD(pools, NULL, "Pool use and high-watermarks", cmd_pools),
+    SHELL_CMD(est, NULL, "Estimator time per report", cmd_est),
+    SHELL_CMD(sync, NULL, "Sync losses and reacquisition", cmd_sync),
+    SHELL_CMD(out, NULL, "Output backlog", cmd_out),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(aoa, &aoa_cmds, "AoA pipeline statistics", NULL);
+
+static int stats_init(void)
+{
+    // Reference counted, so the Q15 self-test stopping its own use leaves this running
+    timing_init();
+    timing_start();
+    return 0;
+}
+
+SYS_INIT(stats_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
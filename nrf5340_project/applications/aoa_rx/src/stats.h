@@ -0,0 +1,96 @@
+#ifndef AOA_RX_STATS_H_
+#define AOA_RX_STATS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+#include "tag.h"
+
+/*
+ * Live pipeline counters behind the "aoa" shell command
+ * (CONFIG_AOA_RX_SHELL). Every counter has a single writer, the thread
+ * that handles what it counts, and is an atomic_t, so the hot path takes
+ * no lock and the shell reads a consistent value while the pipeline runs.
+ * The shell also shows the counters the pools, rings, scheduler, resync
+ * and output modules keep anyway; only what nothing counted yet is here:
+ * per-tag report rate and CTE events missed, and the estimator's time
+ * per report.
+ */
+
+/* Estimator histogram: bucket i counts reports that took 2^i to 2^(i+1) - 1 cycles */
+#define STATS_EST_BUCKETS 32
+
+#if defined(CONFIG_AOA_RX_SHELL)
+
+#include <zephyr/timing/timing.h>
+
+/** @brief Start counting for @p tag as it enters the tag table. Bluetooth RX thread. */
+void stats_track(const struct aoa_tag *tag);
+
+/** @brief Stop showing @p tag as it leaves the tag table. */
+void stats_forget(const struct aoa_tag *tag);
+
+/** @brief Count a periodic advertising packet of @p tag, which may be NULL. Bluetooth RX thread. */
+void stats_adv(const struct aoa_tag *tag);
+
+/**
+ * @brief Count a CTE report of @p tag, and the events missed since its last one.
+ *
+ * A tag is expected on every (skip + 1)th periodic event, or every
+ * CONFIG_AOA_RX_CONN_CTE_REQ_INTERVAL connection events; a larger step
+ * in @p event_counter counts the events in between as missed. Reports
+ * with the same counter are further CTEs of one event. Bluetooth RX thread.
+ */
+void stats_cte(const struct aoa_tag *tag, uint16_t event_counter);
+
+/** @brief Timestamp to pass to stats_estimate(). */
+static inline uint64_t stats_now(void)
+{
+    return timing_counter_get();
+}
+
+/**
+ * @brief Add the estimate that started at @p start to the histograms.
+ *
+ * @param downgrade The phase-difference estimator stood in for the configured one.
+ */
+void stats_estimate(uint64_t start, bool downgrade);
+
+#else
+
+static inline void stats_track(const struct aoa_tag *tag)
+{
+    ARG_UNUSED(tag);
+}
+
+static inline void stats_forget(const struct aoa_tag *tag)
+{
+    ARG_UNUSED(tag);
+}
+
+static inline void stats_adv(const struct aoa_tag *tag)
+{
+    ARG_UNUSED(tag);
+}
+
+static inline void stats_cte(const struct aoa_tag *tag, uint16_t event_counter)
+{
+    ARG_UNUSED(tag);
+    ARG_UNUSED(event_counter);
+}
+
+static inline uint64_t stats_now(void)
+{
+    return 0;
+}
+
+static inline void stats_estimate(uint64_t start, bool downgrade)
+{
+    ARG_UNUSED(start);
+    ARG_UNUSED(downgrade);
+}
+
+#endif /* CONFIG_AOA_RX_SHELL */
+
+#endif /* AOA_RX_STATS_H_ */
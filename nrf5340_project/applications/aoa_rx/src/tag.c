@@ -0,0 +1,168 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+#include "duty.h"
+#include "iq_report.h"
+#include "pool.h"
+#include "stats.h"
+#include "tag.h"
+#include "warm.h"
+
+AOA_POOL_BUF_DEFINE(tag_buf, sizeof(struct aoa_tag), CONFIG_AOA_RX_MAX_TAGS);
+static struct aoa_pool tag_pool;
+
+// Allocated tags by pool index; the pool itself cannot be walked
+static struct aoa_tag *tags[CONFIG_AOA_RX_MAX_TAGS];
+
+// A mutex rather than a spinlock: holders call into the Bluetooth host
+static K_MUTEX_DEFINE(tags_mutex);
+
+// Bumped on every allocation, so the DSP side can tell a new tag's reports from the last one's
+static uint8_t generations[CONFIG_AOA_RX_MAX_TAGS];
+
+// On the CONFIG_AOA_RX_SCHED_PRIORITY_TAGS list; any address type matches. A thin
+// locator has no scheduler and so no list
+static bool tag_prioritized(const bt_addr_le_t *addr)
+{
+#if defined(CONFIG_AOA_RX_SCHED_PRIORITY_TAGS)
+    const char *list = CONFIG_AOA_RX_SCHED_PRIORITY_TAGS;
+
+    while (*list) {
+        const size_t len = strcspn(list, " ");
+        char str[BT_ADDR_STR_LEN];
+        bt_addr_t a;
+
+        if (len == BT_ADDR_STR_LEN - 1) {
+            memcpy(str, list, len);
+            str[len] = '\0';
+            if (!bt_addr_from_str(str, &a) && bt_addr_eq(&a, &addr->a)) {
+                return true;
+            }
+        }
+        list += len + strspn(list + len, " ");
+    }
+#else
+    ARG_UNUSED(addr);
+#endif
+    return false;
+}
+
+void tag_lock(void)
+{
+    k_mutex_lock(&tags_mutex, K_FOREVER);
+}
+
+void tag_unlock(void)
+{
+    k_mutex_unlock(&tags_mutex);
+}
+
+struct aoa_tag *tag_alloc(const bt_addr_le_t *addr, uint8_t sid, uint8_t source)
+{
+    tag_lock();
+    // Callers look the tag up first without the lock; another thread may have added it since
+    struct aoa_tag *tag = tag_find_addr(addr, sid) ? NULL : aoa_pool_alloc(&tag_pool);
+    if (!tag) {
+        tag_unlock();
+        return NULL;
+    }
+
+    const uint8_t id = aoa_pool_index(&tag_pool, tag);
+
+    *tag = (struct aoa_tag){
+        .addr = *addr,
+        .sid = sid,
+        .source = source,
+        .id = id,
+        .priority = tag_prioritized(addr),
+        .generation = ++generations[id],
+    };
+    tags[tag->id] = tag;
+    duty_forget(tag);
+    stats_track(tag);
+    tag_unlock();
+    return tag;
+}
+
+void tag_free(struct aoa_tag *tag)
+{
+    tag_lock();
+    warm_forget(tag);
+    duty_forget(tag);
+    stats_forget(tag);
+    tags[tag->id] = NULL;
+    aoa_pool_free(&tag_pool, tag);
+    tag_unlock();
+}
+
+bool tag_available(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(tags); i++) {
+        if (!tags[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool tag_establishing(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(tags); i++) {
+        if (tags[i] && tags[i]->source == AOA_IQ_SOURCE_PER_ADV &&
+            tags[i]->state != AOA_TAG_SYNCED) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct aoa_tag *tag_find_addr(const bt_addr_le_t *addr, uint8_t sid)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(tags); i++) {
+        if (tags[i] && tags[i]->sid == sid && bt_addr_le_eq(&tags[i]->addr, addr)) {
+            return tags[i];
+        }
+    }
+    return NULL;
+}
+
+struct aoa_tag *tag_find_sync(const struct bt_le_per_adv_sync *sync)
+{
+    if (!sync) {
+        return NULL;
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(tags); i++) {
+        if (tags[i] && tags[i]->sync == sync) {
+            return tags[i];
+        }
+    }
+    return NULL;
+}
+
+struct aoa_tag *tag_find_conn(const struct bt_conn *conn)
+{
+    if (!conn) {
+        return NULL;
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(tags); i++) {
+        if (tags[i] && tags[i]->conn == conn) {
+            return tags[i];
+        }
+    }
+    return NULL;
+}
+
+struct aoa_tag *tag_get(uint8_t id)
+{
+    return id < ARRAY_SIZE(tags) ? tags[id] : NULL;
+}
+
+static int tag_init(void)
+{
+    return aoa_pool_init(&tag_pool, "tag", tag_buf, sizeof(struct aoa_tag),
+                         CONFIG_AOA_RX_MAX_TAGS);
+}
+
+SYS_INIT(tag_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,78 @@
+#ifndef AOA_RX_TAG_H_
+#define AOA_RX_TAG_H_
+
+#include <stdint.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+struct bt_conn;
+struct bt_le_per_adv_sync;
+
+enum aoa_tag_state {
+    AOA_TAG_SYNCING,                    // Sync create or connection issued
+    AOA_TAG_SYNCED,
+    AOA_TAG_RESYNCING,                  // Sync lost, waiting on the periodic advertiser list
+};
+
+/* Per-tag state, one block of the tag pool per tracked tag */
+struct aoa_tag {
+    bt_addr_le_t addr;
+    uint8_t sid;
+    uint8_t source;                     // enum aoa_iq_source
+    uint8_t id;                         // Index in the tag pool, used as report tag_id
+    uint8_t state;                      // enum aoa_tag_state
+    uint8_t priority;                   // Copied to its reports, see CONFIG_AOA_RX_SCHED_PRIORITY_TAGS
+    uint8_t generation;                 // Copied to its reports; changes each time id is reused
+    uint16_t interval;                  // Periodic advertising interval (1.25 ms units)
+    struct bt_le_per_adv_sync *sync;
+    struct bt_conn *conn;
+
+    uint16_t skip;                      // Periodic events skipped by the current sync
+    uint16_t target_skip;               // Set by the duty cycle policy, see duty.c
+
+    // Resync bookkeeping, see resync.c
+    bool listed;                        // On the controller's periodic advertiser list
+    bool lost;                          // Resyncing after a loss rather than a skip change
+    uint8_t resync_failures;
+    uint8_t timeout_shift;              // Supervision timeout is the base << this
+    uint32_t synced_at;                 // k_uptime_get_32() when the sync was established
+    uint32_t last_report;               // k_uptime_get_32() of the latest CTE report
+};
+
+/*
+ * The tag table belongs to the Bluetooth RX thread: its callbacks
+ * allocate, free and update tags. The system work queue (duty cycle and
+ * result handlers) and main() (warm start, statistics) use tags too, and
+ * hold tag_lock() from the lookup until they are done with the tag, so it
+ * is not freed or handed to another tag meanwhile. Allocation and freeing
+ * take the lock themselves. The lock nests, so a holder may call anything
+ * here.
+ */
+
+void tag_lock(void);
+
+void tag_unlock(void);
+
+/**
+ * @brief Take a tag from the pool.
+ *
+ * @return The new tag, or NULL if CONFIG_AOA_RX_MAX_TAGS are already
+ *         tracked or one with @p addr and @p sid is.
+ */
+struct aoa_tag *tag_alloc(const bt_addr_le_t *addr, uint8_t sid, uint8_t source);
+
+void tag_free(struct aoa_tag *tag);
+
+/** @brief True if another tag fits in the pool. */
+bool tag_available(void);
+
+/** @brief True if any periodic advertising tag still needs scanning to (re)sync. */
+bool tag_establishing(void);
+
+struct aoa_tag *tag_find_addr(const bt_addr_le_t *addr, uint8_t sid);
+struct aoa_tag *tag_find_sync(const struct bt_le_per_adv_sync *sync);
+struct aoa_tag *tag_find_conn(const struct bt_conn *conn);
+
+/** @brief Tag with pool index @p id, or NULL if that block is free. */
+struct aoa_tag *tag_get(uint8_t id);
+
+#endif /* AOA_RX_TAG_H_ */
@@ -0,0 +1,212 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+
+#include "resync.h"
+#include "warm.h"
+
+LOG_MODULE_DECLARE(aoa_rx);
+
+#define WARM_KEY "aoa/warm/tags"
+
+// A new or dropped tag is saved after this, so a burst of syncs costs one write
+#define SET_SAVE_DELAY_MS 2000
+
+/*
+ * What is kept of a tag, by pool index; the whole array is one settings
+ * value. Not its angle: nothing could start from it on the DSP side, and
+ * a tag may well have moved while the locator was down.
+ */
+struct warm_record {
+    bt_addr_le_t addr;
+    uint8_t sid;
+    uint8_t valid;
+    uint16_t interval;                  // 1.25 ms units
+};
+
+// Written from the Bluetooth RX thread and the system work queue
+static struct k_spinlock lock;
+static struct warm_record records[CONFIG_AOA_RX_MAX_TAGS];
+static struct warm_record saved[CONFIG_AOA_RX_MAX_TAGS];
+
+// Loaded at boot, consumed by warm_restore()
+static struct warm_record loaded[CONFIG_AOA_RX_MAX_TAGS];
+
+// Restored tags that have not had an angle yet, by pool index
+static atomic_t waiting;
+
+static atomic_t restored;
+static atomic_t resumed;
+static atomic_t first_ms;
+static atomic_t resumed_ms;
+static atomic_t saves;
+
+static void save_work_handler(struct k_work *work)
+{
+    struct warm_record copy[CONFIG_AOA_RX_MAX_TAGS];
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    memcpy(copy, records, sizeof(copy));
+    k_spin_unlock(&lock, key);
+
+    if (!memcmp(copy, saved, sizeof(copy))) {
+        return;
+    }
+    int err = settings_save_one(WARM_KEY, copy, sizeof(copy));
+    if (err) {
+        LOG_WRN("Tag set not saved (err %d)", err);
+        return;
+    }
+    memcpy(saved, copy, sizeof(saved));
+    atomic_inc(&saves);
+}
+
+static K_WORK_DELAYABLE_DEFINE(save_work, save_work_handler);
+
+void warm_restore(void)
+{
+    // main() runs this; the duty cycle work may already be walking the table
+    tag_lock();
+    for (size_t i = 0; i < ARRAY_SIZE(loaded); i++) {
+        const struct warm_record *r = &loaded[i];
+        if (!r->valid) {
+            continue;
+        }
+        struct aoa_tag *tag = tag_alloc(&r->addr, r->sid, AOA_IQ_SOURCE_PER_ADV);
+        if (!tag) {
+            break;
+        }
+        tag->interval = r->interval;
+
+        // Not lost: the resync statistics only count losses while running
+        tag->state = AOA_TAG_RESYNCING;
+
+        k_spinlock_key_t key = k_spin_lock(&lock);
+        records[tag->id] = *r;
+        k_spin_unlock(&lock, key);
+        atomic_set_bit(&waiting, tag->id);
+        atomic_inc(&restored);
+
+        char addr[BT_ADDR_LE_STR_LEN];
+        bt_addr_le_to_str(&r->addr, addr, sizeof(addr));
+        LOG_INF("Tag %u: restored %s SID %u", tag->id, addr, r->sid);
+    }
+    memcpy(saved, records, sizeof(saved));
+
+    // One list-based create for all of them, before the first scan result arrives
+    resync_kick();
+    tag_unlock();
+}
+
+void warm_synced(const struct aoa_tag *tag)
+{
+    if (tag->source != AOA_IQ_SOURCE_PER_ADV) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    struct warm_record *r = &records[tag->id];
+    // Resyncs and skip changes sync again to the same tag
+    const bool changed = !r->valid || r->interval != tag->interval || r->sid != tag->sid ||
+                         !bt_addr_le_eq(&r->addr, &tag->addr);
+    if (changed) {
+        *r = (struct warm_record){
+            .addr = tag->addr,
+            .sid = tag->sid,
+            .valid = 1,
+            .interval = tag->interval,
+        };
+    }
+    k_spin_unlock(&lock, key);
+
+    if (changed) {
+        k_work_reschedule(&save_work, K_MSEC(SET_SAVE_DELAY_MS));
+    }
+}
+
+void warm_forget(const struct aoa_tag *tag)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    const bool was_valid = records[tag->id].valid;
+    records[tag->id] = (struct warm_record){ 0 };
+    k_spin_unlock(&lock, key);
+
+    // A restored tag that never came back no longer holds up the metric
+    atomic_clear_bit(&waiting, tag->id);
+    if (was_valid) {
+        k_work_reschedule(&save_work, K_MSEC(SET_SAVE_DELAY_MS));
+    }
+}
+
+void warm_result(const struct aoa_angle_result *result)
+{
+    const uint32_t now = k_uptime_get_32();
+
+    atomic_cas(&first_ms, 0, MAX(now, 1));
+    if (result->tag_id >= ARRAY_SIZE(records)) {
+        return;
+    }
+    if (atomic_test_and_clear_bit(&waiting, result->tag_id)) {
+        atomic_inc(&resumed);
+        if (!atomic_get(&waiting)) {
+            atomic_set(&resumed_ms, MAX(now, 1));
+            LOG_INF("Warm start: all %u tags resumed after %u ms",
+                    (unsigned int)atomic_get(&restored), now);
+        }
+    }
+}
+
+void warm_stats_get(struct warm_stats *stats)
+{
+    stats->restored = atomic_get(&restored);
+    stats->resumed = atomic_get(&resumed);
+    stats->first_ms = atomic_get(&first_ms);
+    stats->resumed_ms = atomic_get(&resumed_ms);
+    stats->saves = atomic_get(&saves);
+}
+
+void warm_log_stats(void)
+{
+    struct warm_stats stats;
+
+    warm_stats_get(&stats);
+    LOG_INF("Warm start: %u of %u tags resumed (all by %u ms), first angle at %u ms, "
+            "%u saves", stats.resumed, stats.restored, stats.resumed_ms, stats.first_ms,
+            stats.saves);
+}
+
+static int warm_set(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    if (strcmp(key, "tags")) {
+        return -ENOENT;
+    }
+    if (len % sizeof(struct warm_record)) {
+        LOG_WRN("Saved tag set does not fit this build");
+        return 0;
+    }
+
+    // A build with fewer tags restores the first ones
+    const ssize_t ret = read_cb(cb_arg, loaded, MIN(len, sizeof(loaded)));
+    return ret < 0 ? ret : 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(aoa_warm, "aoa/warm", NULL, warm_set, NULL, NULL);
+
+// Before main() runs warm_restore()
+static int warm_init(void)
+{
+    int err = settings_subsys_init();
+    if (!err) {
+        err = settings_load_subtree("aoa/warm");
+    }
+    if (err) {
+        LOG_ERR("Tag set not loaded (err %d)", err);
+    }
+    return 0;
+}
+
+SYS_INIT(warm_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
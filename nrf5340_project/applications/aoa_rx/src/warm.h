@@ -0,0 +1,79 @@
+#ifndef AOA_RX_WARM_H_
+#define AOA_RX_WARM_H_
+
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+#include "iq_report.h"
+#include "tag.h"
+
+/*
+ * Warm start after a reset or firmware update. The periodic advertising
+ * tags being tracked (address, SID and interval) are kept in settings
+ * under "aoa/warm". At boot they go straight back into the tag table as
+ * tags to resync, so the periodic advertiser list and a list-based sync
+ * create are in place before the first scan result, instead of each tag
+ * waiting to be found by name again.
+ *
+ * The set is saved shortly after it changes, and only then, to spare the
+ * flash.
+ */
+
+struct warm_stats {
+    uint32_t restored;                  // Tags put back at boot
+    uint32_t resumed;                   // Restored tags with an angle since
+    uint32_t first_ms;                  // Uptime at the first angle of any tag, 0 if none yet
+    uint32_t resumed_ms;                // Uptime when every restored tag had an angle, 0 until then
+    uint32_t saves;
+};
+
+#if defined(CONFIG_AOA_RX_WARM_START)
+
+/**
+ * @brief Put the saved tags back in the tag table and start resyncing them.
+ *
+ * Call once from main(), after bt_enable() and before scanning starts.
+ */
+void warm_restore(void);
+
+/** @brief Remember @p tag once its periodic sync is established. Bluetooth RX thread. */
+void warm_synced(const struct aoa_tag *tag);
+
+/** @brief Forget @p tag as it leaves the tag table. */
+void warm_forget(const struct aoa_tag *tag);
+
+/** @brief Track the time to first angle. Runs in the result handler. */
+void warm_result(const struct aoa_angle_result *result);
+
+void warm_stats_get(struct warm_stats *stats);
+
+void warm_log_stats(void);
+
+#else
+
+static inline void warm_restore(void)
+{
+}
+
+static inline void warm_synced(const struct aoa_tag *tag)
+{
+    ARG_UNUSED(tag);
+}
+
+static inline void warm_forget(const struct aoa_tag *tag)
+{
+    ARG_UNUSED(tag);
+}
+
+static inline void warm_result(const struct aoa_angle_result *result)
+{
+    ARG_UNUSED(result);
+}
+
+static inline void warm_log_stats(void)
+{
+}
+
+#endif /* CONFIG_AOA_RX_WARM_START */
+
+#endif /* AOA_RX_WARM_H_ */
@@ -1,45 +1,79 @@
 #include <zephyr/kernel.h>
 #include <zephyr/bluetooth/bluetooth.h>
 #include <zephyr/bluetooth/hci.h>
+#include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/uuid.h>
 #include <zephyr/bluetooth/direction.h>
 #include <zephyr/logging/log.h>
+#if defined(CONFIG_AOA_TX_SHELL)
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/atomic.h>
+#endif
 
 LOG_MODULE_REGISTER(aoa_tx, LOG_LEVEL_DBG);
 
 // Advertising data
 static const struct bt_data ad[] = {
     BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
-    BT_DATA_BYTES(BT_DATA_UUID16_ALL, BT_UUID_16_ENCODE(0x180f)) // Battery Service UUID
+    BT_DATA_BYTES(BT_DATA_UUID16_ALL, BT_UUID_16_ENCODE(0x180f)), // Battery Service UUID
+    BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, (sizeof(CONFIG_BT_DEVICE_NAME) - 1)) // Locators find tags by name
 };
 
+#if defined(CONFIG_AOA_TX_CTE_MODE_CONNLESS)
 // Periodic advertising data
 static const struct bt_data per_ad[] = {
     BT_DATA_BYTES(BT_DATA_NAME_COMPLETE, 'A', 'o', 'A', '_', 'T', 'X')
 };
+#endif
 
 // Declare advertising set
 static struct bt_le_ext_adv *adv_set;
 
-int main(void)
-{
-    int err;
+#if defined(CONFIG_AOA_TX_AOD)
+// Antenna switch codes in switching order; the first CONFIG_AOA_TX_AOD_ANT_COUNT are used
+static uint8_t ant_ids[16] = {
+    0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xa, 0xb, 0xc, 0xd, 0xe, 0xf,
+};
 
-    LOG_INF("Starting AoA TX device with CTE...");
+#define CTE_TYPE (IS_ENABLED(CONFIG_AOA_TX_AOD_SLOT_2US) ? BT_DF_CTE_TYPE_AOD_2US \
+                                                       : BT_DF_CTE_TYPE_AOD_1US)
+#define CTE_ANT_COUNT CONFIG_AOA_TX_AOD_ANT_COUNT
+#define CTE_ANT_IDS ant_ids
+#else
+// AoA: the CTE goes out on one antenna and the locator switches
+#define CTE_TYPE BT_DF_CTE_TYPE_AOA
+#define CTE_ANT_COUNT 0
+#define CTE_ANT_IDS NULL
+#endif
 
-    // Initialize Bluetooth
-    err = bt_enable(NULL);
-    if (err) {
-        LOG_ERR("Bluetooth init failed (err %d)", err);
-        return -1;
-    }
-    LOG_INF("Bluetooth initialized");
+#if defined(CONFIG_AOA_TX_SHELL)
+// Counters for the "tag" shell command; each has one writer and needs no lock. The
+// controller reports no periodic advertising events, so connectionless tags count none.
+static atomic_t started_ms;             // Uptime when CTE transmission started, 0 until then
+static atomic_t connections;
+static atomic_t disconnects;
+static atomic_t last_reason;            // Of the latest disconnect
+static atomic_t cte_errors;             // Connections whose CTE response could not be enabled
+static atomic_t adv_errors;             // Advertising restarts that failed
+
+#define STATS_INC(counter) atomic_inc(&(counter))
+#define STATS_SET(counter, value) atomic_set(&(counter), (value))
+#else
+#define STATS_INC(counter)
+#define STATS_SET(counter, value)
+#endif
+
+#if defined(CONFIG_AOA_TX_CTE_MODE_CONNLESS)
+// Connectionless mode: CTEs ride on every periodic advertising event
+static int per_adv_cte_start(void)
+{
+    int err;
 
     // Create extended advertising set
     err = bt_le_ext_adv_create(BT_LE_EXT_ADV_NCONN, NULL, &adv_set);
     if (err) {
         LOG_ERR("Failed to create advertising set (err %d)", err);
-        return -1;
+        return err;
     }
     LOG_INF("Advertising set created");
 
@@ -47,7 +81,7 @@ int main(void)
     err = bt_le_ext_adv_set_data(adv_set, ad, ARRAY_SIZE(ad), NULL, 0);
     if (err) {
         LOG_ERR("Failed to set advertising data (err %d)", err);
-        return -1;
+        return err;
     }
     LOG_INF("Advertising data set");
 
@@ -61,7 +95,7 @@ int main(void)
     err = bt_le_per_adv_set_param(adv_set, &per_adv_param);
     if (err) {
         LOG_ERR("Failed to set periodic advertising parameters (err %d)", err);
-        return -1;
+        return err;
     }
     LOG_INF("Periodic advertising parameters set");
 
@@ -69,24 +103,24 @@ int main(void)
     err = bt_le_per_adv_set_data(adv_set, per_ad, ARRAY_SIZE(per_ad));
     if (err) {
         LOG_ERR("Failed to set periodic advertising data (err %d)", err);
-        return -1;
+        return err;
     }
     LOG_INF("Periodic advertising data set");
 
     // Configure CTE transmission parameters using CORRECT Zephyr constants
     struct bt_df_adv_cte_tx_param cte_params = {
         .cte_len = 20,                    // Use BT_HCI_LE_CTE_LEN_MAX (20 * 8μs = 160μs)
-        .cte_type = BT_DF_CTE_TYPE_AOA,   // Use proper enum constant (BIT(0) = 1)
+        .cte_type = CTE_TYPE,
         .cte_count = 1,                   // Number of CTEs per advertising event
-        .num_ant_ids = 0,                 // Number of antenna IDs (0 for AoA)
-        .ant_ids = NULL,                  // Antenna switching pattern (NULL for AoA)
+        .num_ant_ids = CTE_ANT_COUNT,     // Number of antenna IDs (0 for AoA)
+        .ant_ids = CTE_ANT_IDS,           // Antenna switching pattern (NULL for AoA)
     };
 
     // Enable CTE transmission for periodic advertising
     err = bt_df_set_adv_cte_tx_param(adv_set, &cte_params);
     if (err) {
         LOG_ERR("Failed to set CTE TX parameters (err %d)", err);
-        return -1;
+        return err;
     }
     LOG_INF("CTE TX parameters set: len=%d, type=%d", cte_params.cte_len, cte_params.cte_type);
 
@@ -94,7 +128,7 @@ int main(void)
     err = bt_df_adv_cte_tx_enable(adv_set);
     if (err) {
         LOG_ERR("Failed to enable CTE TX (err %d)", err);
-        return -1;
+        return err;
     }
     LOG_INF("CTE TX enabled");
 
@@ -102,7 +136,7 @@ int main(void)
     err = bt_le_per_adv_start(adv_set);
     if (err) {
         LOG_ERR("Failed to start periodic advertising (err %d)", err);
-        return -1;
+        return err;
     }
     LOG_INF("Periodic advertising started");
 
@@ -110,10 +144,150 @@ int main(void)
     err = bt_le_ext_adv_start(adv_set, BT_LE_EXT_ADV_START_DEFAULT);
     if (err) {
         LOG_ERR("Failed to start extended advertising (err %d)", err);
-        return -1;
+        return err;
     }
 
     LOG_INF("AoA TX successfully started - broadcasting CTEs");
+    STATS_SET(started_ms, k_uptime_get_32());
+    return 0;
+}
+#endif
+
+#if defined(CONFIG_AOA_TX_CTE_MODE_CONN)
+// Connection mode: advertise connectable and answer the locator's CTE requests
+static void connected(struct bt_conn *conn, uint8_t conn_err)
+{
+    if (conn_err) {
+        LOG_ERR("Connection failed (err 0x%02x)", conn_err);
+        return;
+    }
+    STATS_INC(connections);
+
+    const struct bt_df_conn_cte_tx_param cte_tx_param = {
+        .cte_types = CTE_TYPE,
+        .num_ant_ids = CTE_ANT_COUNT,     // 0 for AoA
+        .ant_ids = CTE_ANT_IDS,           // NULL for AoA
+    };
+
+    int err = bt_df_set_conn_cte_tx_param(conn, &cte_tx_param);
+    if (err) {
+        LOG_ERR("Failed to set connection CTE TX parameters (err %d)", err);
+        STATS_INC(cte_errors);
+        return;
+    }
+
+    err = bt_df_conn_cte_rsp_enable(conn);
+    if (err) {
+        LOG_ERR("Failed to enable CTE response (err %d)", err);
+        STATS_INC(cte_errors);
+        return;
+    }
+    LOG_INF("Locator connected - answering CTE requests");
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    LOG_INF("Locator disconnected (reason 0x%02x)", reason);
+    STATS_INC(disconnects);
+    STATS_SET(last_reason, reason);
+}
+
+static void recycled(void)
+{
+    // The advertising set stops on connection; resume once the link is freed
+    int err = bt_le_ext_adv_start(adv_set, BT_LE_EXT_ADV_START_DEFAULT);
+    if (err) {
+        LOG_ERR("Failed to restart advertising (err %d)", err);
+        STATS_INC(adv_errors);
+    }
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .recycled = recycled,
+};
+
+static int conn_cte_start(void)
+{
+    int err;
+
+    err = bt_le_ext_adv_create(BT_LE_EXT_ADV_CONN, NULL, &adv_set);
+    if (err) {
+        LOG_ERR("Failed to create advertising set (err %d)", err);
+        return err;
+    }
+
+    err = bt_le_ext_adv_set_data(adv_set, ad, ARRAY_SIZE(ad), NULL, 0);
+    if (err) {
+        LOG_ERR("Failed to set advertising data (err %d)", err);
+        return err;
+    }
+
+    err = bt_le_ext_adv_start(adv_set, BT_LE_EXT_ADV_START_DEFAULT);
+    if (err) {
+        LOG_ERR("Failed to start extended advertising (err %d)", err);
+        return err;
+    }
+
+    LOG_INF("AoA TX successfully started - waiting for CTE requests");
+    STATS_SET(started_ms, k_uptime_get_32());
+    return 0;
+}
+#endif
+
+#if defined(CONFIG_AOA_TX_SHELL)
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    const uint32_t started = atomic_get(&started_ms);
+
+    if (!started) {
+        shell_print(sh, "CTE transmission not started");
+        return 0;
+    }
+    shell_print(sh, "Mode: %s, %s over %u antennas",
+                IS_ENABLED(CONFIG_AOA_TX_CTE_MODE_CONN) ? "connection" : "connectionless",
+                IS_ENABLED(CONFIG_AOA_TX_AOD) ? "AoD" : "AoA", MAX(CTE_ANT_COUNT, 1));
+    shell_print(sh, "Transmitting for %u s", (k_uptime_get_32() - started) / 1000);
+#if defined(CONFIG_AOA_TX_CTE_MODE_CONN)
+    shell_print(sh, "Connections: %u, disconnects: %u (last reason 0x%02x)",
+                (uint32_t)atomic_get(&connections), (uint32_t)atomic_get(&disconnects),
+                (uint32_t)atomic_get(&last_reason));
+    shell_print(sh, "CTE response failures: %u, advertising restart failures: %u",
+                (uint32_t)atomic_get(&cte_errors), (uint32_t)atomic_get(&adv_errors));
+#endif
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(tag_cmds,
+    SHELL_CMD(stats, NULL, "CTE transmission counters", cmd_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(tag, &tag_cmds, "AoA tag", NULL);
+#endif
+
+int main(void)
+{
+    int err;
+
+    LOG_INF("Starting AoA TX device with CTE...");
+
+    // Initialize Bluetooth
+    err = bt_enable(NULL);
+    if (err) {
+        LOG_ERR("Bluetooth init failed (err %d)", err);
+        return -1;
+    }
+    LOG_INF("Bluetooth initialized");
+
+#if defined(CONFIG_AOA_TX_CTE_MODE_CONN)
+    err = conn_cte_start();
+#else
+    err = per_adv_cte_start();
+#endif
+    if (err) {
+        return -1;
+    }
 
     // Keep the application running
     while (1) {
@@ -0,0 +1,639 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <aoa/calib.h>
+#include <aoa/dsp.h>
+#include <aoa/frame.h>
+#include <aoa/record.h>
+#include <aoa/simd.h>
+
+/*
+ * Synthesize CTE reports from tags at known angles, time the configured
+ * pipeline on them and report its accuracy. Tags sit at random angles
+ * with a random carrier offset and hop over the data channels; the IQ
+ * samples are quantized to the controller's 8-bit range after adding
+ * white noise at the given SNR.
+ *
+ *   aoa_bench [-n reports] [-t tags] [-s snr_db] [-r seed] [-k kernels] [-w file [-F] [-z]]
+ *
+ * With -w the synthesized reports are also written as a record stream for
+ * aoa_replay, or with -F framed as a thin locator sends them, for
+ * aoa_server. -z writes packed IQ records. Either way the bench reports
+ * how well the reports pack and how fast they pack and unpack, and checks
+ * that packed and framed records decode to the reports again.
+ *
+ * Host builds with vector kernels (AOA_CORE_SIMD) run on the best the CPU
+ * supports, or those named with -k. The bench checks them against the
+ * scalar reference, then runs the pipeline again on the reference to
+ * compare speed and angles. Every build checks the packed Q15 kernels of
+ * the fixed-point paths against plain C, bit for bit. Last, a calibration
+ * of the ideal array has to leave it alone, and the array gets random
+ * offsets per element and channel, which a calibration on a reference tag
+ * has to remove.
+ */
+
+#define AMPLITUDE 100.0
+#define CFO_MAX_HZ 50e3
+
+struct synth_tag {
+    double azimuth;
+    double elevation;
+    double cfo;                 // rad/us
+    uint16_t event_counter;
+};
+
+// Per-channel gain and phase of each element, when the synthetic array is not ideal
+static struct {
+    bool on;
+    double gain[AOA_CALIB_CHANNELS][AOA_ANT_COUNT];
+    double phase[AOA_CALIB_CHANNELS][AOA_ANT_COUNT];
+} offsets;
+
+static uint64_t rng_state;
+
+static uint64_t rng_next(void)
+{
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+static double rng_uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * (rng_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double rng_gauss(void)
+{
+    const double u = rng_uniform(1e-12, 1.0);
+    const double v = rng_uniform(0.0, 2.0 * M_PI);
+    return sqrt(-2.0 * log(u)) * cos(v);
+}
+
+static void tag_init(struct synth_tag *tag)
+{
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    tag->azimuth = rng_uniform(-180.0, 180.0);
+    tag->elevation = rng_uniform(15.0, 75.0);
+#else
+    tag->azimuth = rng_uniform(-60.0, 60.0);
+    tag->elevation = 0.0;
+#endif
+    tag->cfo = 2.0 * M_PI * rng_uniform(-CFO_MAX_HZ, CFO_MAX_HZ) * 1e-6;
+    tag->event_counter = rng_next();
+}
+
+static int16_t quantize(double v)
+{
+    return (int16_t)fmax(-128.0, fmin(127.0, lround(v)));
+}
+
+static void synthesize(struct synth_tag *tag, uint8_t tag_id, double noise,
+                       struct aoa_iq_report *report)
+{
+    const double az = tag->azimuth * M_PI / 180.0;
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    const double el = tag->elevation * M_PI / 180.0;
+    const double u = cos(el) * cos(az);
+    const double v = cos(el) * sin(az);
+#else
+    const double u = sin(az);
+    const double v = 0.0;
+#endif
+
+    report->timestamp = tag->event_counter * 1000u;
+    report->event_counter = tag->event_counter++;
+    report->rssi = -600;
+    report->source = AOA_IQ_SOURCE_PER_ADV;
+    report->tag_id = tag_id;
+    report->generation = 0;
+    report->chan_idx = rng_next() % 37;
+    report->slot_durations = AOA_SLOT_DURATION;
+    report->packet_status = 0;
+    report->sample_count = AOA_IQ_SAMPLES_MAX;
+
+    const double lambda = SPEED_OF_LIGHT / (chan_freq_mhz(report->chan_idx) * 1e6);
+    const double k = 2.0 * M_PI * AOA_ANT_SPACING_UM * 1e-6 / lambda;
+    const double phase0 = rng_uniform(0.0, 2.0 * M_PI);
+
+    for (int n = 0; n < report->sample_count; n++) {
+        const int ant = aoa_sample_ant(n);
+        const double gain = offsets.on ? offsets.gain[report->chan_idx][ant] : 1.0;
+        const double phase = k * ((ant % AOA_ANT_COLS) * u + (ant / AOA_ANT_COLS) * v) +
+                             tag->cfo * aoa_sample_time_us(n) + phase0 +
+                             (offsets.on ? offsets.phase[report->chan_idx][ant] : 0.0);
+        report->samples[n].i = quantize(gain * AMPLITUDE * cos(phase) + noise * rng_gauss());
+        report->samples[n].q = quantize(gain * AMPLITUDE * sin(phase) + noise * rng_gauss());
+    }
+}
+
+static int chunk_write(FILE *out, const uint8_t *buf, int len, bool framed)
+{
+    uint8_t frame[AOA_FRAME_SIZE_MAX];
+
+    if (len < 0) {
+        return len;
+    }
+    if (framed) {
+        len = aoa_frame_encode(buf, len, frame, sizeof(frame));
+        buf = frame;
+    }
+    return len >= 0 && fwrite(buf, 1, len, out) == (size_t)len ? 0 : -EIO;
+}
+
+static int stream_write(FILE *out, const struct aoa_iq_report *reports, int count, bool framed,
+                        bool packed)
+{
+    uint8_t buf[AOA_RECORD_IQ_SIZE_MAX];
+    int err = chunk_write(out, buf, aoa_record_header_encode(buf, sizeof(buf)), framed);
+
+    for (int i = 0; !err && i < count; i++) {
+        const int len = packed ? aoa_record_encode_iq_packed(&reports[i], buf, sizeof(buf))
+                               : aoa_record_encode_iq(&reports[i], buf, sizeof(buf));
+        err = chunk_write(out, buf, len, framed);
+    }
+    return err;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static bool report_equal(const struct aoa_iq_report *a, const struct aoa_iq_report *b)
+{
+    return a->timestamp == b->timestamp && a->event_counter == b->event_counter &&
+           a->rssi == b->rssi && a->source == b->source && a->tag_id == b->tag_id &&
+           a->chan_idx == b->chan_idx && a->slot_durations == b->slot_durations &&
+           a->packet_status == b->packet_status && a->sample_count == b->sample_count &&
+           !memcmp(a->samples, b->samples, a->sample_count * sizeof(a->samples[0]));
+}
+
+// Size of packed against plain IQ records, and the time to pack and unpack them
+static int pack_bench(const struct aoa_iq_report *reports, int count)
+{
+    uint8_t *buf = malloc((size_t)count * AOA_RECORD_IQ_SIZE_MAX);
+    if (!buf) {
+        return -ENOMEM;
+    }
+
+    size_t plain = 0;
+    uint8_t scratch[AOA_RECORD_IQ_SIZE_MAX];
+    for (int i = 0; i < count; i++) {
+        plain += aoa_record_encode_iq(&reports[i], scratch, sizeof(scratch));
+    }
+
+    size_t packed = 0;
+    const double start = now_us();
+    for (int i = 0; i < count; i++) {
+        packed += aoa_record_encode_iq_packed(&reports[i], &buf[packed], AOA_RECORD_IQ_SIZE_MAX);
+    }
+    const double pack_us = now_us() - start;
+
+    static struct aoa_record record;
+    size_t pos = 0;
+    const double unpack_start = now_us();
+    for (int i = 0; i < count; i++) {
+        const int len = aoa_record_decode(&buf[pos], packed - pos, &record);
+        if (len <= 0) {
+            break;
+        }
+        pos += len;
+    }
+    const double unpack_us = now_us() - unpack_start;
+
+    bool lossless = true;
+    pos = 0;
+    for (int i = 0; i < count && lossless; i++) {
+        const int len = aoa_record_decode(&buf[pos], packed - pos, &record);
+        lossless = len > 0 && record.type == AOA_RECORD_IQ && report_equal(&record.iq, &reports[i]);
+        pos += len;
+    }
+    free(buf);
+
+    printf("IQ records: %.1f bytes plain, %.1f packed (%.0f%%), %.2f us to pack, %.2f us to unpack\n",
+           (double)plain / count, (double)packed / count, 100.0 * packed / plain, pack_us / count,
+           unpack_us / count);
+    if (!lossless) {
+        printf("Packed records do not unpack to the reports\n");
+        return -EBADMSG;
+    }
+    return 0;
+}
+
+// Every record framed as a thin locator sends it, then unframed and decoded again
+static int frame_bench(const struct aoa_iq_report *reports, int count)
+{
+    static struct aoa_record record;
+    struct aoa_frame_decoder dec;
+    uint8_t buf[AOA_RECORD_IQ_SIZE_MAX];
+    uint8_t frame[AOA_FRAME_SIZE_MAX];
+    size_t payload = 0;
+    size_t framed = 0;
+    int lost = 0;
+
+    aoa_frame_decoder_init(&dec);
+    for (int i = 0; i < count; i++) {
+        const int len = aoa_record_encode_iq(&reports[i], buf, sizeof(buf));
+        const int frame_len = aoa_frame_encode(buf, len, frame, sizeof(frame));
+        const uint8_t *out;
+        size_t consumed;
+
+        if (len <= 0 || frame_len <= 0 ||
+            aoa_frame_decode(&dec, frame, frame_len, &consumed, &out) != len ||
+            consumed != (size_t)frame_len || aoa_record_decode(out, len, &record) != len ||
+            record.type != AOA_RECORD_IQ || !report_equal(&record.iq, &reports[i])) {
+            lost++;
+            aoa_frame_decoder_init(&dec);
+            continue;
+        }
+        payload += len;
+        framed += frame_len;
+    }
+
+    printf("Frames: %.1f bytes of framing per record, %d of %d records not decoded again\n",
+           count > lost ? (double)(framed - payload) / (count - lost) : 0.0, lost, count);
+    return lost ? -EBADMSG : 0;
+}
+
+static int q15_bench(void)
+{
+    struct aoa_q15_timing timing;
+    const int err = aoa_q15_check(now_ns, &timing);
+
+    printf("Q15 kernels (%s): %s the plain C reference, %.1f us against %.1f us\n",
+           timing.dsp ? "DSP extension" : "portable", err ? "differ from" : "bit-exact with",
+           timing.kernels * 1e-3, timing.reference * 1e-3);
+    return err;
+}
+
+static double azimuth_error(double estimate, double truth)
+{
+    double d = estimate - truth;
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    d = fmod(d + 540.0, 360.0) - 180.0;
+#endif
+    return d;
+}
+
+// RMS angle errors of the accepted results; returns how many were accepted
+static int rms_error(const struct synth_tag *tags, const struct aoa_angle_result *results,
+                     const int *status, int count, double *az_rms, double *el_rms)
+{
+    double az_sq = 0.0;
+    double el_sq = 0.0;
+    int ok = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (status[i]) {
+            continue;
+        }
+        const struct synth_tag *tag = &tags[results[i].tag_id];
+        const double az = azimuth_error(results[i].azimuth, tag->azimuth);
+        const double el = results[i].elevation - tag->elevation;
+        az_sq += az * az;
+        el_sq += el * el;
+        ok++;
+    }
+    *az_rms = ok ? sqrt(az_sq / ok) : 0.0;
+    *el_rms = ok ? sqrt(el_sq / ok) : 0.0;
+    return ok;
+}
+
+// Reference reports per channel, and reports to compare estimates on
+#define CALIB_REPORTS 64
+#define CALIB_TEST_REPORTS 4000
+
+// Weights solved for an ideal array may be this far from 1 + 0j
+#define CALIB_IDEAL_ERROR_MAX 0.01
+
+static void calib_ref_init(struct synth_tag *ref)
+{
+    tag_init(ref);
+    ref->azimuth = 20.0;
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    ref->elevation = 45.0;
+#endif
+}
+
+// An ideal array, measured without noise, needs no correction: every weight solves to one
+static int calib_ideal(void)
+{
+    static struct aoa_calib_acc acc;
+    struct aoa_iq_sample w[AOA_ANT_COUNT];
+    struct aoa_iq_report report;
+    struct synth_tag ref;
+    double largest = 0.0;
+
+    calib_ref_init(&ref);
+    for (int i = 0; i < 37 * CALIB_REPORTS; i++) {
+        synthesize(&ref, 0, 0.0, &report);
+        aoa_calib_measure(&acc, &report);
+    }
+    // The tag hops over the data channels only
+    for (int c = 0; c < 37; c++) {
+        if (aoa_calib_solve(&acc, c, ref.azimuth, ref.elevation, w)) {
+            largest = INFINITY;
+            break;
+        }
+        for (int m = 0; m < AOA_ANT_COUNT; m++) {
+            largest = fmax(largest, hypot((double)w[m].i / AOA_CALIB_ONE - 1.0,
+                                          (double)w[m].q / AOA_CALIB_ONE));
+        }
+    }
+
+    printf("Calibration of an ideal array: weights within %.3f of one\n", largest);
+    if (largest > CALIB_IDEAL_ERROR_MAX) {
+        printf("An ideal array does not calibrate to unit weights\n");
+        return -EDOM;
+    }
+    return 0;
+}
+
+/*
+ * Give the synthetic array random gain and phase offsets per element and
+ * channel, calibrate them away on a reference tag, and compare the angle
+ * error on other tags with and without the weights.
+ */
+static int calib_bench(int tag_count, double noise)
+{
+    static struct aoa_calib_acc acc;
+    static struct aoa_calib calib;
+    static struct aoa_state plain;
+    static struct aoa_state calibrated;
+    struct synth_tag tags[CONFIG_AOA_RX_MAX_TAGS];
+    struct aoa_iq_report report;
+
+    for (int c = 0; c < AOA_CALIB_CHANNELS; c++) {
+        for (int m = 0; m < AOA_ANT_COUNT; m++) {
+            offsets.gain[c][m] = rng_uniform(0.8, 1.2);
+            offsets.phase[c][m] = rng_uniform(-M_PI / 3.0, M_PI / 3.0);
+        }
+    }
+    offsets.on = true;
+
+    struct synth_tag ref;
+    calib_ref_init(&ref);
+    const int ref_reports = 37 * CALIB_REPORTS;
+    for (int i = 0; i < ref_reports; i++) {
+        synthesize(&ref, 0, noise, &report);
+        aoa_calib_measure(&acc, &report);
+    }
+    aoa_calib_reset(&calib);
+    for (int c = 0; c < AOA_CALIB_CHANNELS; c++) {
+        if (!aoa_calib_solve(&acc, c, ref.azimuth, ref.elevation, calib.w[c])) {
+            calib.channels |= 1ull << c;
+        }
+    }
+    calibrated.calib = &calib;
+
+    struct aoa_angle_result *results = calloc(2 * CALIB_TEST_REPORTS, sizeof(*results));
+    int *status = calloc(2 * CALIB_TEST_REPORTS, sizeof(*status));
+    if (!results || !status) {
+        free(status);
+        free(results);
+        return -ENOMEM;
+    }
+    for (int t = 0; t < tag_count; t++) {
+        tag_init(&tags[t]);
+    }
+    for (int i = 0; i < CALIB_TEST_REPORTS; i++) {
+        synthesize(&tags[i % tag_count], i % tag_count, noise, &report);
+        status[i] = aoa_process(&plain, &report, false, &results[i]);
+        status[CALIB_TEST_REPORTS + i] =
+            aoa_process(&calibrated, &report, false, &results[CALIB_TEST_REPORTS + i]);
+    }
+    offsets.on = false;
+
+    double az_plain, el_plain, az_cal, el_cal;
+    rms_error(tags, results, status, CALIB_TEST_REPORTS, &az_plain, &el_plain);
+    rms_error(tags, &results[CALIB_TEST_REPORTS], &status[CALIB_TEST_REPORTS], CALIB_TEST_REPORTS,
+              &az_cal, &el_cal);
+    printf("Calibration: %d channels from %d reference reports; with offsets, RMS azimuth error "
+           "%.2f deg uncalibrated, %.2f deg calibrated\n",
+           __builtin_popcountll(calib.channels), ref_reports, az_plain, az_cal);
+
+    free(status);
+    free(results);
+    return calib.channels ? 0 : -ENODATA;
+}
+
+#if defined(AOA_CORE_SIMD)
+
+// Kernel output may differ from the scalar reference by this much, relative
+#define KERNEL_ERROR_MAX 1e-4f
+
+// Angles this close count as the same
+#define ANGLE_AGREE_DEG 0.1
+
+/*
+ * The kernels in use against the scalar reference: their outputs on random
+ * input, then the whole pipeline run again on the reference.
+ */
+static int simd_bench(const struct aoa_iq_report *reports, const struct aoa_angle_result *results,
+                      const int *status, int count, double elapsed)
+{
+    const enum aoa_simd simd = aoa_simd_get();
+
+    if (simd == AOA_SIMD_SCALAR) {
+        printf("Kernels: scalar\n");
+        return 0;
+    }
+
+    float error;
+    aoa_simd_check(simd, &error);
+    printf("Kernels: %s, within %.1e of the scalar reference\n", aoa_simd_name(simd), error);
+
+    struct aoa_angle_result *ref = calloc(count, sizeof(*ref));
+    if (!ref) {
+        return -ENOMEM;
+    }
+
+    static struct aoa_state state;
+    int differ = 0;
+    double largest = 0.0;
+
+    aoa_simd_set(AOA_SIMD_SCALAR);
+    const double start = now_us();
+    for (int i = 0; i < count; i++) {
+        if (aoa_process(&state, &reports[i], false, &ref[i]) != status[i]) {
+            differ++;
+        }
+    }
+    const double ref_elapsed = now_us() - start;
+    aoa_simd_set(simd);
+
+    for (int i = 0; i < count; i++) {
+        if (status[i]) {
+            continue;
+        }
+        const double d = fmax(fabs(azimuth_error(results[i].azimuth, ref[i].azimuth)),
+                              fabs(results[i].elevation - ref[i].elevation));
+        largest = fmax(largest, d);
+        if (d > ANGLE_AGREE_DEG) {
+            differ++;
+        }
+    }
+    free(ref);
+
+    printf("Scalar kernels: %.2f us per report (%.2fx); %d of %d angles differ by over %.1f deg, "
+           "at most %.3f deg\n",
+           ref_elapsed / count, ref_elapsed / elapsed, differ, count, ANGLE_AGREE_DEG, largest);
+    if (error > KERNEL_ERROR_MAX) {
+        printf("Kernels disagree with the scalar reference\n");
+        return -EDOM;
+    }
+    return 0;
+}
+
+#endif /* AOA_CORE_SIMD */
+
+int main(int argc, char **argv)
+{
+    int count = 10000;
+    int tag_count = 4;
+    double snr_db = 20.0;
+    const char *path = NULL;
+    bool framed = false;
+    bool packed = false;
+    int kernels = -1;
+    int opt;
+
+    rng_state = 1;
+    while ((opt = getopt(argc, argv, "n:t:s:r:k:w:Fz")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = atoi(optarg);
+            break;
+        case 't':
+            tag_count = atoi(optarg);
+            break;
+        case 's':
+            snr_db = atof(optarg);
+            break;
+        case 'r':
+            rng_state = strtoull(optarg, NULL, 0) | 1;
+            break;
+        case 'k':
+#if defined(AOA_CORE_SIMD)
+            for (enum aoa_simd simd = AOA_SIMD_SCALAR; simd <= AOA_SIMD_NEON; simd++) {
+                if (!strcmp(optarg, aoa_simd_name(simd))) {
+                    kernels = simd;
+                }
+            }
+#endif
+            if (kernels < 0) {
+                fprintf(stderr, "No %s kernels in this build\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'w':
+            path = optarg;
+            break;
+        case 'F':
+            framed = true;
+            break;
+        case 'z':
+            packed = true;
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [-n reports] [-t tags] [-s snr_db] [-r seed] [-k kernels] "
+                    "[-w file [-F] [-z]]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (count < 1 || tag_count < 1 || tag_count > CONFIG_AOA_RX_MAX_TAGS) {
+        fprintf(stderr, "Need at least one report and 1..%d tags\n", CONFIG_AOA_RX_MAX_TAGS);
+        return EXIT_FAILURE;
+    }
+
+#if defined(AOA_CORE_SIMD)
+    if (kernels >= 0 && aoa_simd_set(kernels)) {
+        fprintf(stderr, "No %s kernels on this CPU\n", aoa_simd_name(kernels));
+        return EXIT_FAILURE;
+    }
+#endif
+
+    struct synth_tag tags[CONFIG_AOA_RX_MAX_TAGS];
+    for (int t = 0; t < tag_count; t++) {
+        tag_init(&tags[t]);
+    }
+
+    // Noise per IQ component for the SNR of a complex sample
+    const double noise = AMPLITUDE / sqrt(2.0 * pow(10.0, snr_db / 10.0));
+
+    struct aoa_iq_report *reports = calloc(count, sizeof(*reports));
+    struct aoa_angle_result *results = calloc(count, sizeof(*results));
+    int *status = calloc(count, sizeof(*status));
+    if (!reports || !results || !status) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < count; i++) {
+        synthesize(&tags[i % tag_count], i % tag_count, noise, &reports[i]);
+    }
+
+    if (path) {
+        FILE *out = fopen(path, "wb");
+        if (!out) {
+            perror(path);
+            return EXIT_FAILURE;
+        }
+        const int err = stream_write(out, reports, count, framed, packed);
+        fclose(out);
+        if (err) {
+            fprintf(stderr, "Failed to write %s (err %d)\n", path, err);
+            return EXIT_FAILURE;
+        }
+    }
+
+    static struct aoa_state state;
+    const double start = now_us();
+    for (int i = 0; i < count; i++) {
+        status[i] = aoa_process(&state, &reports[i], false, &results[i]);
+    }
+    const double elapsed = now_us() - start;
+
+    double az_rms, el_rms;
+    const int ok = rms_error(tags, results, status, count, &az_rms, &el_rms);
+
+    printf("%d reports from %d tags at %.1f dB SNR, %d rejected\n", count, tag_count, snr_db,
+           count - ok);
+    printf("%.2f us per report, %.0f reports/s\n", elapsed / count, count * 1e6 / elapsed);
+    if (ok) {
+        printf("RMS error: azimuth %.2f deg, elevation %.2f deg\n", az_rms, el_rms);
+    }
+    int err = pack_bench(reports, count);
+    err = err ? err : frame_bench(reports, count);
+    err = err ? err : q15_bench();
+#if defined(AOA_CORE_SIMD)
+    err = err ? err : simd_bench(reports, results, status, count, elapsed);
+#endif
+    err = err ? err : calib_ideal();
+    err = err ? err : calib_bench(tag_count, noise);
+
+    free(status);
+    free(results);
+    free(reports);
+    return err ? EXIT_FAILURE : EXIT_SUCCESS;
+}
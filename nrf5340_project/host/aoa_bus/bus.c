@@ -0,0 +1,311 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bus.h"
+
+#define BUS_MAGIC 0x41424553u           // "ABES"
+#define BUS_VERSION 1
+
+#define RECORD_WORDS (sizeof(struct aoa_bus_record) / sizeof(uint64_t))
+
+// A lapped reader lands this far behind the writer, so it is not lapped again at once
+#define RESYNC_DIV 2
+
+/*
+ * The writer wakes sleeping readers at most this often, so its cost per
+ * record does not grow with the readers however fast it publishes, and
+ * sleeping readers look for records at least this often. A record after
+ * a quiet spell still wakes them at once.
+ */
+#define WAKE_PERIOD_US 1000
+
+struct bus_header {
+    uint32_t magic;                     // Written last when formatting
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;
+    uint64_t head;                      // Next sequence number; written by the writer only
+    uint32_t wake;                      // Futex word, bumped to wake sleeping readers
+    uint32_t sleepers;                  // Readers in aoa_bus_wait()
+} __attribute__((aligned(64)));
+
+// The mark is 2 * seq + 2 once record seq is complete, odd while it is written
+struct bus_slot {
+    uint64_t mark;
+    uint64_t words[RECORD_WORDS];
+} __attribute__((aligned(64)));
+
+struct bus_map {
+    struct bus_header *header;
+    struct bus_slot *slots;
+    size_t size;
+};
+
+struct aoa_bus {
+    struct bus_map map;
+    uint64_t woken_us;                  // time_us of the last wake
+};
+
+struct aoa_bus_reader {
+    struct bus_map map;
+    uint32_t capacity;                  // At attach, with map.size; never the header's live value
+    uint64_t next;                      // Sequence number of the next record to read
+};
+
+_Static_assert(sizeof(struct aoa_bus_record) % sizeof(uint64_t) == 0,
+               "records are copied in 64-bit words");
+
+static size_t bus_size(uint32_t capacity)
+{
+    return sizeof(struct bus_header) + (size_t)capacity * sizeof(struct bus_slot);
+}
+
+static int futex(uint32_t *word, int op, uint32_t val, const struct timespec *timeout)
+{
+    // Not FUTEX_PRIVATE_FLAG: the word is shared between processes
+    return syscall(SYS_futex, word, op, val, timeout, NULL, 0);
+}
+
+static int bus_map(struct bus_map *map, int fd, size_t size)
+{
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        return -errno;
+    }
+    map->header = mem;
+    map->slots = (struct bus_slot *)(map->header + 1);
+    map->size = size;
+    return 0;
+}
+
+static bool layout_matches(const struct bus_header *header, uint32_t capacity)
+{
+    return header->magic == BUS_MAGIC && header->version == BUS_VERSION &&
+           header->record_size == sizeof(struct aoa_bus_record) && header->capacity == capacity;
+}
+
+struct aoa_bus *aoa_bus_create(const char *name, uint32_t capacity)
+{
+    if (!capacity || (capacity & (capacity - 1))) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    struct aoa_bus *bus = calloc(1, sizeof(*bus));
+    if (!bus) {
+        return NULL;
+    }
+    const int fd = shm_open(name, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        free(bus);
+        return NULL;
+    }
+
+    // Keep the size of a ring readers may have mapped, unless it is to be reformatted
+    struct stat st;
+    const size_t size = bus_size(capacity);
+    int err = fstat(fd, &st) ? -errno : 0;
+    if (!err && (size_t)st.st_size != size && ftruncate(fd, size)) {
+        err = -errno;
+    }
+    if (!err) {
+        err = bus_map(&bus->map, fd, size);
+    }
+    close(fd);
+    if (err) {
+        free(bus);
+        errno = -err;
+        return NULL;
+    }
+
+    struct bus_header *header = bus->map.header;
+    if (!layout_matches(header, capacity)) {
+        __atomic_store_n(&header->magic, 0, __ATOMIC_RELAXED);
+        memset(bus->map.slots, 0, (size_t)capacity * sizeof(struct bus_slot));
+        header->version = BUS_VERSION;
+        header->record_size = sizeof(struct aoa_bus_record);
+        header->capacity = capacity;
+        __atomic_store_n(&header->head, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&header->magic, BUS_MAGIC, __ATOMIC_RELEASE);
+    }
+    return bus;
+}
+
+void aoa_bus_publish(struct aoa_bus *bus, struct aoa_bus_record *record)
+{
+    struct bus_header *header = bus->map.header;
+    const uint64_t seq = __atomic_load_n(&header->head, __ATOMIC_RELAXED);
+    struct bus_slot *slot = &bus->map.slots[seq & (header->capacity - 1)];
+    struct timespec ts;
+    uint64_t words[RECORD_WORDS];
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    record->seq = seq;
+    record->time_us = ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+    memcpy(words, record, sizeof(words));
+
+    // Odd mark first: a reader that sees any of the new words sees it change
+    __atomic_store_n(&slot->mark, 2 * seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (size_t i = 0; i < RECORD_WORDS; i++) {
+        __atomic_store_n(&slot->words[i], words[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&slot->mark, 2 * seq + 2, __ATOMIC_RELEASE);
+
+    // Ordered with the sleeper count, against aoa_bus_wait()
+    __atomic_store_n(&header->head, seq + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header->sleepers, __ATOMIC_SEQ_CST) &&
+        record->time_us - bus->woken_us >= WAKE_PERIOD_US) {
+        bus->woken_us = record->time_us;
+        __atomic_add_fetch(&header->wake, 1, __ATOMIC_SEQ_CST);
+        futex(&header->wake, FUTEX_WAKE, INT_MAX, NULL);
+    }
+}
+
+void aoa_bus_close(struct aoa_bus *bus)
+{
+    munmap(bus->map.header, bus->map.size);
+    free(bus);
+}
+
+struct aoa_bus_reader *aoa_bus_attach(const char *name, bool oldest)
+{
+    struct aoa_bus_reader *reader = calloc(1, sizeof(*reader));
+    if (!reader) {
+        return NULL;
+    }
+    const int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        free(reader);
+        return NULL;
+    }
+
+    // The header first, for the size of the rest
+    struct stat st;
+    int err = fstat(fd, &st) ? -errno : 0;
+    if (!err && (size_t)st.st_size < sizeof(struct bus_header)) {
+        err = -EAGAIN;
+    }
+    if (!err) {
+        err = bus_map(&reader->map, fd, st.st_size);
+    }
+    close(fd);
+
+    // The capacity is read once: the mapping is only checked against that value
+    const struct bus_header *header = reader->map.header;
+    if (!err) {
+        const bool formatted = __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == BUS_MAGIC;
+
+        reader->capacity = __atomic_load_n(&header->capacity, __ATOMIC_RELAXED);
+        if (!formatted || header->version != BUS_VERSION ||
+            header->record_size != sizeof(struct aoa_bus_record) ||
+            reader->map.size < bus_size(reader->capacity)) {
+            munmap(reader->map.header, reader->map.size);
+            err = -EPROTO;
+        }
+    }
+    if (err) {
+        free(reader);
+        errno = -err;
+        return NULL;
+    }
+
+    const uint64_t head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+    reader->next = oldest && head > reader->capacity ? head - reader->capacity :
+                   oldest ? 0 : head;
+    return reader;
+}
+
+// A writer formatted the ring again with another layout, which may not fit the mapping
+static bool reader_stale(const struct aoa_bus_reader *reader)
+{
+    const struct bus_header *header = reader->map.header;
+
+    return __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != BUS_MAGIC ||
+           __atomic_load_n(&header->capacity, __ATOMIC_RELAXED) != reader->capacity;
+}
+
+int aoa_bus_read(struct aoa_bus_reader *reader, struct aoa_bus_record *record, uint64_t *lost)
+{
+    const struct bus_header *header = reader->map.header;
+    const uint32_t capacity = reader->capacity;
+
+    *lost = 0;
+    while (1) {
+        if (reader_stale(reader)) {
+            return -EPROTO;
+        }
+        const uint64_t head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+        if (reader->next >= head) {
+            // Past the head only if the ring was formatted again
+            reader->next = head;
+            return 0;
+        }
+        if (head - reader->next > capacity) {
+            const uint64_t next = head - capacity / RESYNC_DIV;
+            *lost += next - reader->next;
+            reader->next = next;
+        }
+
+        const struct bus_slot *slot = &reader->map.slots[reader->next & (capacity - 1)];
+        const uint64_t mark = __atomic_load_n(&slot->mark, __ATOMIC_ACQUIRE);
+        uint64_t words[RECORD_WORDS];
+
+        for (size_t i = 0; i < RECORD_WORDS; i++) {
+            words[i] = __atomic_load_n(&slot->words[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (mark == 2 * reader->next + 2 &&
+            __atomic_load_n(&slot->mark, __ATOMIC_RELAXED) == mark) {
+            memcpy(record, words, sizeof(words));
+            reader->next++;
+            return 1;
+        }
+
+        // Overwritten while the reader got here; the head tells how far to skip
+        const uint64_t next = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE) -
+                              capacity / RESYNC_DIV;
+        const uint64_t skip = next > reader->next ? next : reader->next + 1;
+        *lost += skip - reader->next;
+        reader->next = skip;
+    }
+}
+
+int aoa_bus_wait(struct aoa_bus_reader *reader, int timeout_ms)
+{
+    struct bus_header *header = reader->map.header;
+    const struct timespec period = { .tv_nsec = WAKE_PERIOD_US * 1000L };
+    int err = -ETIMEDOUT;
+
+    // Slices of one wake period: the writer may have skipped a wake within one
+    __atomic_add_fetch(&header->sleepers, 1, __ATOMIC_SEQ_CST);
+    for (long waited_us = 0; waited_us < timeout_ms * 1000L; waited_us += WAKE_PERIOD_US) {
+        const uint32_t wake = __atomic_load_n(&header->wake, __ATOMIC_SEQ_CST);
+        if (reader_stale(reader)) {
+            err = -EPROTO;
+            break;
+        }
+        if (__atomic_load_n(&header->head, __ATOMIC_SEQ_CST) > reader->next) {
+            err = 0;
+            break;
+        }
+        futex(&header->wake, FUTEX_WAIT, wake, &period);
+    }
+    __atomic_sub_fetch(&header->sleepers, 1, __ATOMIC_SEQ_CST);
+    return err;
+}
+
+void aoa_bus_detach(struct aoa_bus_reader *reader)
+{
+    munmap(reader->map.header, reader->map.size);
+    free(reader);
+}
@@ -0,0 +1,103 @@
+#ifndef AOA_HOST_BUS_H_
+#define AOA_HOST_BUS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <aoa/report.h>
+
+/*
+ * Publication of angles and positions to any number of local consumers
+ * through one POSIX shared memory ring. One process writes; readers map
+ * the same object and follow the ring at their own pace with a private
+ * cursor, so adding a reader costs the writer nothing and the writer
+ * never waits for one. Every record carries a sequence number. A reader
+ * that falls more than the ring's capacity behind finds its records
+ * overwritten, skips ahead and is told how many it lost.
+ *
+ * Each slot is a seqlock: the writer marks the slot odd, writes the
+ * record and marks it with the record's sequence number, and a reader
+ * keeps its copy only if the mark was the same before and after. A
+ * writer that restarts on an existing ring of the same layout carries on
+ * with its sequence numbers, so attached readers see no break. One that
+ * formats it with another layout makes attached readers fail with
+ * -EPROTO until they attach again.
+ */
+
+#define AOA_BUS_NAME "/aoa_bus"
+#define AOA_BUS_CAPACITY 4096
+
+enum aoa_bus_type {
+    AOA_BUS_ANGLE = 1,
+    AOA_BUS_POSITION,
+};
+
+struct aoa_bus_position {
+    uint32_t tag_id;
+    float x, y, z;              // Metres in the site frame
+    float accuracy;             // Estimated error radius in metres
+};
+
+struct aoa_bus_record {
+    uint64_t seq;               // Set by the bus
+    uint64_t time_us;           // Wall clock at publication, set by the bus
+    uint16_t type;              // enum aoa_bus_type
+    uint16_t locator;           // Source of an angle
+    uint32_t reserved;
+    union {
+        struct aoa_angle_result angle;
+        struct aoa_bus_position position;
+    };
+};
+
+struct aoa_bus;
+struct aoa_bus_reader;
+
+/**
+ * @brief Create the ring @p name, or take over an existing one, as its writer.
+ *
+ * @param capacity Records kept; a power of two. Readers further behind lose records.
+ *
+ * @return The writer, or NULL with errno set.
+ */
+struct aoa_bus *aoa_bus_create(const char *name, uint32_t capacity);
+
+/** @brief Publish @p record, filling in its sequence number and time. Never blocks. */
+void aoa_bus_publish(struct aoa_bus *bus, struct aoa_bus_record *record);
+
+/** @brief Unmap the ring. It stays for readers and the next writer. */
+void aoa_bus_close(struct aoa_bus *bus);
+
+/**
+ * @brief Attach to the ring @p name.
+ *
+ * @param oldest Start at the oldest record still in the ring instead of the next one.
+ *
+ * @return The reader, or NULL with errno set.
+ */
+struct aoa_bus_reader *aoa_bus_attach(const char *name, bool oldest);
+
+/**
+ * @brief Take the next record.
+ *
+ * @param lost Records overwritten before this reader got to them, since the previous call.
+ *
+ * @return 1 with the record in @p record, 0 if the reader has caught up,
+ *         or -EPROTO if a writer formatted the ring again with another
+ *         layout since the reader attached; detach and attach again.
+ */
+int aoa_bus_read(struct aoa_bus_reader *reader, struct aoa_bus_record *record, uint64_t *lost);
+
+/**
+ * @brief Sleep until a record the reader has not seen is published.
+ *
+ * The first record after a quiet spell wakes the reader at once; while
+ * the writer is busy, within a millisecond.
+ *
+ * @return 0, -ETIMEDOUT after @p timeout_ms, or -EPROTO as for aoa_bus_read().
+ */
+int aoa_bus_wait(struct aoa_bus_reader *reader, int timeout_ms);
+
+void aoa_bus_detach(struct aoa_bus_reader *reader);
+
+#endif /* AOA_HOST_BUS_H_ */
@@ -0,0 +1,367 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <aoa/frame.h>
+#include <aoa/history.h>
+#include <aoa/record.h>
+
+/*
+ * Angle history of a locator built with CONFIG_AOA_RX_HISTORY, logged to
+ * its flash while the uplink was down. On a serial device, set up with
+ * stty beforehand as for aoa_server, the tool asks for a read-out, decodes
+ * the batches that come back and prints one CSV line per logged angle,
+ * oldest first. A file is taken as a captured read-out.
+ *
+ *   aoa_history [-t seconds] device|file
+ *   aoa_history -b tags [-m minutes] [-r rate] [-z batch] [-k flash_kb] [-e]
+ *
+ * With -b the tool benchmarks the encoding instead: tags moving at the
+ * given rate are logged for the given minutes in batches of -z bytes, with
+ * elevations with -e. Every batch is decoded again and checked against
+ * what went in, and the bytes an angle takes are compared with angle
+ * records and the console's text lines, as hours of history that fit in
+ * -k kilobytes of flash.
+ */
+
+#define READ_SIZE 4096
+
+/* Length and CRC of a flash circular buffer entry, each padded to the 4-byte write block */
+#define FLASH_ENTRY_OVERHEAD 8
+#define FLASH_WRITE_BLOCK 4
+
+static void entry_print(const struct aoa_history_entry *e)
+{
+    printf("%u,%u,%u,%.1f,%.1f,%.3f\n", e->boot, e->time_ms, e->tag_id, e->azimuth,
+           e->elevation, e->quality);
+}
+
+// Prints the batch; 1 for the empty batch that ends a read-out
+static int batch_print(const struct aoa_record_history *history, unsigned long *entries)
+{
+    struct aoa_history_decoder dec;
+    struct aoa_history_entry e;
+    int ret = aoa_history_decoder_init(&dec, history->batch, history->len);
+
+    if (ret) {
+        return ret;
+    }
+    if (history->len == AOA_HISTORY_HEADER_SIZE) {
+        return 1;
+    }
+    while ((ret = aoa_history_next(&dec, &e)) == 1) {
+        entry_print(&e);
+        (*entries)++;
+    }
+    return ret;
+}
+
+static int readout(const char *path, int timeout_s)
+{
+    static struct aoa_frame_decoder dec;
+    static struct aoa_record record;
+    uint8_t buf[READ_SIZE];
+    unsigned long entries = 0;
+    unsigned long batches = 0;
+    unsigned long bad = 0;
+    size_t bytes = 0;
+    bool done = false;
+
+    const int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    const bool device = isatty(fd);
+    if (device) {
+        const uint8_t request = AOA_HISTORY_READOUT_REQUEST;
+
+        tcflush(fd, TCIFLUSH);
+        if (write(fd, &request, 1) != 1) {
+            perror(path);
+            close(fd);
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    aoa_frame_decoder_init(&dec);
+    printf("boot,time_ms,tag,azimuth,elevation,quality\n");
+    while (!done) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (device && poll(&pfd, 1, timeout_s * 1000) == 0) {
+            fprintf(stderr, "No end of read-out after %d s\n", timeout_s);
+            break;
+        }
+
+        const ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            break;
+        }
+        bytes += n;
+        for (size_t used = 0; used < (size_t)n && !done;) {
+            const uint8_t *payload;
+            size_t consumed;
+            const int len = aoa_frame_decode(&dec, &buf[used], n - used, &consumed, &payload);
+
+            used += consumed;
+            if (len < 0) {
+                bad++;
+            }
+            // The stream header is skipped; batches do not depend on the array
+            if (len <= 0 || len == AOA_RECORD_HEADER_SIZE ||
+                aoa_record_decode(payload, len, &record) != len ||
+                record.type != AOA_RECORD_HISTORY) {
+                continue;
+            }
+
+            const int ret = batch_print(&record.history, &entries);
+            if (ret < 0) {
+                bad++;
+            }
+            done = ret == 1;
+            batches += ret == 0;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    close(fd);
+
+    const double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    fprintf(stderr, "%lu angles in %lu batches, %zu bytes in %.2f s, %lu bad frames%s\n",
+            entries, batches, bytes, elapsed, bad, done ? "" : ", read-out incomplete");
+    return done || !device ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+struct bench_tag {
+    uint32_t next_ms;
+    float azimuth;
+    float elevation;
+};
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float frand(float lo, float hi)
+{
+    return lo + (hi - lo) * (float)rand() / (float)RAND_MAX;
+}
+
+static bool entry_matches(const struct aoa_history_entry *in, const struct aoa_history_entry *out,
+                          bool elevation)
+{
+    return in->time_ms == out->time_ms && in->tag_id == out->tag_id &&
+           fabsf(in->azimuth - out->azimuth) <= 0.05f + 1e-3f &&
+           (!elevation || fabsf(in->elevation - out->elevation) <= 0.05f + 1e-3f) &&
+           fabsf(in->quality - out->quality) <= 0.5f / 255.0f + 1e-4f;
+}
+
+// Decodes the batch and checks it against the entries that went in
+static unsigned long batch_check(const uint8_t *batch, size_t len,
+                                 const struct aoa_history_entry *in, int count, bool elevation)
+{
+    struct aoa_history_decoder dec;
+    struct aoa_history_entry out;
+    unsigned long errors = 0;
+    int n = 0;
+
+    if (aoa_history_decoder_init(&dec, batch, len)) {
+        return count;
+    }
+    while (aoa_history_next(&dec, &out) == 1) {
+        errors += n >= count || !entry_matches(&in[n], &out, elevation);
+        n++;
+    }
+    return errors + (n != count) + (dec.p != dec.end);
+}
+
+static size_t flash_size(size_t len)
+{
+    return FLASH_ENTRY_OVERHEAD + (len + FLASH_WRITE_BLOCK - 1) / FLASH_WRITE_BLOCK *
+                                  FLASH_WRITE_BLOCK;
+}
+
+static int bench(int tag_count, double minutes, double rate, size_t batch_size, int flash_kb,
+                 bool elevation)
+{
+    static struct bench_tag tags[AOA_HISTORY_TAGS_MAX];
+    static struct aoa_history_entry pending[AOA_HISTORY_BATCH_MAX];
+    static uint8_t batch[AOA_HISTORY_BATCH_MAX];
+    struct aoa_history_encoder enc;
+    const uint32_t period_ms = 1000.0 / rate;
+    const uint32_t end_ms = minutes * 60000.0;
+    unsigned long entries = 0;
+    unsigned long batches = 0;
+    unsigned long errors = 0;
+    size_t history_bytes = 0;
+    size_t flash_bytes = 0;
+    size_t text_bytes = 0;
+    double encode_s = 0.0;
+    int count = 0;
+
+    srand(1);
+    for (int i = 0; i < tag_count; i++) {
+        tags[i] = (struct bench_tag){
+            .next_ms = rand() % period_ms,
+            .azimuth = frand(-60.0f, 60.0f),
+            .elevation = elevation ? frand(10.0f, 60.0f) : 0.0f,
+        };
+    }
+
+    aoa_history_encoder_init(&enc, batch, batch_size, 1, elevation ? AOA_HISTORY_ELEVATION : 0);
+    while (1) {
+        // Next tag due, each walking with measurement noise on top
+        struct bench_tag *t = &tags[0];
+        for (int i = 1; i < tag_count; i++) {
+            if (tags[i].next_ms < t->next_ms) {
+                t = &tags[i];
+            }
+        }
+        const bool last = t->next_ms >= end_ms;
+        const struct aoa_history_entry e = {
+            .time_ms = t->next_ms,
+            .boot = 1,
+            .tag_id = t - tags,
+            .azimuth = t->azimuth + frand(-0.5f, 0.5f),
+            .elevation = elevation ? t->elevation + frand(-0.5f, 0.5f) : 0.0f,
+            .quality = frand(0.6f, 1.0f),
+        };
+
+        int ret = -ENOSPC;
+        if (!last) {
+            const double t0 = now_s();
+            ret = aoa_history_append(&enc, &e);
+            encode_s += now_s() - t0;
+        }
+        if (ret == -ENOSPC) {
+            errors += batch_check(batch, enc.len, pending, count, elevation);
+            history_bytes += enc.len;
+            flash_bytes += flash_size(enc.len);
+            batches++;
+            count = 0;
+            aoa_history_encoder_init(&enc, batch, batch_size, 1,
+                                     elevation ? AOA_HISTORY_ELEVATION : 0);
+            if (last) {
+                break;
+            }
+            ret = aoa_history_append(&enc, &e);
+        }
+        if (ret) {
+            fprintf(stderr, "Append failed (err %d)\n", ret);
+            return EXIT_FAILURE;
+        }
+        pending[count++] = e;
+        entries++;
+
+        // As the console prints it
+        char line[96];
+        if (elevation) {
+            text_bytes += snprintf(line, sizeof(line),
+                                   "Tag %u: AoA %.1f deg, elevation %.1f deg (quality %u%%)\n",
+                                   e.tag_id, e.azimuth, e.elevation,
+                                   (unsigned int)(e.quality * 100.0f));
+        } else {
+            text_bytes += snprintf(line, sizeof(line), "Tag %u: AoA %.1f deg (quality %u%%)\n",
+                                   e.tag_id, e.azimuth, (unsigned int)(e.quality * 100.0f));
+        }
+
+        t->azimuth = CLAMP(t->azimuth + frand(-0.3f, 0.3f), -85.0f, 85.0f);
+        t->elevation = elevation ? CLAMP(t->elevation + frand(-0.2f, 0.2f), 0.0f, 89.0f) : 0.0f;
+        t->next_ms += period_ms;
+    }
+
+    const double seconds = minutes * 60.0;
+    const double flash = flash_kb * 1024.0;
+    const double history_rate = flash_bytes / seconds;
+    const double record_rate = (double)entries * flash_size(AOA_RECORD_ANGLE_SIZE) / seconds;
+    const double text_rate = (double)text_bytes / seconds;
+
+    printf("%d tags at %.1f Hz for %.1f min: %lu angles in %lu batches of up to %zu bytes\n",
+           tag_count, rate, minutes, entries, batches, batch_size);
+    printf("history      %5.2f bytes/angle, %6.0f bytes/s in flash, %7.1f h in %d KB\n",
+           (double)history_bytes / entries, history_rate, flash / history_rate / 3600.0,
+           flash_kb);
+    printf("angle record %5.2f bytes/angle, %6.0f bytes/s in flash, %7.1f h in %d KB\n",
+           (double)AOA_RECORD_ANGLE_SIZE, record_rate, flash / record_rate / 3600.0, flash_kb);
+    printf("text line    %5.2f bytes/angle, %6.0f bytes/s,          %7.1f h in %d KB\n",
+           (double)text_bytes / entries, text_rate, flash / text_rate / 3600.0, flash_kb);
+    printf("%.1f ns to encode an angle; %s\n", encode_s * 1e9 / entries,
+           errors ? "DECODED ANGLES DIFFER" : "every batch decodes to what went in");
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    int timeout_s = 10;
+    int tag_count = 0;
+    double minutes = 10.0;
+    double rate = 10.0;
+    int batch_size = AOA_HISTORY_BATCH_MAX;
+    int flash_kb = 8192;
+    bool elevation = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:b:m:r:z:k:e")) != -1) {
+        switch (opt) {
+        case 't':
+            timeout_s = atoi(optarg);
+            break;
+        case 'b':
+            tag_count = atoi(optarg);
+            break;
+        case 'm':
+            minutes = atof(optarg);
+            break;
+        case 'r':
+            rate = atof(optarg);
+            break;
+        case 'z':
+            batch_size = atoi(optarg);
+            break;
+        case 'k':
+            flash_kb = atoi(optarg);
+            break;
+        case 'e':
+            elevation = true;
+            break;
+        default:
+            goto usage;
+        }
+    }
+
+    if (tag_count) {
+        if (tag_count < 0 || tag_count > AOA_HISTORY_TAGS_MAX || rate <= 0.0 || rate > 1000.0 ||
+            minutes <= 0.0 || flash_kb <= 0 || batch_size < AOA_HISTORY_HEADER_SIZE +
+            AOA_HISTORY_ENTRY_SIZE_MAX || batch_size > AOA_HISTORY_BATCH_MAX) {
+            fprintf(stderr, "1 to %d tags, up to 1000 Hz, and batches of %d to %d bytes\n",
+                    AOA_HISTORY_TAGS_MAX, AOA_HISTORY_HEADER_SIZE + AOA_HISTORY_ENTRY_SIZE_MAX,
+                    AOA_HISTORY_BATCH_MAX);
+            return EXIT_FAILURE;
+        }
+        return bench(tag_count, minutes, rate, batch_size, flash_kb, elevation);
+    }
+    if (argc - optind != 1) {
+        goto usage;
+    }
+    return readout(argv[optind], timeout_s);
+
+usage:
+    fprintf(stderr,
+            "usage: %s [-t seconds] device|file\n"
+            "       %s -b tags [-m minutes] [-r rate] [-z batch] [-k flash_kb] [-e]\n",
+            argv[0], argv[0]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <aoa/dsp.h>
+#include <aoa/record.h>
+
+/*
+ * Replay a record stream through the core, as the DSP thread would have
+ * processed it, and print one CSV line per angle. Angle records already in
+ * the stream are printed as they are, marked as recorded. A malformed or
+ * truncated stream is an error.
+ *
+ *   aoa_replay [file]     (standard input without a file)
+ */
+
+// Room for a few of the largest records, so reads stay large
+#define BUF_SIZE (4 * AOA_RECORD_IQ_SIZE_MAX + 4096)
+
+static void angle_print(const struct aoa_angle_result *result, const char *origin)
+{
+    printf("%s,%u,%u,%u,%u,%.2f,%.2f,%.3f\n", origin, result->tag_id, result->source,
+           result->event_counter, result->timestamp, result->azimuth, result->elevation,
+           result->quality);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    if (argc > 2) {
+        fprintf(stderr, "usage: %s [file]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc == 2) {
+        in = fopen(argv[1], "rb");
+        if (!in) {
+            perror(argv[1]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    static uint8_t buf[BUF_SIZE];
+    static struct aoa_record record;
+    static struct aoa_state state;
+    size_t len = 0;
+    bool header = false;
+    bool eof = false;
+    unsigned long reports = 0;
+    unsigned long rejected = 0;
+
+    printf("origin,tag,source,event,timestamp,azimuth,elevation,quality\n");
+
+    while (!eof || len > 0) {
+        if (!eof && len < sizeof(buf)) {
+            const size_t n = fread(&buf[len], 1, sizeof(buf) - len, in);
+            len += n;
+            eof = n == 0;
+        }
+
+        const bool at_header = !header;
+        const int ret = at_header ? aoa_record_header_decode(buf, len)
+                                  : aoa_record_decode(buf, len, &record);
+
+        if (ret == -EAGAIN) {
+            if (eof) {
+                fprintf(stderr, "Truncated stream (%zu bytes left)\n", len);
+                return EXIT_FAILURE;
+            }
+            continue;
+        } else if (ret == -ENOTSUP) {
+            fprintf(stderr, "Stream was recorded with another array configuration\n");
+            return EXIT_FAILURE;
+        } else if (ret < 0) {
+            fprintf(stderr, "Malformed stream (err %d)\n", ret);
+            return EXIT_FAILURE;
+        }
+
+        if (at_header) {
+            header = true;
+        } else if (record.type == AOA_RECORD_IQ) {
+            struct aoa_angle_result result;
+            reports++;
+            if (aoa_process(&state, &record.iq, false, &result) == 0) {
+                angle_print(&result, "replay");
+            } else {
+                rejected++;
+            }
+        } else if (record.type == AOA_RECORD_ANGLE) {
+            angle_print(&record.angle, "recorded");
+        }
+
+        len -= ret;
+        memmove(buf, &buf[ret], len);
+    }
+
+    fprintf(stderr, "%lu reports, %lu rejected\n", reports, rejected);
+    if (in != stdin) {
+        fclose(in);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,640 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <aoa/dsp.h>
+#include <aoa/frame.h>
+#include <aoa/record.h>
+
+#include "bus.h"
+
+/*
+ * Estimation server for thin locators (CONFIG_AOA_RX_ROLE_THIN). Each
+ * locator is a byte stream of framed records: a TCP connection, e.g. from
+ * a serial-to-TCP bridge on the locator's UART, or a path given on the
+ * command line (tty, FIFO or captured file). One reader thread per locator
+ * decodes frames into a bounded report queue. A pool of workers estimates
+ * with per-locator state and prints one CSV line per angle.
+ *
+ *   aoa_server [-l port] [-k] [-w workers] [-q depth] [-i seconds] [-p bus] [path...]
+ *
+ * Scheduling is work stealing over locators: a locator with queued reports
+ * is one task, owned by one worker at a time, so its reports are estimated
+ * in order against its own covariance and tracks. A worker runs its own
+ * tasks newest first and, when it runs dry, steals the oldest task of
+ * another worker. After a batch a busy locator goes back on the worker's
+ * own deque, so locators share the workers evenly.
+ *
+ * A full queue is backpressure: the reader stops reading, which over TCP
+ * slows the sender down. Queue depth, its high-water mark and the time
+ * readers spent stalled are printed per locator every interval.
+ *
+ * A locator that disconnects keeps its slot until it is drained, then the
+ * slot goes to the next locator to connect. With -k a locator that
+ * reconnects from the same host gets its old slot back, with its number
+ * and estimator state, as long as nothing else took it in between; only
+ * use it when each host bridges one locator.
+ *
+ * With -p angles are also published on the shared memory bus of that
+ * name (aoa_bus/bus.h), for local consumers to read without a socket.
+ */
+
+#define LOCATORS_MAX 64
+#define WORKERS_MAX 64
+#define BATCH 16
+#define READ_SIZE 4096
+
+struct locator {
+    int id;
+    int fd;
+    char name[64];
+    char host[64];              // Reconnects from here may resume the state, see -k
+    pthread_t reader;
+    bool joinable;              // reader was started and not joined yet
+    struct aoa_state *state;    // Only touched by the worker running the locator
+
+    pthread_mutex_t lock;
+    pthread_cond_t not_full;
+    struct aoa_iq_report *queue;
+    int head;
+    int count;
+    bool scheduled;             // On a deque or being run
+    bool closed;                // Reader is done
+
+    // Statistics, under lock
+    int high_water;
+    uint64_t received;
+    uint64_t estimated;
+    uint64_t rejected;
+    uint64_t bad_frames;
+    uint64_t stalls;
+    double stalled_s;
+};
+
+// Deque of locator tasks: the owner pushes and pops at the bottom, thieves take the top
+struct deque {
+    pthread_mutex_t lock;
+    struct locator *tasks[LOCATORS_MAX];
+    int top;
+    int bottom;
+};
+
+struct worker {
+    pthread_t thread;
+    int id;
+    struct deque deque;
+    uint64_t runs;
+    uint64_t steals;
+};
+
+static struct locator locators[LOCATORS_MAX];
+static int locator_count;
+static pthread_mutex_t locators_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct worker workers[WORKERS_MAX];
+static int worker_count;
+
+// Tasks on all deques; idle workers sleep until there is one
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+static int pending;
+static bool stopping;
+
+static int queue_depth = 64;
+static bool keep_state;
+static unsigned int next_worker;
+
+// The bus has a single writer, so workers take turns
+static struct aoa_bus *bus;
+static pthread_mutex_t bus_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void deque_push(struct deque *d, struct locator *loc)
+{
+    pthread_mutex_lock(&d->lock);
+    d->tasks[d->bottom++ % LOCATORS_MAX] = loc;
+    pthread_mutex_unlock(&d->lock);
+
+    pthread_mutex_lock(&pool_lock);
+    pending++;
+    pthread_cond_signal(&pool_cond);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+static struct locator *deque_take(struct deque *d, bool steal)
+{
+    struct locator *loc = NULL;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->top != d->bottom) {
+        loc = steal ? d->tasks[d->top++ % LOCATORS_MAX] : d->tasks[--d->bottom % LOCATORS_MAX];
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    if (loc) {
+        pthread_mutex_lock(&pool_lock);
+        pending--;
+        pthread_mutex_unlock(&pool_lock);
+    }
+    return loc;
+}
+
+static struct locator *task_next(struct worker *w)
+{
+    struct locator *loc = deque_take(&w->deque, false);
+
+    for (int i = 1; !loc && i < worker_count; i++) {
+        loc = deque_take(&workers[(w->id + i) % worker_count].deque, true);
+        if (loc) {
+            __atomic_fetch_add(&w->steals, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return loc;
+}
+
+// Estimate up to a batch of the locator's reports, then requeue it if more are waiting
+static void locator_run(struct worker *w, struct locator *loc)
+{
+    struct aoa_iq_report report;
+    struct aoa_angle_result result;
+
+    for (int n = 0; n < BATCH; n++) {
+        pthread_mutex_lock(&loc->lock);
+        if (loc->count == 0) {
+            pthread_mutex_unlock(&loc->lock);
+            break;
+        }
+        report = loc->queue[loc->head];
+        loc->head = (loc->head + 1) % queue_depth;
+        loc->count--;
+        pthread_cond_signal(&loc->not_full);
+        pthread_mutex_unlock(&loc->lock);
+
+        const int err = aoa_process(loc->state, &report, false, &result);
+        if (!err) {
+            printf("%d,%u,%u,%u,%u,%.2f,%.2f,%.3f\n", loc->id, result.tag_id, result.source,
+                   result.event_counter, result.timestamp, result.azimuth, result.elevation,
+                   result.quality);
+        }
+        if (!err && bus) {
+            struct aoa_bus_record record = {
+                .type = AOA_BUS_ANGLE,
+                .locator = loc->id,
+                .angle = result,
+            };
+
+            pthread_mutex_lock(&bus_lock);
+            aoa_bus_publish(bus, &record);
+            pthread_mutex_unlock(&bus_lock);
+        }
+
+        pthread_mutex_lock(&loc->lock);
+        if (err) {
+            loc->rejected++;
+        } else {
+            loc->estimated++;
+        }
+        pthread_mutex_unlock(&loc->lock);
+    }
+
+    // Enqueueing reschedules a locator only when this clears the flag
+    pthread_mutex_lock(&loc->lock);
+    const bool more = loc->count > 0;
+    loc->scheduled = more;
+    pthread_mutex_unlock(&loc->lock);
+
+    __atomic_fetch_add(&w->runs, 1, __ATOMIC_RELAXED);
+    if (more) {
+        deque_push(&w->deque, loc);
+    }
+}
+
+static void *worker_thread(void *arg)
+{
+    struct worker *w = arg;
+
+    while (1) {
+        struct locator *loc = task_next(w);
+        if (loc) {
+            locator_run(w, loc);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool_lock);
+        while (pending <= 0 && !stopping) {
+            pthread_cond_wait(&pool_cond, &pool_lock);
+        }
+        const bool stop = stopping && pending <= 0;
+        pthread_mutex_unlock(&pool_lock);
+        if (stop) {
+            return NULL;
+        }
+    }
+}
+
+// Queue a report, waiting while the queue is full
+static void locator_enqueue(struct locator *loc, const struct aoa_iq_report *report)
+{
+    pthread_mutex_lock(&loc->lock);
+    if (loc->count == queue_depth) {
+        const double start = now_s();
+
+        loc->stalls++;
+        while (loc->count == queue_depth) {
+            pthread_cond_wait(&loc->not_full, &loc->lock);
+        }
+        loc->stalled_s += now_s() - start;
+    }
+
+    loc->queue[(loc->head + loc->count) % queue_depth] = *report;
+    loc->count++;
+    loc->received++;
+    if (loc->count > loc->high_water) {
+        loc->high_water = loc->count;
+    }
+
+    const bool schedule = !loc->scheduled;
+    loc->scheduled = true;
+    pthread_mutex_unlock(&loc->lock);
+
+    // New tasks are spread round robin; stealing evens out the rest
+    if (schedule) {
+        const unsigned int w = __atomic_fetch_add(&next_worker, 1, __ATOMIC_RELAXED);
+        deque_push(&workers[w % worker_count].deque, loc);
+    }
+}
+
+static void *reader_thread(void *arg)
+{
+    struct locator *loc = arg;
+    struct aoa_frame_decoder dec;
+    struct aoa_record record;
+    uint8_t buf[READ_SIZE];
+    bool header = false;
+    ssize_t n;
+
+    aoa_frame_decoder_init(&dec);
+    while ((n = read(loc->fd, buf, sizeof(buf))) > 0) {
+        size_t used = 0;
+
+        while (used < (size_t)n) {
+            const uint8_t *payload;
+            size_t consumed;
+            const int len = aoa_frame_decode(&dec, &buf[used], n - used, &consumed, &payload);
+
+            used += consumed;
+            if (len == 0) {
+                continue;
+            }
+
+            int err = len < 0 ? len : 0;
+            if (!err && len == AOA_RECORD_HEADER_SIZE) {
+                // A stream header; its length cannot be mistaken for a record's
+                err = aoa_record_header_decode(payload, len);
+                if (err == -ENOTSUP) {
+                    fprintf(stderr, "Locator %d (%s) uses another array configuration\n",
+                            loc->id, loc->name);
+                    goto done;
+                }
+                header = err > 0;
+                continue;
+            }
+            if (!err) {
+                err = aoa_record_decode(payload, len, &record);
+                err = err == len ? 0 : -EBADMSG;
+            }
+            if (err) {
+                pthread_mutex_lock(&loc->lock);
+                loc->bad_frames++;
+                pthread_mutex_unlock(&loc->lock);
+                continue;
+            }
+
+            // IQ records ahead of the first header could be from any array
+            if (header && record.type == AOA_RECORD_IQ) {
+                locator_enqueue(loc, &record.iq);
+            }
+        }
+    }
+
+done:
+    close(loc->fd);
+    pthread_mutex_lock(&loc->lock);
+    loc->closed = true;
+    pthread_mutex_unlock(&loc->lock);
+    return NULL;
+}
+
+// A closed slot whose reports are all estimated; its reader has returned or is about to
+static bool locator_free(struct locator *loc)
+{
+    pthread_mutex_lock(&loc->lock);
+    const bool drained = loc->closed && loc->count == 0 && !loc->scheduled;
+    pthread_mutex_unlock(&loc->lock);
+    return drained;
+}
+
+// Slot for a new locator from @p host, reusing a drained one first; NULL if all are busy
+static struct locator *locator_slot(const char *host, bool *resumed)
+{
+    struct locator *spare = NULL;
+
+    *resumed = false;
+    for (int i = 0; i < locator_count; i++) {
+        struct locator *loc = &locators[i];
+
+        if (!locator_free(loc)) {
+            continue;
+        }
+        if (keep_state && host && !strcmp(loc->host, host)) {
+            *resumed = true;
+            return loc;
+        }
+        if (!spare) {
+            spare = loc;
+        }
+    }
+    if (spare || locator_count == LOCATORS_MAX) {
+        return spare;
+    }
+
+    struct locator *loc = &locators[locator_count];
+    loc->state = calloc(1, sizeof(*loc->state));
+    loc->queue = calloc(queue_depth, sizeof(*loc->queue));
+    if (!loc->state || !loc->queue) {
+        free(loc->state);
+        free(loc->queue);
+        loc->state = NULL;
+        loc->queue = NULL;
+        return NULL;
+    }
+    loc->id = locator_count;
+    loc->closed = true;
+    pthread_mutex_init(&loc->lock, NULL);
+    pthread_cond_init(&loc->not_full, NULL);
+    locator_count++;
+    return loc;
+}
+
+static int locator_add(int fd, const char *name, const char *host)
+{
+    bool resumed;
+
+    pthread_mutex_lock(&locators_lock);
+    struct locator *loc = locator_slot(host, &resumed);
+    if (!loc) {
+        pthread_mutex_unlock(&locators_lock);
+        fprintf(stderr, "No locator slot for %s\n", name);
+        close(fd);
+        return -ENOMEM;
+    }
+
+    // The previous reader is done with the slot once it has returned
+    if (loc->joinable) {
+        pthread_join(loc->reader, NULL);
+        loc->joinable = false;
+    }
+
+    // No worker holds a drained slot, and the statistics only read it under its lock
+    pthread_mutex_lock(&loc->lock);
+    if (!resumed) {
+        memset(loc->state, 0, sizeof(*loc->state));
+        loc->high_water = 0;
+        loc->received = 0;
+        loc->estimated = 0;
+        loc->rejected = 0;
+        loc->bad_frames = 0;
+        loc->stalls = 0;
+        loc->stalled_s = 0.0;
+    }
+    snprintf(loc->name, sizeof(loc->name), "%s", name);
+    snprintf(loc->host, sizeof(loc->host), "%s", host ? host : "");
+    loc->head = 0;
+    loc->fd = fd;
+    loc->closed = false;
+    pthread_mutex_unlock(&loc->lock);
+
+    int err = pthread_create(&loc->reader, NULL, reader_thread, loc);
+    if (err) {
+        // Closed again, so the slot stays free for the next locator
+        pthread_mutex_lock(&loc->lock);
+        loc->closed = true;
+        pthread_mutex_unlock(&loc->lock);
+        pthread_mutex_unlock(&locators_lock);
+        fprintf(stderr, "No reader thread for %s (err %d)\n", name, err);
+        close(fd);
+        return -err;
+    }
+    loc->joinable = true;
+    pthread_mutex_unlock(&locators_lock);
+
+    fprintf(stderr, "Locator %d: %s%s\n", loc->id, name, resumed ? " (resumed)" : "");
+    return 0;
+}
+
+static void *listen_thread(void *arg)
+{
+    const int srv = *(int *)arg;
+
+    while (1) {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        const int fd = accept(srv, (struct sockaddr *)&addr, &addr_len);
+        if (fd < 0) {
+            continue;
+        }
+
+        char host[INET_ADDRSTRLEN];
+        char name[64];
+        inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+        snprintf(name, sizeof(name), "%s:%u", host, ntohs(addr.sin_port));
+        locator_add(fd, name, host);
+    }
+    return NULL;
+}
+
+static int listen_start(int port)
+{
+    static int srv;
+    static pthread_t thread;
+    const int one = 1;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+
+    srv = socket(AF_INET, SOCK_STREAM, 0);
+    if (srv < 0) {
+        return -errno;
+    }
+    setsockopt(srv, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(srv, (struct sockaddr *)&addr, sizeof(addr)) || listen(srv, LOCATORS_MAX)) {
+        const int err = -errno;
+        close(srv);
+        return err;
+    }
+    return -pthread_create(&thread, NULL, listen_thread, &srv);
+}
+
+// True once every locator is closed and drained
+static bool locators_done(void)
+{
+    bool done = true;
+
+    pthread_mutex_lock(&locators_lock);
+    for (int i = 0; i < locator_count; i++) {
+        struct locator *loc = &locators[i];
+
+        pthread_mutex_lock(&loc->lock);
+        done = done && loc->closed && loc->count == 0 && !loc->scheduled;
+        pthread_mutex_unlock(&loc->lock);
+    }
+    pthread_mutex_unlock(&locators_lock);
+    return done;
+}
+
+static void stats_print(void)
+{
+    pthread_mutex_lock(&locators_lock);
+    for (int i = 0; i < locator_count; i++) {
+        struct locator *loc = &locators[i];
+
+        pthread_mutex_lock(&loc->lock);
+        fprintf(stderr,
+                "Locator %d (%s)%s: queue %d/%d (max %d), %llu received, %llu estimated, "
+                "%llu rejected, %llu bad frames, %llu stalls (%.1f s)\n",
+                loc->id, loc->name, loc->closed ? " closed" : "", loc->count, queue_depth,
+                loc->high_water, (unsigned long long)loc->received,
+                (unsigned long long)loc->estimated, (unsigned long long)loc->rejected,
+                (unsigned long long)loc->bad_frames, (unsigned long long)loc->stalls,
+                loc->stalled_s);
+        pthread_mutex_unlock(&loc->lock);
+    }
+    pthread_mutex_unlock(&locators_lock);
+
+    for (int i = 0; i < worker_count; i++) {
+        fprintf(stderr, "Worker %d: %llu runs, %llu stolen\n", i,
+                (unsigned long long)__atomic_load_n(&workers[i].runs, __ATOMIC_RELAXED),
+                (unsigned long long)__atomic_load_n(&workers[i].steals, __ATOMIC_RELAXED));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int port = 0;
+    int interval = 5;
+    const char *bus_name = NULL;
+    int opt;
+
+    worker_count = sysconf(_SC_NPROCESSORS_ONLN);
+    while ((opt = getopt(argc, argv, "l:kw:q:i:p:")) != -1) {
+        switch (opt) {
+        case 'l':
+            port = atoi(optarg);
+            break;
+        case 'k':
+            keep_state = true;
+            break;
+        case 'w':
+            worker_count = atoi(optarg);
+            break;
+        case 'q':
+            queue_depth = atoi(optarg);
+            break;
+        case 'i':
+            interval = atoi(optarg);
+            break;
+        case 'p':
+            bus_name = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-l port] [-k] [-w workers] [-q depth] [-i seconds] [-p bus] "
+                    "[path...]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    worker_count = CLAMP(worker_count, 1, WORKERS_MAX);
+    if (queue_depth < 1 || interval < 1 || (!port && optind == argc)) {
+        fprintf(stderr, "Need a port or a path, a queue depth and an interval of at least 1\n");
+        return EXIT_FAILURE;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if (bus_name) {
+        bus = aoa_bus_create(bus_name, AOA_BUS_CAPACITY);
+        if (!bus) {
+            fprintf(stderr, "Cannot create bus %s (err %d)\n", bus_name, -errno);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("locator,tag,source,event,timestamp,azimuth,elevation,quality\n");
+
+    for (int i = 0; i < worker_count; i++) {
+        workers[i].id = i;
+        pthread_mutex_init(&workers[i].deque.lock, NULL);
+        if (pthread_create(&workers[i].thread, NULL, worker_thread, &workers[i])) {
+            fprintf(stderr, "Failed to start worker %d\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (int i = optind; i < argc; i++) {
+        const int fd = open(argv[i], O_RDONLY);
+        if (fd < 0) {
+            perror(argv[i]);
+            continue;
+        }
+        locator_add(fd, argv[i], NULL);
+    }
+    if (port) {
+        const int err = listen_start(port);
+        if (err) {
+            fprintf(stderr, "Cannot listen on port %d (err %d)\n", port, err);
+            return EXIT_FAILURE;
+        }
+        fprintf(stderr, "Listening on port %d with %d workers\n", port, worker_count);
+    }
+
+    // Serve until interrupted, or without a listener until every path is done
+    double next = now_s() + interval;
+    while (1) {
+        usleep(100000);
+        if (!port && locators_done()) {
+            break;
+        }
+        if (now_s() >= next) {
+            next += interval;
+            stats_print();
+        }
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    stopping = true;
+    pthread_cond_broadcast(&pool_cond);
+    pthread_mutex_unlock(&pool_lock);
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    fflush(stdout);
+    stats_print();
+    if (bus) {
+        aoa_bus_close(bus);
+    }
+    return EXIT_SUCCESS;
+}
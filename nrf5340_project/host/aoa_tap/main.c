@@ -0,0 +1,292 @@
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bus.h"
+
+/*
+ * Reader of the angle and position bus (aoa_bus/bus.h). Attaches to the
+ * ring and prints every record as a CSV line until interrupted; records
+ * lost to a full ring are counted on stderr as they are detected.
+ *
+ *   aoa_tap [-o] [name]
+ *   aoa_tap -b readers [-n records] [-c capacity] [-r rate]
+ *
+ * -o starts at the oldest record still in the ring. With -b the tool
+ * benchmarks the bus instead: one thread publishes as fast as it can, or
+ * at -r records per second, to a private ring while the given number of
+ * reader threads follow it. Each reader checks that sequence numbers and
+ * lost counts add up and that no record was torn, and the writer's cost
+ * per record is printed for comparison across reader counts.
+ */
+
+#define BENCH_NAME "/aoa_bus_bench"
+#define READERS_MAX 256
+
+struct bench_reader {
+    pthread_t thread;
+    struct aoa_bus_reader *reader;
+    uint64_t received;
+    uint64_t lost;
+    uint64_t errors;            // Torn records or sequence numbers that do not add up
+};
+
+static volatile sig_atomic_t stop;
+static bool writer_done;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void record_print(const struct aoa_bus_record *r)
+{
+    if (r->type == AOA_BUS_ANGLE) {
+        printf("%llu,%llu,angle,%u,%u,%u,%u,%.2f,%.2f,%.3f\n", (unsigned long long)r->seq,
+               (unsigned long long)r->time_us, r->locator, r->angle.tag_id,
+               r->angle.event_counter, r->angle.timestamp, r->angle.azimuth,
+               r->angle.elevation, r->angle.quality);
+    } else if (r->type == AOA_BUS_POSITION) {
+        printf("%llu,%llu,position,,%u,,,%.2f,%.2f,%.2f,%.2f\n", (unsigned long long)r->seq,
+               (unsigned long long)r->time_us, r->position.tag_id, r->position.x,
+               r->position.y, r->position.z, r->position.accuracy);
+    }
+}
+
+// The ring was formatted again with another layout: follow the new one from its start
+static struct aoa_bus_reader *reattach(struct aoa_bus_reader *reader, const char *name)
+{
+    aoa_bus_detach(reader);
+    fprintf(stderr, "%s was formatted again, attaching anew\n", name);
+    while (!stop) {
+        reader = aoa_bus_attach(name, true);
+        if (reader) {
+            return reader;
+        }
+        usleep(100000);
+    }
+    return NULL;
+}
+
+static int tap(const char *name, bool oldest)
+{
+    struct aoa_bus_reader *reader = aoa_bus_attach(name, oldest);
+    struct aoa_bus_record record;
+    uint64_t lost;
+    uint64_t total_lost = 0;
+    int n;
+
+    if (!reader) {
+        fprintf(stderr, "Cannot attach to %s (err %d)\n", name, -errno);
+        return EXIT_FAILURE;
+    }
+    printf("seq,time_us,type,locator,tag,event,timestamp,azimuth_or_x,elevation_or_y,"
+           "quality_or_z,accuracy\n");
+    while (!stop) {
+        while ((n = aoa_bus_read(reader, &record, &lost)) > 0) {
+            if (lost) {
+                total_lost += lost;
+                fprintf(stderr, "%llu records lost before %llu (%llu in all)\n",
+                        (unsigned long long)lost, (unsigned long long)record.seq,
+                        (unsigned long long)total_lost);
+            }
+            record_print(&record);
+        }
+        fflush(stdout);
+        if (n == -EPROTO || aoa_bus_wait(reader, 200) == -EPROTO) {
+            reader = reattach(reader, name);
+            if (!reader) {
+                return EXIT_SUCCESS;
+            }
+        }
+    }
+    aoa_bus_detach(reader);
+    return EXIT_SUCCESS;
+}
+
+// Every field follows from the sequence number, so a torn copy shows
+static void bench_fill(struct aoa_bus_record *r, uint64_t n)
+{
+    *r = (struct aoa_bus_record){
+        .type = AOA_BUS_ANGLE,
+        .locator = n % 64,
+        .angle = {
+            .timestamp = n,
+            .event_counter = n,
+            .tag_id = n,
+            .azimuth = (float)(n % 3600) / 10.0f,
+            .elevation = (float)(n % 900) / 10.0f,
+            .quality = (float)(n % 1000) / 1000.0f,
+        },
+    };
+}
+
+static bool bench_check(const struct aoa_bus_record *r)
+{
+    struct aoa_bus_record expect;
+
+    bench_fill(&expect, r->seq);
+    return r->locator == expect.locator && r->angle.timestamp == expect.angle.timestamp &&
+           r->angle.event_counter == expect.angle.event_counter &&
+           r->angle.tag_id == expect.angle.tag_id && r->angle.azimuth == expect.angle.azimuth &&
+           r->angle.elevation == expect.angle.elevation &&
+           r->angle.quality == expect.angle.quality;
+}
+
+static void *bench_reader_thread(void *arg)
+{
+    struct bench_reader *br = arg;
+    struct aoa_bus_reader *reader = br->reader;
+    struct aoa_bus_record record;
+    uint64_t expect = 0;
+    uint64_t lost;
+
+    while (1) {
+        const bool done = __atomic_load_n(&writer_done, __ATOMIC_ACQUIRE);
+
+        while (aoa_bus_read(reader, &record, &lost) > 0) {
+            br->received++;
+            br->lost += lost;
+            br->errors += record.seq != expect + lost || !bench_check(&record);
+            expect = record.seq + 1;
+        }
+        if (done) {
+            break;
+        }
+        aoa_bus_wait(reader, 10);
+    }
+    aoa_bus_detach(reader);
+    return NULL;
+}
+
+static int bench(int reader_count, uint64_t count, uint32_t capacity, double rate)
+{
+    static struct bench_reader readers[READERS_MAX];
+    struct aoa_bus *bus = aoa_bus_create(BENCH_NAME, capacity);
+    struct aoa_bus_record record;
+
+    if (!bus) {
+        fprintf(stderr, "Cannot create %s (err %d)\n", BENCH_NAME, -errno);
+        return EXIT_FAILURE;
+    }
+    // Attached before the first record, so every record is either received or lost
+    for (int i = 0; i < reader_count; i++) {
+        readers[i].reader = aoa_bus_attach(BENCH_NAME, true);
+        if (!readers[i].reader ||
+            pthread_create(&readers[i].thread, NULL, bench_reader_thread, &readers[i])) {
+            fprintf(stderr, "Failed to start reader %d\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Only the publishing is timed, not the pacing
+    const double start = now_s();
+    double elapsed = 0.0;
+    for (uint64_t n = 0; n < count; n++) {
+        if (rate > 0.0) {
+            while (now_s() - start < n / rate) {
+            }
+        }
+        bench_fill(&record, n);
+        const double t = now_s();
+        aoa_bus_publish(bus, &record);
+        elapsed += now_s() - t;
+    }
+    __atomic_store_n(&writer_done, true, __ATOMIC_RELEASE);
+
+    uint64_t received = 0;
+    uint64_t lost = 0;
+    uint64_t errors = 0;
+    for (int i = 0; i < reader_count; i++) {
+        pthread_join(readers[i].thread, NULL);
+        received += readers[i].received;
+        lost += readers[i].lost;
+        errors += readers[i].errors;
+        errors += readers[i].received + readers[i].lost != count;
+    }
+    aoa_bus_close(bus);
+    shm_unlink(BENCH_NAME);
+
+    printf("%llu records, %u slots, %d readers: %.1f ns to publish a record\n",
+           (unsigned long long)count, capacity, reader_count, elapsed * 1e9 / count);
+    if (reader_count) {
+        printf("Readers got %.1f%% of the records and detected the rest as lost; %s\n",
+               100.0 * received / ((double)count * reader_count),
+               errors ? "ERRORS in sequence or content" : "sequences and contents check out");
+    }
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = AOA_BUS_NAME;
+    bool oldest = false;
+    int reader_count = -1;
+    uint64_t count = 10000000;
+    uint32_t capacity = AOA_BUS_CAPACITY;
+    double rate = 0.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "ob:n:c:r:")) != -1) {
+        switch (opt) {
+        case 'o':
+            oldest = true;
+            break;
+        case 'b':
+            reader_count = atoi(optarg);
+            break;
+        case 'n':
+            count = strtoull(optarg, NULL, 10);
+            break;
+        case 'c':
+            capacity = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            rate = atof(optarg);
+            break;
+        default:
+            goto usage;
+        }
+    }
+    if (argc - optind > 1) {
+        goto usage;
+    }
+    if (optind < argc) {
+        name = argv[optind];
+    }
+
+    if (reader_count >= 0) {
+        if (reader_count > READERS_MAX || !count || !capacity || (capacity & (capacity - 1))) {
+            fprintf(stderr, "Up to %d readers, and a power of two for the capacity\n",
+                    READERS_MAX);
+            return EXIT_FAILURE;
+        }
+        return bench(reader_count, count, capacity, rate);
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    return tap(name, oldest);
+
+usage:
+    fprintf(stderr,
+            "usage: %s [-o] [name]\n"
+            "       %s -b readers [-n records] [-c capacity] [-r rate]\n",
+            argv[0], argv[0]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,445 @@
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <aoa/port.h>
+
+#include "bus.h"
+#include "zone.h"
+
+/*
+ * Zone events from a stream of tag positions. Zones are read from a file,
+ * one per line as an id and its vertices ("7 0,0 12.5,0 12.5,8 0,8"), and
+ * positions from CSV lines "time,tag,x,y" on standard input or a file, as
+ * fixes from the locators' bearings arrive, or with -s as position
+ * records from the shared memory bus of that name (aoa_bus/bus.h). Every
+ * enter and exit prints one CSV line; with -t only those of one tag.
+ *
+ *   aoa_zone [-c cell_m] [-m margin_m] [-t tag] [-s bus] zones [positions]
+ *   aoa_zone -b tags [-z zones] [-n updates] [-c cell_m] [-m margin_m] [-r seed]
+ *
+ * With -b the tool benchmarks itself instead: tags walk randomly over a
+ * site with rectangular zones, and the index is timed against testing
+ * every tag against every zone on every update, which must give the same
+ * events and memberships.
+ */
+
+#define LINE_MAX_LEN 4096
+#define POINTS_MAX 256
+
+#define SITE_M 1000.0f
+#define ZONE_MIN_M 5.0f
+#define ZONE_MAX_M 40.0f
+#define STEP_M 1.0f
+
+/*
+ * Zone corners sit on a 1/16 m grid and fixes on odd multiples of 1/64 m,
+ * so no fix lies exactly on an edge, or exactly at the margin of one,
+ * where the two tests could round differently.
+ */
+#define CORNER_GRID 16.0f
+#define FIX_GRID 32.0f
+
+struct rect {
+    float x0, y0, x1, y1;
+};
+
+static uint64_t rng_state;
+
+static uint64_t rng_next(void)
+{
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+static float rng_uniform(float lo, float hi)
+{
+    return lo + (hi - lo) * (float)((rng_next() >> 11) * (1.0 / 9007199254740992.0));
+}
+
+static float corner_snap(float v)
+{
+    return roundf(v * CORNER_GRID) / CORNER_GRID;
+}
+
+static float fix_snap(float v)
+{
+    return (floorf(v * FIX_GRID) + 0.5f) / FIX_GRID;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+static const char *time_now;
+
+static void event_print(enum zone_event event, uint32_t zone_id, uint32_t tag_id, float x,
+                        float y, void *user)
+{
+    (void)user;
+    printf("%s,%u,%u,%s,%.2f,%.2f\n", time_now, zone_id, tag_id,
+           event == ZONE_ENTER ? "enter" : "exit", x, y);
+}
+
+static int zones_load(struct zone_index *index, const char *path, uint32_t watch)
+{
+    FILE *f = fopen(path, "r");
+    char line[LINE_MAX_LEN];
+    int count = 0;
+
+    if (!f) {
+        perror(path);
+        return -errno;
+    }
+    for (int n = 1; fgets(line, sizeof(line), f); n++) {
+        struct zone_point points[POINTS_MAX];
+        size_t point_count = 0;
+        char *save;
+        char *tok = strtok_r(line, " \t\r\n", &save);
+
+        if (!tok || tok[0] == '#') {
+            continue;
+        }
+        const uint32_t zone_id = strtoul(tok, NULL, 10);
+        while ((tok = strtok_r(NULL, " \t\r\n", &save)) && point_count < POINTS_MAX) {
+            if (sscanf(tok, "%f,%f", &points[point_count].x, &points[point_count].y) == 2) {
+                point_count++;
+            }
+        }
+
+        int err = zone_add(index, zone_id, points, point_count);
+        if (!err) {
+            err = zone_subscribe(index, zone_id, watch, event_print, NULL);
+        }
+        if (err) {
+            fprintf(stderr, "%s:%d: zone %u not added (err %d)\n", path, n, zone_id, err);
+            continue;
+        }
+        count++;
+    }
+    fclose(f);
+    return count;
+}
+
+static int run(struct zone_index *index, FILE *in)
+{
+    char line[LINE_MAX_LEN];
+    uint64_t updates = 0;
+    uint64_t bad = 0;
+
+    printf("time,zone,tag,event,x,y\n");
+    while (fgets(line, sizeof(line), in)) {
+        char time[64];
+        unsigned int tag_id;
+        float x, y;
+
+        // The header, if any, fails to parse like any other bad line
+        if (sscanf(line, "%63[^,],%u,%f,%f", time, &tag_id, &x, &y) != 4) {
+            bad++;
+            continue;
+        }
+        time_now = time;
+        if (zone_tag_update(index, tag_id, x, y)) {
+            bad++;
+            continue;
+        }
+        updates++;
+    }
+    fprintf(stderr, "%llu positions, %llu lines skipped\n", (unsigned long long)updates,
+            (unsigned long long)bad);
+    return EXIT_SUCCESS;
+}
+
+// Until interrupted; angles on the bus are for other readers
+static int run_bus(struct zone_index *index, const char *name)
+{
+    struct aoa_bus_reader *reader = aoa_bus_attach(name, false);
+    struct aoa_bus_record record;
+    uint64_t lost;
+    int n;
+
+    if (!reader) {
+        fprintf(stderr, "Cannot attach to %s (err %d)\n", name, -errno);
+        return EXIT_FAILURE;
+    }
+    printf("time,zone,tag,event,x,y\n");
+    while (1) {
+        while ((n = aoa_bus_read(reader, &record, &lost)) > 0) {
+            char time[24];
+
+            if (lost) {
+                fprintf(stderr, "%llu bus records lost\n", (unsigned long long)lost);
+            }
+            if (record.type != AOA_BUS_POSITION) {
+                continue;
+            }
+            snprintf(time, sizeof(time), "%llu", (unsigned long long)record.time_us);
+            time_now = time;
+            zone_tag_update(index, record.position.tag_id, record.position.x,
+                            record.position.y);
+        }
+        fflush(stdout);
+        if (n == -EPROTO || aoa_bus_wait(reader, 1000) == -EPROTO) {
+            // Formatted again with another layout: follow the new ring from its start
+            aoa_bus_detach(reader);
+            fprintf(stderr, "%s was formatted again, attaching anew\n", name);
+            while (!(reader = aoa_bus_attach(name, true))) {
+                usleep(100000);
+            }
+        }
+    }
+}
+
+// Same rule as the index: enter inside, leave beyond the margin
+static bool rect_inside(const struct rect *r, float x, float y)
+{
+    return x >= r->x0 && x <= r->x1 && y >= r->y0 && y <= r->y1;
+}
+
+static bool rect_holds(const struct rect *r, float x, float y, float margin)
+{
+    const float dx = fmaxf(fmaxf(r->x0 - x, x - r->x1), 0.0f);
+    const float dy = fmaxf(fmaxf(r->y0 - y, y - r->y1), 0.0f);
+
+    return dx * dx + dy * dy <= margin * margin;
+}
+
+static void event_count(enum zone_event event, uint32_t zone_id, uint32_t tag_id, float x,
+                        float y, void *user)
+{
+    (void)zone_id;
+    (void)tag_id;
+    (void)x;
+    (void)y;
+    ((uint64_t *)user)[event]++;
+}
+
+static int bench(int tag_count, int zone_count, int update_count, float cell_m, float margin)
+{
+    struct zone_index *index = zone_index_create(cell_m, margin);
+    struct rect *rects = calloc(zone_count, sizeof(*rects));
+    struct zone_point *pos = calloc(tag_count, sizeof(*pos));
+    struct zone_point *last = calloc(tag_count, sizeof(*last));
+    struct zone_point *steps = calloc(update_count, sizeof(*steps));
+    uint32_t *tag_ids = calloc(update_count, sizeof(*tag_ids));
+    bool *inside = calloc((size_t)tag_count * zone_count, sizeof(*inside));
+    uint64_t events[2] = { 0 };
+    uint64_t scan_events[2] = { 0 };
+
+    if (!index || !rects || !pos || !last || !steps || !tag_ids || !inside) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int z = 0; z < zone_count; z++) {
+        const float w = rng_uniform(ZONE_MIN_M, ZONE_MAX_M);
+        const float h = rng_uniform(ZONE_MIN_M, ZONE_MAX_M);
+        struct rect *r = &rects[z];
+
+        r->x0 = corner_snap(rng_uniform(0.0f, SITE_M - w));
+        r->y0 = corner_snap(rng_uniform(0.0f, SITE_M - h));
+        r->x1 = corner_snap(r->x0 + w);
+        r->y1 = corner_snap(r->y0 + h);
+        const struct zone_point points[] = {
+            { r->x0, r->y0 }, { r->x1, r->y0 }, { r->x1, r->y1 }, { r->x0, r->y1 },
+        };
+        if (zone_add(index, z, points, ARRAY_SIZE(points)) ||
+            zone_subscribe(index, z, ZONE_ANY_TAG, event_count, events)) {
+            fprintf(stderr, "Zone %d not added\n", z);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Random walks, generated up front so both sides see the same fixes
+    for (int t = 0; t < tag_count; t++) {
+        pos[t] = (struct zone_point){ rng_uniform(0.0f, SITE_M), rng_uniform(0.0f, SITE_M) };
+        last[t] = (struct zone_point){ NAN, NAN };
+    }
+    for (int n = 0; n < update_count; n++) {
+        const uint32_t t = rng_next() % tag_count;
+
+        pos[t].x = fminf(fmaxf(pos[t].x + rng_uniform(-STEP_M, STEP_M), 0.0f), SITE_M);
+        pos[t].y = fminf(fmaxf(pos[t].y + rng_uniform(-STEP_M, STEP_M), 0.0f), SITE_M);
+        tag_ids[n] = t;
+        steps[n] = (struct zone_point){ fix_snap(pos[t].x), fix_snap(pos[t].y) };
+        last[t] = steps[n];
+    }
+
+    double start = now_us();
+    for (int n = 0; n < update_count; n++) {
+        zone_tag_update(index, tag_ids[n], steps[n].x, steps[n].y);
+    }
+    const double grid_us = now_us() - start;
+
+    start = now_us();
+    for (int n = 0; n < update_count; n++) {
+        const uint32_t t = tag_ids[n];
+        const float x = steps[n].x;
+        const float y = steps[n].y;
+
+        for (int z = 0; z < zone_count; z++) {
+            bool *in = &inside[(size_t)t * zone_count + z];
+            const bool now = *in ? rect_holds(&rects[z], x, y, margin) : rect_inside(&rects[z], x, y);
+            if (now != *in) {
+                *in = now;
+                scan_events[now ? ZONE_ENTER : ZONE_EXIT]++;
+            }
+        }
+    }
+    const double scan_us = now_us() - start;
+
+    // Membership from both sides, and what the zone queries return
+    int mismatches = 0;
+    uint64_t members = 0;
+    for (int z = 0; z < zone_count; z++) {
+        int count = 0;
+        for (int t = 0; t < tag_count; t++) {
+            const bool in = inside[(size_t)t * zone_count + z];
+            mismatches += in != zone_contains(index, z, t);
+            count += in;
+        }
+        mismatches += zone_query(index, z, NULL, 0) != count;
+        members += count;
+    }
+    mismatches += events[ZONE_ENTER] != scan_events[ZONE_ENTER];
+    mismatches += events[ZONE_EXIT] != scan_events[ZONE_EXIT];
+
+    // Tags in random squares, against the latest fix of every tag
+    for (int q = 0; q < 100; q++) {
+        const float x0 = rng_uniform(0.0f, SITE_M);
+        const float y0 = rng_uniform(0.0f, SITE_M);
+        const float size = rng_uniform(1.0f, SITE_M / 4);
+        int count = 0;
+
+        for (int t = 0; t < tag_count; t++) {
+            count += !isnan(last[t].x) && last[t].x >= x0 && last[t].x <= x0 + size &&
+                     last[t].y >= y0 && last[t].y <= y0 + size;
+        }
+        mismatches += zone_query_rect(index, x0, y0, x0 + size, y0 + size, NULL, 0) != count;
+    }
+
+    // Every tag leaves every zone it is in as it goes
+    const uint64_t exits = events[ZONE_EXIT];
+    for (int t = 0; t < tag_count; t++) {
+        zone_tag_remove(index, t);
+    }
+    mismatches += events[ZONE_EXIT] - exits != members;
+    for (int z = 0; z < zone_count; z++) {
+        mismatches += zone_query(index, z, NULL, 0) != 0;
+    }
+
+    printf("%d tags, %d zones, %d updates, %.0f m cells, %.1f m margin\n", tag_count,
+           zone_count, update_count, cell_m, margin);
+    printf("Grid index: %.3f us per update; scanning every zone: %.3f us (%.0fx)\n",
+           grid_us / update_count, scan_us / update_count, scan_us / grid_us);
+    printf("%llu enters, %llu exits, %llu memberships at the end: %s\n",
+           (unsigned long long)events[ZONE_ENTER], (unsigned long long)exits,
+           (unsigned long long)members, mismatches ? "MISMATCH with the scan" : "match the scan");
+
+    zone_index_destroy(index);
+    free(rects);
+    free(pos);
+    free(last);
+    free(steps);
+    free(tag_ids);
+    free(inside);
+    return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    float cell_m = 25.0f;
+    float margin = 0.5f;
+    uint32_t watch = ZONE_ANY_TAG;
+    const char *bus_name = NULL;
+    int tag_count = 0;
+    int zone_count = 1000;
+    int update_count = 1000000;
+    int opt;
+
+    rng_state = 0x9e3779b97f4a7c15ULL;
+    while ((opt = getopt(argc, argv, "c:m:t:s:b:z:n:r:")) != -1) {
+        switch (opt) {
+        case 'c':
+            cell_m = atof(optarg);
+            break;
+        case 'm':
+            margin = atof(optarg);
+            break;
+        case 't':
+            watch = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            bus_name = optarg;
+            break;
+        case 'b':
+            tag_count = atoi(optarg);
+            break;
+        case 'z':
+            zone_count = atoi(optarg);
+            break;
+        case 'n':
+            update_count = atoi(optarg);
+            break;
+        case 'r':
+            rng_state = strtoull(optarg, NULL, 0) | 1;
+            break;
+        default:
+            goto usage;
+        }
+    }
+
+    if (tag_count) {
+        if (tag_count < 1 || zone_count < 1 || update_count < 1 || !(cell_m > 0.0f)) {
+            goto usage;
+        }
+        return bench(tag_count, zone_count, update_count, cell_m, margin);
+    }
+    if (optind >= argc || argc - optind > (bus_name ? 1 : 2)) {
+        goto usage;
+    }
+
+    struct zone_index *index = zone_index_create(cell_m, margin);
+    if (!index) {
+        fprintf(stderr, "Cell size and margin must be positive\n");
+        return EXIT_FAILURE;
+    }
+    const int zones = zones_load(index, argv[optind], watch);
+    if (zones < 0) {
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "%d zones\n", zones);
+    if (bus_name) {
+        return run_bus(index, bus_name);
+    }
+
+    FILE *in = stdin;
+    if (argc - optind == 2) {
+        in = fopen(argv[optind + 1], "r");
+        if (!in) {
+            perror(argv[optind + 1]);
+            return EXIT_FAILURE;
+        }
+    }
+    const int ret = run(index, in);
+    zone_index_destroy(index);
+    return ret;
+
+usage:
+    fprintf(stderr,
+            "usage: %s [-c cell_m] [-m margin_m] [-t tag] [-s bus] zones [positions]\n"
+            "       %s -b tags [-z zones] [-n updates] [-c cell_m] [-m margin_m] [-r seed]\n",
+            argv[0], argv[0]);
+    return EXIT_FAILURE;
+}
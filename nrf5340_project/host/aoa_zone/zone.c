@@ -0,0 +1,758 @@
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <aoa/port.h>
+
+#include "zone.h"
+
+#define NONE UINT32_MAX
+
+// Cell coordinates stay well inside int32 whatever the position
+#define CELL_COORD_MAX (1 << 30)
+
+// A zone covering more cells than this wants a larger cell size
+#define ZONE_CELLS_MAX (1 << 20)
+
+// Open addressing with linear probing, 64-bit keys to 32-bit indices
+struct map {
+    uint64_t *keys;
+    uint32_t *vals;             // NONE marks a free slot
+    size_t cap;                 // Power of two
+    size_t len;
+};
+
+// Growable array of indices
+struct list {
+    uint32_t *v;
+    uint32_t len;
+    uint32_t cap;
+};
+
+struct sub {
+    uint32_t tag_id;
+    zone_event_cb cb;
+    void *user;
+};
+
+struct zone {
+    uint32_t id;
+    struct zone_point *points;
+    size_t count;
+    float min_x, min_y, max_x, max_y;
+    int32_t cx0, cy0, cx1, cy1;         // Cells overlapped by the bounding box
+    struct list members;                // Tag indices
+    struct sub *subs;
+    size_t sub_count;
+};
+
+// One zone a tag is in, and where the tag sits in the zone's member list
+struct membership {
+    uint32_t zone;
+    uint32_t slot;
+};
+
+struct tag {
+    uint32_t id;
+    float x, y;
+    uint32_t cell;
+    uint32_t cell_slot;                 // Index in the cell's tag list
+    struct membership *in;
+    uint32_t in_len;
+    uint32_t in_cap;
+};
+
+struct cell {
+    int32_t cx, cy;
+    struct list zones;                  // Zone indices
+    struct list tags;                   // Tag indices
+};
+
+struct zone_index {
+    float cell_m;
+    float margin_m;
+
+    struct zone *zones;
+    uint32_t zone_count;
+    uint32_t zone_cap;
+    struct list free_zones;
+    struct map zone_ids;
+
+    struct tag *tags;
+    uint32_t tag_count;
+    uint32_t tag_cap;
+    struct list free_tags;
+    struct map tag_ids;
+
+    struct cell *cells;
+    uint32_t cell_count;
+    uint32_t cell_cap;
+    struct map cell_keys;
+};
+
+static uint64_t hash64(uint64_t k)
+{
+    // splitmix64 finalizer
+    k ^= k >> 30;
+    k *= 0xbf58476d1ce4e5b9ULL;
+    k ^= k >> 27;
+    k *= 0x94d049bb133111ebULL;
+    return k ^ (k >> 31);
+}
+
+static uint32_t map_get(const struct map *m, uint64_t key)
+{
+    if (!m->cap) {
+        return NONE;
+    }
+    for (size_t i = hash64(key) & (m->cap - 1);; i = (i + 1) & (m->cap - 1)) {
+        if (m->vals[i] == NONE) {
+            return NONE;
+        }
+        if (m->keys[i] == key) {
+            return m->vals[i];
+        }
+    }
+}
+
+static int map_put(struct map *m, uint64_t key, uint32_t val);
+
+static int map_grow(struct map *m)
+{
+    struct map next = {
+        .cap = m->cap ? 2 * m->cap : 64,
+    };
+
+    next.keys = malloc(next.cap * sizeof(*next.keys));
+    next.vals = malloc(next.cap * sizeof(*next.vals));
+    if (!next.keys || !next.vals) {
+        free(next.keys);
+        free(next.vals);
+        return -ENOMEM;
+    }
+    memset(next.vals, 0xff, next.cap * sizeof(*next.vals));
+    for (size_t i = 0; i < m->cap; i++) {
+        if (m->vals[i] != NONE) {
+            map_put(&next, m->keys[i], m->vals[i]);
+        }
+    }
+    free(m->keys);
+    free(m->vals);
+    *m = next;
+    return 0;
+}
+
+static int map_put(struct map *m, uint64_t key, uint32_t val)
+{
+    // At most 3/4 full, so probes stay short
+    if (4 * (m->len + 1) > 3 * m->cap) {
+        const int err = map_grow(m);
+        if (err) {
+            return err;
+        }
+    }
+    size_t i = hash64(key) & (m->cap - 1);
+    while (m->vals[i] != NONE && m->keys[i] != key) {
+        i = (i + 1) & (m->cap - 1);
+    }
+    if (m->vals[i] == NONE) {
+        m->len++;
+    }
+    m->keys[i] = key;
+    m->vals[i] = val;
+    return 0;
+}
+
+static void map_del(struct map *m, uint64_t key)
+{
+    if (!m->cap) {
+        return;
+    }
+    size_t i = hash64(key) & (m->cap - 1);
+    while (m->vals[i] != NONE && m->keys[i] != key) {
+        i = (i + 1) & (m->cap - 1);
+    }
+    if (m->vals[i] == NONE) {
+        return;
+    }
+
+    // Shift later entries of the probe run back, so no tombstones are needed
+    for (size_t j = (i + 1) & (m->cap - 1); m->vals[j] != NONE; j = (j + 1) & (m->cap - 1)) {
+        const size_t home = hash64(m->keys[j]) & (m->cap - 1);
+        if (((j - home) & (m->cap - 1)) >= ((j - i) & (m->cap - 1))) {
+            m->keys[i] = m->keys[j];
+            m->vals[i] = m->vals[j];
+            i = j;
+        }
+    }
+    m->vals[i] = NONE;
+    m->len--;
+}
+
+static void map_free(struct map *m)
+{
+    free(m->keys);
+    free(m->vals);
+}
+
+static int list_push(struct list *l, uint32_t v)
+{
+    if (l->len == l->cap) {
+        const uint32_t cap = l->cap ? 2 * l->cap : 4;
+        uint32_t *next = realloc(l->v, cap * sizeof(*next));
+        if (!next) {
+            return -ENOMEM;
+        }
+        l->v = next;
+        l->cap = cap;
+    }
+    l->v[l->len++] = v;
+    return 0;
+}
+
+// Grow an array of elements of @p size to hold @p need, doubling
+static int array_reserve(void **array, uint32_t *cap, uint32_t need, size_t size)
+{
+    if (need <= *cap) {
+        return 0;
+    }
+    const uint32_t next_cap = MAX(need, *cap ? 2 * *cap : 16);
+    void *next = realloc(*array, (size_t)next_cap * size);
+    if (!next) {
+        return -ENOMEM;
+    }
+    *array = next;
+    *cap = next_cap;
+    return 0;
+}
+
+static int32_t cell_coord(const struct zone_index *index, float v)
+{
+    const float c = floorf(v / index->cell_m);
+
+    return (int32_t)CLAMP(c, -CELL_COORD_MAX, CELL_COORD_MAX);
+}
+
+static uint64_t cell_key(int32_t cx, int32_t cy)
+{
+    return (uint64_t)(uint32_t)cx << 32 | (uint32_t)cy;
+}
+
+static uint32_t cell_find(const struct zone_index *index, int32_t cx, int32_t cy)
+{
+    return map_get(&index->cell_keys, cell_key(cx, cy));
+}
+
+// Cells are never freed: they are bounded by the area tags and zones have covered
+static uint32_t cell_get(struct zone_index *index, int32_t cx, int32_t cy)
+{
+    uint32_t c = cell_find(index, cx, cy);
+    if (c != NONE) {
+        return c;
+    }
+    if (array_reserve((void **)&index->cells, &index->cell_cap, index->cell_count + 1,
+                      sizeof(*index->cells))) {
+        return NONE;
+    }
+    c = index->cell_count;
+    if (map_put(&index->cell_keys, cell_key(cx, cy), c)) {
+        return NONE;
+    }
+    index->cells[c] = (struct cell){ .cx = cx, .cy = cy };
+    index->cell_count++;
+    return c;
+}
+
+// Crossing test: a ray to +x crosses the boundary an odd number of times from inside
+static bool polygon_contains(const struct zone *z, float x, float y)
+{
+    bool inside = false;
+
+    if (x < z->min_x || x > z->max_x || y < z->min_y || y > z->max_y) {
+        return false;
+    }
+    for (size_t i = 0, j = z->count - 1; i < z->count; j = i++) {
+        const struct zone_point *a = &z->points[i];
+        const struct zone_point *b = &z->points[j];
+        if ((a->y > y) != (b->y > y) && x < (b->x - a->x) * (y - a->y) / (b->y - a->y) + a->x) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+static float segment_dist2(const struct zone_point *a, const struct zone_point *b, float x, float y)
+{
+    const float dx = b->x - a->x;
+    const float dy = b->y - a->y;
+    const float len2 = dx * dx + dy * dy;
+    float t = len2 > 0.0f ? ((x - a->x) * dx + (y - a->y) * dy) / len2 : 0.0f;
+
+    t = CLAMP(t, 0.0f, 1.0f);
+    const float ex = a->x + t * dx - x;
+    const float ey = a->y + t * dy - y;
+    return ex * ex + ey * ey;
+}
+
+// Inside, or outside by no more than the margin: a member stays a member
+static bool polygon_holds(const struct zone_index *index, const struct zone *z, float x, float y)
+{
+    const float m = index->margin_m;
+
+    if (x < z->min_x - m || x > z->max_x + m || y < z->min_y - m || y > z->max_y + m) {
+        return false;
+    }
+    if (polygon_contains(z, x, y)) {
+        return true;
+    }
+    for (size_t i = 0, j = z->count - 1; i < z->count; j = i++) {
+        if (segment_dist2(&z->points[i], &z->points[j], x, y) <= m * m) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void event_fire(const struct zone *z, const struct tag *t, enum zone_event event)
+{
+    for (size_t i = 0; i < z->sub_count; i++) {
+        const struct sub *s = &z->subs[i];
+        if (s->tag_id == ZONE_ANY_TAG || s->tag_id == t->id) {
+            s->cb(event, z->id, t->id, t->x, t->y, s->user);
+        }
+    }
+}
+
+static int membership_add(struct zone_index *index, uint32_t t, uint32_t z)
+{
+    struct tag *tag = &index->tags[t];
+    struct zone *zone = &index->zones[z];
+
+    if (array_reserve((void **)&tag->in, &tag->in_cap, tag->in_len + 1, sizeof(*tag->in))) {
+        return -ENOMEM;
+    }
+    const uint32_t slot = zone->members.len;
+    if (list_push(&zone->members, t)) {
+        return -ENOMEM;
+    }
+    tag->in[tag->in_len++] = (struct membership){ .zone = z, .slot = slot };
+    return 0;
+}
+
+// Remove the tag's i-th membership; the last member of the zone takes its slot
+static void membership_remove(struct zone_index *index, uint32_t t, uint32_t i)
+{
+    struct tag *tag = &index->tags[t];
+    const struct membership m = tag->in[i];
+    struct list *members = &index->zones[m.zone].members;
+    const uint32_t last = members->v[--members->len];
+
+    if (m.slot != members->len) {
+        struct tag *moved = &index->tags[last];
+
+        members->v[m.slot] = last;
+        for (uint32_t k = 0; k < moved->in_len; k++) {
+            if (moved->in[k].zone == m.zone) {
+                moved->in[k].slot = m.slot;
+                break;
+            }
+        }
+    }
+    tag->in[i] = tag->in[--tag->in_len];
+}
+
+static bool tag_in(const struct tag *tag, uint32_t z)
+{
+    for (uint32_t k = 0; k < tag->in_len; k++) {
+        if (tag->in[k].zone == z) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void cell_tag_remove(struct zone_index *index, uint32_t t)
+{
+    struct tag *tag = &index->tags[t];
+    struct list *tags = &index->cells[tag->cell].tags;
+    const uint32_t last = tags->v[--tags->len];
+
+    if (tag->cell_slot != tags->len) {
+        tags->v[tag->cell_slot] = last;
+        index->tags[last].cell_slot = tag->cell_slot;
+    }
+    tag->cell = NONE;
+}
+
+struct zone_index *zone_index_create(float cell_m, float margin_m)
+{
+    if (!(cell_m > 0.0f) || !(margin_m >= 0.0f) || !isfinite(cell_m) || !isfinite(margin_m)) {
+        return NULL;
+    }
+
+    struct zone_index *index = calloc(1, sizeof(*index));
+    if (index) {
+        index->cell_m = cell_m;
+        index->margin_m = margin_m;
+    }
+    return index;
+}
+
+void zone_index_destroy(struct zone_index *index)
+{
+    if (!index) {
+        return;
+    }
+    for (uint32_t z = 0; z < index->zone_count; z++) {
+        free(index->zones[z].points);
+        free(index->zones[z].members.v);
+        free(index->zones[z].subs);
+    }
+    for (uint32_t t = 0; t < index->tag_count; t++) {
+        free(index->tags[t].in);
+    }
+    for (uint32_t c = 0; c < index->cell_count; c++) {
+        free(index->cells[c].zones.v);
+        free(index->cells[c].tags.v);
+    }
+    free(index->zones);
+    free(index->free_zones.v);
+    map_free(&index->zone_ids);
+    free(index->tags);
+    free(index->free_tags.v);
+    map_free(&index->tag_ids);
+    free(index->cells);
+    map_free(&index->cell_keys);
+    free(index);
+}
+
+// Take the zone out of its cells; ones it never reached are skipped
+static void zone_unlink(struct zone_index *index, uint32_t z)
+{
+    const struct zone *zone = &index->zones[z];
+
+    for (int32_t cy = zone->cy0; cy <= zone->cy1; cy++) {
+        for (int32_t cx = zone->cx0; cx <= zone->cx1; cx++) {
+            const uint32_t c = cell_find(index, cx, cy);
+            if (c == NONE) {
+                continue;
+            }
+            struct list *zones = &index->cells[c].zones;
+            for (uint32_t k = 0; k < zones->len; k++) {
+                if (zones->v[k] == z) {
+                    zones->v[k] = zones->v[--zones->len];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void zone_release(struct zone_index *index, uint32_t z)
+{
+    struct zone *zone = &index->zones[z];
+
+    free(zone->points);
+    free(zone->members.v);
+    free(zone->subs);
+    *zone = (struct zone){ 0 };
+
+    // Only fails out of memory, which leaks the slot rather than reusing it
+    list_push(&index->free_zones, z);
+}
+
+int zone_add(struct zone_index *index, uint32_t zone_id, const struct zone_point *points,
+             size_t count)
+{
+    if (count < 3) {
+        return -EINVAL;
+    }
+    if (map_get(&index->zone_ids, zone_id) != NONE) {
+        return -EEXIST;
+    }
+
+    struct zone z = {
+        .id = zone_id,
+        .count = count,
+        .min_x = INFINITY, .min_y = INFINITY, .max_x = -INFINITY, .max_y = -INFINITY,
+    };
+    for (size_t i = 0; i < count; i++) {
+        if (!isfinite(points[i].x) || !isfinite(points[i].y)) {
+            return -EINVAL;
+        }
+        z.min_x = fminf(z.min_x, points[i].x);
+        z.min_y = fminf(z.min_y, points[i].y);
+        z.max_x = fmaxf(z.max_x, points[i].x);
+        z.max_y = fmaxf(z.max_y, points[i].y);
+    }
+
+    // The margin lets members stray outside the box, but never in from another cell
+    z.cx0 = cell_coord(index, z.min_x);
+    z.cy0 = cell_coord(index, z.min_y);
+    z.cx1 = cell_coord(index, z.max_x);
+    z.cy1 = cell_coord(index, z.max_y);
+    if ((int64_t)(z.cx1 - z.cx0 + 1) * (z.cy1 - z.cy0 + 1) > ZONE_CELLS_MAX) {
+        return -E2BIG;
+    }
+
+    z.points = malloc(count * sizeof(*points));
+    if (!z.points) {
+        return -ENOMEM;
+    }
+    memcpy(z.points, points, count * sizeof(*points));
+
+    uint32_t slot;
+    if (index->free_zones.len) {
+        slot = index->free_zones.v[--index->free_zones.len];
+    } else if (!array_reserve((void **)&index->zones, &index->zone_cap, index->zone_count + 1,
+                              sizeof(*index->zones))) {
+        slot = index->zone_count++;
+    } else {
+        free(z.points);
+        return -ENOMEM;
+    }
+    index->zones[slot] = z;
+    if (map_put(&index->zone_ids, zone_id, slot)) {
+        zone_release(index, slot);
+        return -ENOMEM;
+    }
+
+    for (int32_t cy = z.cy0; cy <= z.cy1; cy++) {
+        for (int32_t cx = z.cx0; cx <= z.cx1; cx++) {
+            const uint32_t c = cell_get(index, cx, cy);
+            if (c == NONE || list_push(&index->cells[c].zones, slot)) {
+                zone_remove(index, zone_id);
+                return -ENOMEM;
+            }
+
+            // Tags already here join; nobody can have subscribed yet
+            const struct list *tags = &index->cells[c].tags;
+            for (uint32_t k = 0; k < tags->len; k++) {
+                const struct tag *tag = &index->tags[tags->v[k]];
+                if (polygon_contains(&index->zones[slot], tag->x, tag->y) &&
+                    membership_add(index, tags->v[k], slot)) {
+                    zone_remove(index, zone_id);
+                    return -ENOMEM;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int zone_remove(struct zone_index *index, uint32_t zone_id)
+{
+    const uint32_t z = map_get(&index->zone_ids, zone_id);
+    if (z == NONE) {
+        return -ENOENT;
+    }
+
+    struct zone *zone = &index->zones[z];
+    while (zone->members.len) {
+        const uint32_t t = zone->members.v[zone->members.len - 1];
+        struct tag *tag = &index->tags[t];
+
+        for (uint32_t k = 0; k < tag->in_len; k++) {
+            if (tag->in[k].zone == z) {
+                membership_remove(index, t, k);
+                break;
+            }
+        }
+    }
+    zone_unlink(index, z);
+    zone_release(index, z);
+    map_del(&index->zone_ids, zone_id);
+    return 0;
+}
+
+int zone_subscribe(struct zone_index *index, uint32_t zone_id, uint32_t tag_id,
+                   zone_event_cb cb, void *user)
+{
+    const uint32_t z = map_get(&index->zone_ids, zone_id);
+    if (z == NONE) {
+        return -ENOENT;
+    }
+
+    struct zone *zone = &index->zones[z];
+    struct sub *subs = realloc(zone->subs, (zone->sub_count + 1) * sizeof(*subs));
+    if (!subs) {
+        return -ENOMEM;
+    }
+    subs[zone->sub_count++] = (struct sub){ .tag_id = tag_id, .cb = cb, .user = user };
+    zone->subs = subs;
+    return 0;
+}
+
+static uint32_t tag_get(struct zone_index *index, uint32_t tag_id)
+{
+    uint32_t t = map_get(&index->tag_ids, tag_id);
+    if (t != NONE) {
+        return t;
+    }
+
+    if (index->free_tags.len) {
+        t = index->free_tags.v[--index->free_tags.len];
+    } else if (!array_reserve((void **)&index->tags, &index->tag_cap, index->tag_count + 1,
+                              sizeof(*index->tags))) {
+        t = index->tag_count++;
+    } else {
+        return NONE;
+    }
+    if (map_put(&index->tag_ids, tag_id, t)) {
+        list_push(&index->free_tags, t);
+        return NONE;
+    }
+    index->tags[t] = (struct tag){ .id = tag_id, .cell = NONE };
+    return t;
+}
+
+int zone_tag_update(struct zone_index *index, uint32_t tag_id, float x, float y)
+{
+    if (!isfinite(x) || !isfinite(y)) {
+        return -EINVAL;
+    }
+    const uint32_t t = tag_get(index, tag_id);
+    if (t == NONE) {
+        return -ENOMEM;
+    }
+
+    const uint32_t c = cell_get(index, cell_coord(index, x), cell_coord(index, y));
+    if (c == NONE) {
+        return -ENOMEM;
+    }
+    if (index->tags[t].cell != c) {
+        if (index->tags[t].cell != NONE) {
+            cell_tag_remove(index, t);
+        }
+        const uint32_t slot = index->cells[c].tags.len;
+        if (list_push(&index->cells[c].tags, t)) {
+            return -ENOMEM;
+        }
+        index->tags[t].cell = c;
+        index->tags[t].cell_slot = slot;
+    }
+
+    struct tag *tag = &index->tags[t];
+    tag->x = x;
+    tag->y = y;
+
+    // Zones it is in, wherever they are; removal moves the last one into i
+    for (uint32_t i = tag->in_len; i-- > 0;) {
+        const uint32_t z = tag->in[i].zone;
+        if (!polygon_holds(index, &index->zones[z], x, y)) {
+            membership_remove(index, t, i);
+            event_fire(&index->zones[z], tag, ZONE_EXIT);
+        }
+    }
+
+    // Zones it may have entered: only those overlapping its cell
+    const struct list *zones = &index->cells[c].zones;
+    for (uint32_t k = 0; k < zones->len; k++) {
+        const uint32_t z = zones->v[k];
+        if (tag_in(tag, z) || !polygon_contains(&index->zones[z], x, y)) {
+            continue;
+        }
+        if (membership_add(index, t, z)) {
+            return -ENOMEM;
+        }
+        event_fire(&index->zones[z], tag, ZONE_ENTER);
+    }
+    return 0;
+}
+
+int zone_tag_remove(struct zone_index *index, uint32_t tag_id)
+{
+    const uint32_t t = map_get(&index->tag_ids, tag_id);
+    if (t == NONE) {
+        return -ENOENT;
+    }
+
+    struct tag *tag = &index->tags[t];
+    while (tag->in_len) {
+        const uint32_t z = tag->in[tag->in_len - 1].zone;
+        membership_remove(index, t, tag->in_len - 1);
+        event_fire(&index->zones[z], tag, ZONE_EXIT);
+    }
+    if (tag->cell != NONE) {
+        cell_tag_remove(index, t);
+    }
+    free(tag->in);
+    *tag = (struct tag){ .cell = NONE };
+    map_del(&index->tag_ids, tag_id);
+    list_push(&index->free_tags, t);
+    return 0;
+}
+
+int zone_query(const struct zone_index *index, uint32_t zone_id, uint32_t *tag_ids, size_t max)
+{
+    const uint32_t z = map_get(&index->zone_ids, zone_id);
+    if (z == NONE) {
+        return -ENOENT;
+    }
+
+    const struct list *members = &index->zones[z].members;
+    for (uint32_t k = 0; k < members->len && k < max; k++) {
+        tag_ids[k] = index->tags[members->v[k]].id;
+    }
+    return members->len;
+}
+
+static size_t cell_collect(const struct zone_index *index, const struct cell *cell, float x0,
+                           float y0, float x1, float y1, uint32_t *tag_ids, size_t max,
+                           size_t found)
+{
+    for (uint32_t k = 0; k < cell->tags.len; k++) {
+        const struct tag *tag = &index->tags[cell->tags.v[k]];
+        if (tag->x >= x0 && tag->x <= x1 && tag->y >= y0 && tag->y <= y1) {
+            if (found < max) {
+                tag_ids[found] = tag->id;
+            }
+            found++;
+        }
+    }
+    return found;
+}
+
+int zone_query_rect(const struct zone_index *index, float x0, float y0, float x1, float y1,
+                    uint32_t *tag_ids, size_t max)
+{
+    const int32_t cx0 = cell_coord(index, x0);
+    const int32_t cy0 = cell_coord(index, y0);
+    const int32_t cx1 = cell_coord(index, x1);
+    const int32_t cy1 = cell_coord(index, y1);
+    size_t found = 0;
+
+    if (x0 > x1 || y0 > y1) {
+        return 0;
+    }
+
+    // A rectangle wider than the covered area is cheaper to answer from every cell
+    if ((int64_t)(cx1 - cx0 + 1) * (cy1 - cy0 + 1) > (int64_t)index->cell_count) {
+        for (uint32_t c = 0; c < index->cell_count; c++) {
+            const struct cell *cell = &index->cells[c];
+            if (cell->cx >= cx0 && cell->cx <= cx1 && cell->cy >= cy0 && cell->cy <= cy1) {
+                found = cell_collect(index, cell, x0, y0, x1, y1, tag_ids, max, found);
+            }
+        }
+        return found;
+    }
+    for (int32_t cy = cy0; cy <= cy1; cy++) {
+        for (int32_t cx = cx0; cx <= cx1; cx++) {
+            const uint32_t c = cell_find(index, cx, cy);
+            if (c != NONE) {
+                found = cell_collect(index, &index->cells[c], x0, y0, x1, y1, tag_ids, max,
+                                     found);
+            }
+        }
+    }
+    return found;
+}
+
+bool zone_contains(const struct zone_index *index, uint32_t zone_id, uint32_t tag_id)
+{
+    const uint32_t z = map_get(&index->zone_ids, zone_id);
+    const uint32_t t = map_get(&index->tag_ids, tag_id);
+
+    return z != NONE && t != NONE && tag_in(&index->tags[t], z);
+}
@@ -0,0 +1,105 @@
+#ifndef AOA_HOST_ZONE_H_
+#define AOA_HOST_ZONE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Zone membership of tags from their latest positions, kept up to date as
+ * fixes arrive. Zones are polygons in the same plane coordinates as the
+ * positions (metres). Both zones and tags sit in a uniform grid: a cell
+ * lists the zones whose bounding box overlaps it and the tags inside it.
+ * A position update only tests the zones of the tag's cell and the zones
+ * the tag is already in, so its cost depends on how many zones overlap
+ * one cell, not on the number of zones or tags. Membership per zone is
+ * kept as well, so "which tags are in zone X" is a copy.
+ *
+ * A tag inside a zone only leaves it once it is more than the margin
+ * outside, so positions jittering along an edge do not fire a stream of
+ * events. Subscriptions fire on enter and exit, for one tag or any.
+ *
+ * Not thread safe; callbacks run inside the call that caused them and
+ * must not change the index.
+ */
+
+#define ZONE_ANY_TAG UINT32_MAX
+
+struct zone_point {
+    float x;
+    float y;
+};
+
+enum zone_event {
+    ZONE_ENTER,
+    ZONE_EXIT,
+};
+
+typedef void (*zone_event_cb)(enum zone_event event, uint32_t zone_id, uint32_t tag_id,
+                              float x, float y, void *user);
+
+struct zone_index;
+
+/**
+ * @brief Create an empty index.
+ *
+ * @param cell_m   Grid cell size. About the size of the smaller zones works well.
+ * @param margin_m Distance a tag must be outside a zone before it leaves it.
+ *
+ * @return The index, or NULL if out of memory or the sizes are not positive.
+ */
+struct zone_index *zone_index_create(float cell_m, float margin_m);
+
+void zone_index_destroy(struct zone_index *index);
+
+/**
+ * @brief Add a zone. Tags already inside it enter it.
+ *
+ * @param points Vertices in order, closed implicitly; at least 3.
+ *
+ * @return 0, -EEXIST if @p zone_id is taken, -EINVAL or -ENOMEM.
+ */
+int zone_add(struct zone_index *index, uint32_t zone_id, const struct zone_point *points,
+             size_t count);
+
+/** @brief Remove a zone and its subscriptions. No exit events fire. */
+int zone_remove(struct zone_index *index, uint32_t zone_id);
+
+/**
+ * @brief Call @p cb when @p tag_id, or any tag with ZONE_ANY_TAG, enters or leaves a zone.
+ *
+ * @return 0, -ENOENT if the zone does not exist, or -ENOMEM.
+ */
+int zone_subscribe(struct zone_index *index, uint32_t zone_id, uint32_t tag_id,
+                   zone_event_cb cb, void *user);
+
+/**
+ * @brief Record the latest position of a tag, adding the tag if it is new.
+ *
+ * @return 0, -EINVAL for a position that is not finite, or -ENOMEM.
+ */
+int zone_tag_update(struct zone_index *index, uint32_t tag_id, float x, float y);
+
+/** @brief Forget a tag; it leaves every zone it is in. */
+int zone_tag_remove(struct zone_index *index, uint32_t tag_id);
+
+/**
+ * @brief Tags in a zone.
+ *
+ * @return The number of tags in the zone, of which up to @p max are
+ *         copied, or -ENOENT.
+ */
+int zone_query(const struct zone_index *index, uint32_t zone_id, uint32_t *tag_ids, size_t max);
+
+/**
+ * @brief Tags whose latest position lies in the rectangle [x0, x1] x [y0, y1].
+ *
+ * @return The number of tags found, of which up to @p max are copied.
+ */
+int zone_query_rect(const struct zone_index *index, float x0, float y0, float x1, float y1,
+                    uint32_t *tag_ids, size_t max);
+
+/** @brief True if @p tag_id is in @p zone_id. */
+bool zone_contains(const struct zone_index *index, uint32_t zone_id, uint32_t tag_id);
+
+#endif /* AOA_HOST_ZONE_H_ */
@@ -0,0 +1,55 @@
+# Host stand-ins for the aoa_rx Kconfig symbols the core reads, with the
+# same defaults. Choices are strings named after the Kconfig choice, e.g.
+#   cmake -DAOA_RX_ESTIMATOR=MUSIC -DAOA_RX_ARRAY_GEOMETRY=URA
+# and integers keep their Kconfig names, e.g. -DCONFIG_AOA_RX_ANT_COLS=8.
+# Each ends up both as a CMake variable, for source selection, and as a
+# compile definition, as Zephyr's autoconf.h would provide it.
+
+set(AOA_RX_ARRAY_GEOMETRY ULA CACHE STRING "ULA or URA")
+set(AOA_RX_SLOT 1US CACHE STRING "Switching slot duration, 1US or 2US")
+set(AOA_RX_MATH FLOAT CACHE STRING "FLOAT or FIXED")
+set(AOA_RX_ESTIMATOR PHASE_DIFF CACHE STRING "PHASE_DIFF, BARTLETT or MUSIC")
+set(AOA_RX_COV_MODE EWMA CACHE STRING "Covariance update, EWMA or WINDOW")
+set(AOA_RX_TRACK NONE CACHE STRING "Tracking filter, NONE, EMA or ALPHA_BETA")
+option(AOA_RX_COVARIANCE "Per-tag covariance for the Bartlett estimator; MUSIC always keeps one" ON)
+option(AOA_CORE_SIMD "Spectrum kernels for AVX2 or NEON, picked at run time" ON)
+
+set(CONFIG_AOA_RX_MAX_TAGS 32 CACHE STRING "Tags tracked at once")
+set(CONFIG_AOA_RX_CTE_LEN 20 CACHE STRING "Longest CTE in 8 us units")
+set(CONFIG_AOA_RX_ANT_COLS 4 CACHE STRING "Array columns")
+set(CONFIG_AOA_RX_ANT_ROWS 4 CACHE STRING "Array rows (URA)")
+set(CONFIG_AOA_RX_ANT_SPACING_UM 37500 CACHE STRING "Element spacing in um")
+set(CONFIG_AOA_RX_SLOT_SAMPLES 1 CACHE STRING "Samples per sample slot")
+set(CONFIG_AOA_RX_SCAN_COARSE_DEG 10 CACHE STRING "Coarse scan grid step")
+set(CONFIG_AOA_RX_SCAN_STEP_DEG 1 CACHE STRING "Scan refinement step")
+set(CONFIG_AOA_RX_SCAN_PEAKS 2 CACHE STRING "Peaks refined per scan")
+set(CONFIG_AOA_RX_MUSIC_PATHS 1 CACHE STRING "MUSIC signal subspace dimension")
+set(CONFIG_AOA_RX_EIG_SWEEPS 6 CACHE STRING "Jacobi sweeps")
+set(CONFIG_AOA_RX_COV_SNAPSHOTS 8 CACHE STRING "Covariance snapshots")
+set(CONFIG_AOA_RX_TRACK_ALPHA 30 CACHE STRING "Filter alpha (percent)")
+set(CONFIG_AOA_RX_TRACK_BETA 5 CACHE STRING "Filter beta (percent)")
+
+if(NOT AOA_RX_ESTIMATOR STREQUAL "PHASE_DIFF" AND AOA_RX_MATH STREQUAL "FIXED")
+  message(FATAL_ERROR "The ${AOA_RX_ESTIMATOR} estimator needs AOA_RX_MATH=FLOAT")
+endif()
+
+set(AOA_CORE_DEFINITIONS)
+
+foreach(choice ARRAY_GEOMETRY:ARRAY SLOT:SLOT MATH:MATH ESTIMATOR:EST COV_MODE:COV TRACK:TRACK)
+  string(REPLACE ":" ";" choice ${choice})
+  list(GET choice 0 name)
+  list(GET choice 1 prefix)
+  set(CONFIG_AOA_RX_${prefix}_${AOA_RX_${name}} y)
+  list(APPEND AOA_CORE_DEFINITIONS CONFIG_AOA_RX_${prefix}_${AOA_RX_${name}}=1)
+endforeach()
+
+if(CONFIG_AOA_RX_EST_MUSIC OR (CONFIG_AOA_RX_EST_BARTLETT AND AOA_RX_COVARIANCE))
+  set(CONFIG_AOA_RX_COVARIANCE y)
+  list(APPEND AOA_CORE_DEFINITIONS CONFIG_AOA_RX_COVARIANCE=1)
+endif()
+
+foreach(symbol MAX_TAGS CTE_LEN ANT_COLS ANT_ROWS ANT_SPACING_UM SLOT_SAMPLES SCAN_COARSE_DEG
+               SCAN_STEP_DEG SCAN_PEAKS MUSIC_PATHS EIG_SWEEPS COV_SNAPSHOTS TRACK_ALPHA
+               TRACK_BETA)
+  list(APPEND AOA_CORE_DEFINITIONS CONFIG_AOA_RX_${symbol}=${CONFIG_AOA_RX_${symbol}})
+endforeach()
@@ -0,0 +1,65 @@
+#ifndef AOA_CORE_ARRAY_H_
+#define AOA_CORE_ARRAY_H_
+
+#include "aoa/port.h"
+
+/*
+ * Locator antenna array, fixed by Kconfig (or its host stand-ins, see
+ * host.cmake). Elements are numbered row by row, element 0 first; a linear
+ * array is a single row.
+ */
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+#define AOA_ANT_ROWS CONFIG_AOA_RX_ANT_ROWS
+#else
+#define AOA_ANT_ROWS 1
+#endif
+#define AOA_ANT_COLS CONFIG_AOA_RX_ANT_COLS
+#define AOA_ANT_COUNT (AOA_ANT_ROWS * AOA_ANT_COLS)
+#define AOA_ANT_SPACING_UM CONFIG_AOA_RX_ANT_SPACING_UM
+#define AOA_ANT_SPACING_M (AOA_ANT_SPACING_UM * 1e-6f)
+
+#define AOA_ANT_MAX 16
+
+BUILD_ASSERT(AOA_ANT_COUNT <= AOA_ANT_MAX, "At most 16 antenna elements are supported");
+
+/* Switching slot durations as coded in the HCI IQ reports */
+#define AOA_SLOT_DURATION_1US 0x01
+#define AOA_SLOT_DURATION_2US 0x02
+
+/*
+ * Switching slot duration and the resulting spacing of the normalized IQ
+ * samples after the reference period: one per sample slot, however many
+ * the controller takes (AOA_SLOT_SAMPLES, averaged by the front end).
+ */
+#if defined(CONFIG_AOA_RX_SLOT_2US)
+#define AOA_SLOT_DURATION AOA_SLOT_DURATION_2US
+#define AOA_SAMPLE_SPACING_US 4
+#else
+#define AOA_SLOT_DURATION AOA_SLOT_DURATION_1US
+#define AOA_SAMPLE_SPACING_US 2
+#endif
+#define AOA_SLOT_SAMPLES CONFIG_AOA_RX_SLOT_SAMPLES
+
+/* 8 us reference period sampled every 1 us */
+#define AOA_REF_SAMPLES 8
+
+/*
+ * Normalized sample n is taken aoa_sample_time_us(n) us after the start of
+ * the reference period: every microsecond during it, then in the middle of
+ * each sample slot. Element 0 receives the reference period and switching
+ * starts at element 1.
+ */
+static inline int aoa_sample_time_us(int n)
+{
+    if (n < AOA_REF_SAMPLES) {
+        return n;
+    }
+    return AOA_REF_SAMPLES + AOA_SAMPLE_SPACING_US * (n - AOA_REF_SAMPLES) + AOA_SAMPLE_SPACING_US / 2;
+}
+
+static inline int aoa_sample_ant(int n)
+{
+    return n < AOA_REF_SAMPLES ? 0 : (n - AOA_REF_SAMPLES + 1) % AOA_ANT_COUNT;
+}
+
+#endif /* AOA_CORE_ARRAY_H_ */
@@ -0,0 +1,62 @@
+#ifndef AOA_CORE_CALIB_H_
+#define AOA_CORE_CALIB_H_
+
+#include <stdint.h>
+
+#include "aoa/port.h"
+#include "aoa/array.h"
+#include "aoa/report.h"
+
+/*
+ * Per-channel gain and phase calibration of the array. Cables, matching
+ * and the switch give every element its own offset, and the offsets
+ * change across the band. Each element's phasor is multiplied by a
+ * complex weight for the report's channel as soon as the snapshot is
+ * built, which maps the array's response back onto the ideal one relative
+ * to element 0. Weights come from reports of a reference tag at a known
+ * direction: aoa_calib_measure() sums them per channel and
+ * aoa_calib_solve() turns the sums into weights.
+ */
+
+/* BLE channel indices, data and advertising */
+#define AOA_CALIB_CHANNELS 40
+
+/* Weights are Q14, so a part reaches just under +-2 */
+#define AOA_CALIB_ONE (1 << 14)
+
+struct aoa_calib {
+    struct aoa_iq_sample w[AOA_CALIB_CHANNELS][AOA_ANT_COUNT];   // I real, Q imaginary, Q14
+    uint64_t channels;                  // Bit per channel with measured weights
+};
+
+/* Sums over a reference tag's reports, with x the snapshot per sample */
+struct aoa_calib_acc {
+    float re[AOA_CALIB_CHANNELS][AOA_ANT_COUNT];    // x[m] * conj(x[0]) / |x|^2
+    float im[AOA_CALIB_CHANNELS][AOA_ANT_COUNT];
+    float mag[AOA_CALIB_CHANNELS][AOA_ANT_COUNT];   // |x[m]| / |x|
+    uint16_t count[AOA_CALIB_CHANNELS];
+};
+
+/** @brief Unit weights on every channel, as an uncalibrated array. */
+void aoa_calib_reset(struct aoa_calib *calib);
+
+/**
+ * @brief Add a report from the reference tag to the sums of its channel.
+ *
+ * @return 0, or -EINVAL if the report has no usable snapshot or channel.
+ */
+int aoa_calib_measure(struct aoa_calib_acc *acc, const struct aoa_iq_report *report);
+
+/**
+ * @brief Weights for one channel from its sums.
+ *
+ * @param azimuth, elevation Direction of the reference tag in degrees, as
+ *                           the estimators report it.
+ *
+ * @return 0, -ENODATA if the channel has no reports, or -ERANGE if an
+ *         element is too weak to correct within the Q14 range.
+ */
+int aoa_calib_solve(const struct aoa_calib_acc *acc, uint8_t chan_idx, float azimuth,
+                    float elevation, struct aoa_iq_sample w[AOA_ANT_COUNT]);
+
+#endif /* AOA_CORE_CALIB_H_ */
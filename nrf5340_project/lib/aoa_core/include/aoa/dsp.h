@@ -0,0 +1,228 @@
+#ifndef AOA_CORE_DSP_H_
+#define AOA_CORE_DSP_H_
+
+#include <stdint.h>
+
+#include "aoa/port.h"
+#include "aoa/array.h"
+#include "aoa/calib.h"
+#include "aoa/report.h"
+
+/*
+ * Interface between the DSP thread, or a host tool, and the estimator
+ * stages. Which implementation backs each stage is fixed by Kconfig, so
+ * only the configured path is built.
+ */
+
+#define SPEED_OF_LIGHT 299792458 // m/s
+
+/* Loops over antenna elements have compile-time bounds; unroll them even in -Os builds */
+#define AOA_UNROLL _Pragma("GCC unroll 16")
+
+#if defined(CONFIG_AOA_RX_MATH_FIXED)
+/* Per-element phasor in raw IQ units scaled by 2^4 and the CORDIC gain */
+struct cplx {
+    int32_t re;
+    int32_t im;
+};
+#else
+struct cplx {
+    float re;
+    float im;
+};
+#endif
+
+/*
+ * Reports of a tag further apart than this many of its steps restart its
+ * covariance and track. The step is the shortest gap in events seen since
+ * the restart, so it follows a duty-cycle skip of any length; raising the
+ * skip costs one restart.
+ */
+#define EVENT_GAP_STEPS 32
+
+/** @brief Whether @p dt events since the last report are a gap, learning the step from it. */
+static inline bool event_gap(uint16_t dt, uint16_t *step)
+{
+    if (*step && dt > (uint32_t)EVENT_GAP_STEPS * *step) {
+        return true;
+    }
+    // Several CTEs in one event give dt 0, which says nothing about the step
+    if (dt && (!*step || dt < *step)) {
+        *step = dt;
+    }
+    return false;
+}
+
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+/* Upper triangle of an AOA_ANT_COUNT square Hermitian matrix, row by row */
+#define COV_ENTRIES (AOA_ANT_COUNT * (AOA_ANT_COUNT + 1) / 2)
+
+/*
+ * Spatial covariance of one tag, R[m][n] = E{x[m] * conj(x[n])} over its
+ * recent snapshots, each normalized to unit energy first. The window mode
+ * keeps the sum rather than the mean; consumers only rely on relative
+ * values.
+ */
+struct cov {
+    struct cplx r[COV_ENTRIES];
+    uint32_t freq_mhz;          // Mean carrier frequency of the snapshots
+    uint16_t count;             // Snapshots since the last reset
+};
+
+static inline int cov_index(int m, int n)
+{
+    return m * AOA_ANT_COUNT - m * (m - 1) / 2 + (n - m);
+}
+
+/** @brief Element R[m][n] of any triangle. */
+static inline struct cplx cov_at(const struct cov *cov, int m, int n)
+{
+    if (m <= n) {
+        return cov->r[cov_index(m, n)];
+    }
+    const struct cplx c = cov->r[cov_index(n, m)];
+    return (struct cplx){ c.re, -c.im };
+}
+
+#if defined(CONFIG_AOA_RX_MATH_FLOAT) && defined(CONFIG_AOA_RX_COV_WINDOW)
+// Float adds and subtracts do not cancel exactly; rebuild from the window now and then
+#define COV_REBUILD_INTERVAL 1024
+#endif
+
+/* Covariance of one tag with what its update needs; see covariance.c */
+struct cov_state {
+    struct cov cov;
+    bool valid;
+    uint8_t source;
+    uint16_t event_counter;
+    uint16_t step;              // See event_gap()
+#if defined(CONFIG_AOA_RX_COV_WINDOW)
+    struct cplx window[CONFIG_AOA_RX_COV_SNAPSHOTS][AOA_ANT_COUNT];
+    uint16_t window_freq[CONFIG_AOA_RX_COV_SNAPSHOTS];
+    uint8_t head;               // Next slot to write, the oldest once the window is full
+    uint32_t freq_sum;
+#else
+    uint32_t freq_q8;           // Mean frequency in 1/256 MHz
+#endif
+#if defined(COV_REBUILD_INTERVAL)
+    uint16_t since_rebuild;
+#endif
+};
+#endif /* CONFIG_AOA_RX_COVARIANCE */
+
+#if !defined(CONFIG_AOA_RX_TRACK_NONE)
+/* Filtered angles of one tag; see track.c */
+struct track {
+    bool valid;
+    uint8_t source;
+    uint16_t event_counter;
+    uint16_t step;              // See event_gap()
+    float azimuth;
+    float elevation;
+#if defined(CONFIG_AOA_RX_TRACK_ALPHA_BETA)
+    float azimuth_rate;         // Degrees per event
+    float elevation_rate;
+#endif
+};
+#endif
+
+/*
+ * Per-tag state of one locator, indexed by tag id. The firmware keeps one;
+ * a server estimating for several locators keeps one per locator and lets
+ * only one thread at a time use each.
+ */
+struct aoa_state {
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+    struct cov_state cov[CONFIG_AOA_RX_MAX_TAGS];
+#endif
+#if !defined(CONFIG_AOA_RX_TRACK_NONE)
+    struct track track[CONFIG_AOA_RX_MAX_TAGS];
+#endif
+    uint8_t generation[CONFIG_AOA_RX_MAX_TAGS];  // Of the tag the state of each id belongs to
+    const struct aoa_calib *calib;  // Applied to every snapshot; NULL for none
+    uint32_t reports;           // Reports estimated
+};
+
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+/**
+ * @brief Fold a snapshot into the covariance of the report's tag.
+ *
+ * A rank-1 update, O(N^2) per report. Restarts the tag's covariance after
+ * a gap in its events or when the tag id was reused.
+ *
+ * @param cov Receives the updated covariance.
+ */
+int cov_update(struct aoa_state *state, const struct aoa_iq_report *report,
+               const struct cplx x[AOA_ANT_COUNT], const struct cov **cov);
+#endif /* CONFIG_AOA_RX_COVARIANCE */
+
+/** @brief RF centre frequency of a BLE channel index in MHz. */
+uint32_t chan_freq_mhz(uint8_t chan_idx);
+
+/**
+ * @brief Collapse the switched samples into one phasor per element.
+ *
+ * The carrier offset is measured over the reference period, refined over
+ * the switched period and removed from every switched sample, so phasors
+ * taken at different times can be summed.
+ *
+ * @return 0, or -EINVAL if the report does not sample every element or
+ *         was sampled with other slot durations than configured.
+ */
+int snapshot_build(const struct aoa_iq_report *report, struct cplx x[AOA_ANT_COUNT]);
+
+/** @brief Multiply each element's phasor by its calibration weight for @p chan_idx. */
+void calib_apply(const struct aoa_calib *calib, uint8_t chan_idx, struct cplx x[AOA_ANT_COUNT]);
+
+/**
+ * @brief Phase-difference estimate of azimuth, elevation and quality.
+ *
+ * Always built: besides being one of the configured estimators it is the
+ * fallback for reports the quality gate downgrades.
+ */
+int estimate_phase_diff(const struct cplx x[AOA_ANT_COUNT], uint8_t chan_idx,
+                        struct aoa_angle_result *result);
+
+#if defined(CONFIG_AOA_RX_EST_PHASE_DIFF)
+static inline int estimate_angle(const struct cplx x[AOA_ANT_COUNT], uint8_t chan_idx,
+                                 struct aoa_angle_result *result)
+{
+    return estimate_phase_diff(x, chan_idx, result);
+}
+#elif defined(CONFIG_AOA_RX_COVARIANCE)
+/** @brief Fill azimuth, elevation and quality of @p result from a tag's covariance. */
+int estimate_angle(const struct cov *cov, struct aoa_angle_result *result);
+#else
+/** @brief Fill azimuth, elevation and quality of @p result from a snapshot. */
+int estimate_angle(const struct cplx x[AOA_ANT_COUNT], uint8_t chan_idx,
+                   struct aoa_angle_result *result);
+#endif
+
+#if defined(CONFIG_AOA_RX_TRACK_NONE)
+static inline void track_update(struct aoa_state *state, struct aoa_angle_result *result)
+{
+    ARG_UNUSED(state);
+    ARG_UNUSED(result);
+}
+#else
+/** @brief Replace the raw angles in @p result with the filtered angles of its tag. */
+void track_update(struct aoa_state *state, struct aoa_angle_result *result);
+#endif
+
+/**
+ * @brief Run one report through snapshot, estimator and tracking filter.
+ *
+ * The whole configured pipeline, as the DSP thread runs it after the
+ * quality gate. Fills every field of @p result.
+ *
+ * @param state Per-tag state of the locator the report came from.
+ *
+ * @param downgrade Estimate with the phase-difference fallback instead of
+ *                  the configured estimator, leaving the covariance alone.
+ *
+ * @return 0, or a negative errno from the stage that rejected the report.
+ */
+int aoa_process(struct aoa_state *state, const struct aoa_iq_report *report, bool downgrade,
+                struct aoa_angle_result *result);
+
+#endif /* AOA_CORE_DSP_H_ */
@@ -0,0 +1,61 @@
+#ifndef AOA_CORE_FRAME_H_
+#define AOA_CORE_FRAME_H_
+
+#include <stdint.h>
+
+#include "aoa/port.h"
+#include "aoa/record.h"
+
+/*
+ * Framing for records sent over a byte stream that can lose or corrupt
+ * bytes, such as a UART. A frame is a stream header or one record with a
+ * CRC-16/CCITT appended, COBS encoded so it contains no zero byte, and
+ * terminated by a zero. A receiver that starts mid-stream or hits a bad
+ * byte loses at most the frame it is in.
+ */
+
+/* Largest payload, an IQ record with every sample or a full history batch */
+#define AOA_FRAME_PAYLOAD_MAX MAX(AOA_RECORD_IQ_SIZE_MAX, AOA_RECORD_HISTORY_SIZE_MAX)
+
+/* Encoded size of a payload: the CRC, a COBS code byte per 254 bytes and the delimiter */
+#define AOA_FRAME_SIZE(len) ((len) + 2 + ((len) + 2) / 254 + 2)
+#define AOA_FRAME_SIZE_MAX AOA_FRAME_SIZE(AOA_FRAME_PAYLOAD_MAX)
+
+struct aoa_frame_decoder {
+    uint8_t buf[AOA_FRAME_SIZE_MAX];
+    size_t len;
+    bool overflow;              // Frame too long; skipping to the next delimiter
+};
+
+/** @brief CRC-16/CCITT-FALSE of @p len bytes. */
+uint16_t aoa_crc16(const uint8_t *data, size_t len);
+
+/**
+ * @brief Frame a payload.
+ *
+ * @return Bytes written, at most AOA_FRAME_SIZE(len), or -ENOSPC.
+ */
+int aoa_frame_encode(const uint8_t *payload, size_t len, uint8_t *buf, size_t size);
+
+static inline void aoa_frame_decoder_init(struct aoa_frame_decoder *dec)
+{
+    dec->len = 0;
+    dec->overflow = false;
+}
+
+/**
+ * @brief Feed received bytes, stopping after the first complete frame.
+ *
+ * @param consumed Receives how many bytes of @p data were used. Call again
+ *                 with the rest until it is all consumed.
+ * @param payload  Receives the payload of a complete frame. It stays valid
+ *                 until the next call.
+ *
+ * @return Payload length of a complete frame, 0 if @p data ran out first,
+ *         or -EBADMSG for a frame that was corrupt or too long and was
+ *         dropped.
+ */
+int aoa_frame_decode(struct aoa_frame_decoder *dec, const uint8_t *data, size_t len,
+                     size_t *consumed, const uint8_t **payload);
+
+#endif /* AOA_CORE_FRAME_H_ */
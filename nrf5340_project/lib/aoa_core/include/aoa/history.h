@@ -0,0 +1,115 @@
+#ifndef AOA_CORE_HISTORY_H_
+#define AOA_CORE_HISTORY_H_
+
+#include <stdint.h>
+
+#include "aoa/port.h"
+
+/*
+ * Compact angle history, as a locator logs it to flash while its uplink
+ * is down and sends it back once asked. Angles are kept in batches that
+ * decode on their own, so the oldest can be erased without breaking the
+ * rest. A batch header holds the boot the batch was logged in and the
+ * uptime of its first entry. Each entry then holds, as varints:
+ *
+ * - the tag id,
+ * - the milliseconds since the entry before it,
+ * - azimuth and elevation in tenths of a degree, zigzag coded as the
+ *   change from the tag's previous entry in the batch (from zero for the
+ *   tag's first one), and
+ * - the quality in 1/255 as one byte.
+ *
+ * Elevation is left out of batches from a linear array. A tag tracked at
+ * a steady rate takes four to five bytes an entry where an angle record
+ * takes 23.
+ */
+
+#define AOA_HISTORY_VERSION 1
+#define AOA_HISTORY_HEADER_SIZE 8
+
+/* Largest batch, so that one travels in a single record and frame */
+#define AOA_HISTORY_BATCH_MAX 512
+
+/* Tag ids the delta state covers; the locator's tag pool is no larger */
+#define AOA_HISTORY_TAGS_MAX 32
+
+/* An entry at most: tag 1, time 5, azimuth 3, elevation 3 and quality 1 */
+#define AOA_HISTORY_ENTRY_SIZE_MAX 13
+
+/* Batch header flags */
+#define AOA_HISTORY_ELEVATION 0x01
+
+/*
+ * Byte a reader sends on the history link to have the log sent. The
+ * read-out is a stream header, the batches as history records oldest
+ * first, and a batch without entries to end it, each in a frame.
+ */
+#define AOA_HISTORY_READOUT_REQUEST 'R'
+
+struct aoa_history_entry {
+    uint32_t time_ms;         // Uptime when the angle was logged
+    uint16_t boot;            // Boot it was logged in, from the batch header
+    uint8_t tag_id;
+    float azimuth;            // Degrees, to a tenth
+    float elevation;
+    float quality;            // 0..1, to 1/255
+};
+
+struct aoa_history_encoder {
+    uint8_t *buf;
+    size_t size;
+    size_t len;               // Header included
+    uint32_t time_ms;         // Of the last entry
+    uint32_t tags;            // Bit per tag id with an entry in the batch
+    int16_t azimuth[AOA_HISTORY_TAGS_MAX];
+    int16_t elevation[AOA_HISTORY_TAGS_MAX];
+    uint16_t count;
+    uint16_t boot;
+    uint8_t flags;
+};
+
+struct aoa_history_decoder {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint32_t time_ms;
+    uint32_t tags;
+    int16_t azimuth[AOA_HISTORY_TAGS_MAX];
+    int16_t elevation[AOA_HISTORY_TAGS_MAX];
+    uint16_t boot;
+    uint8_t flags;
+};
+
+/**
+ * @brief Start an empty batch in @p buf, writing its header.
+ *
+ * @param size  At least AOA_HISTORY_HEADER_SIZE.
+ * @param flags AOA_HISTORY_ELEVATION to keep elevations.
+ */
+void aoa_history_encoder_init(struct aoa_history_encoder *enc, uint8_t *buf, size_t size,
+                              uint16_t boot, uint8_t flags);
+
+/**
+ * @brief Add an entry to the batch. Its boot is the batch's.
+ *
+ * @return 0, -ENOSPC if the batch is full and left as it was, -EINVAL
+ *         for a tag id from AOA_HISTORY_TAGS_MAX up, or -ERANGE for a time
+ *         before the previous entry's.
+ */
+int aoa_history_append(struct aoa_history_encoder *enc, const struct aoa_history_entry *entry);
+
+/**
+ * @brief Start decoding the batch in @p buf.
+ *
+ * @return 0, or -EBADMSG if it is too short or of a newer version.
+ */
+int aoa_history_decoder_init(struct aoa_history_decoder *dec, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Decode the next entry.
+ *
+ * @return 1 with the entry in @p entry, 0 at the end of the batch, or
+ *         -EBADMSG if the batch is malformed.
+ */
+int aoa_history_next(struct aoa_history_decoder *dec, struct aoa_history_entry *entry);
+
+#endif /* AOA_CORE_HISTORY_H_ */
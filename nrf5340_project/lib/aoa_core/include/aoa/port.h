@@ -0,0 +1,40 @@
+#ifndef AOA_CORE_PORT_H_
+#define AOA_CORE_PORT_H_
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The few Zephyr utilities the core uses. Under Zephyr they come from the
+ * kernel headers; host builds get equivalents here, so the sources read
+ * the same in both.
+ */
+#if defined(__ZEPHYR__)
+
+#include <zephyr/toolchain.h>
+#include <zephyr/sys/util.h>
+
+/* Only the DSP thread estimates */
+#define AOA_SCRATCH static
+
+#else
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+#define CLAMP(val, low, high) (((val) <= (low)) ? (low) : MIN(val, high))
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+#define ARG_UNUSED(x) (void)(x)
+#define BUILD_ASSERT(expr, msg) _Static_assert(expr, msg)
+
+/* Estimator work buffers too large for a stack; host tools estimate on several threads */
+#define AOA_SCRATCH static _Thread_local
+
+#endif /* __ZEPHYR__ */
+
+#endif /* AOA_CORE_PORT_H_ */
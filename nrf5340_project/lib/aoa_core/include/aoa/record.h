@@ -0,0 +1,107 @@
+#ifndef AOA_CORE_RECORD_H_
+#define AOA_CORE_RECORD_H_
+
+#include <stdint.h>
+
+#include "aoa/history.h"
+#include "aoa/port.h"
+#include "aoa/report.h"
+
+/*
+ * Serialized reports, the interchange format between locators and host
+ * tools. A stream starts with a header describing the array the IQ
+ * samples were taken with, followed by records. Every field is little
+ * endian and every record carries its length, so readers skip record
+ * types they do not know.
+ */
+
+#define AOA_RECORD_MAGIC 0x52414f41 // "AOAR"
+#define AOA_RECORD_VERSION 1
+
+#define AOA_RECORD_HEADER_SIZE 12
+
+/* Length and type prefix of every record */
+#define AOA_RECORD_PREFIX_SIZE 3
+
+/* An IQ record without samples, and with the most a report can hold */
+#define AOA_RECORD_IQ_SIZE_MIN (AOA_RECORD_PREFIX_SIZE + 14)
+#define AOA_RECORD_IQ_SIZE_MAX (AOA_RECORD_IQ_SIZE_MIN + 4 * AOA_IQ_SAMPLES_MAX)
+#define AOA_RECORD_ANGLE_SIZE (AOA_RECORD_PREFIX_SIZE + 20)
+#define AOA_RECORD_HISTORY_SIZE_MAX (AOA_RECORD_PREFIX_SIZE + AOA_HISTORY_BATCH_MAX)
+
+enum aoa_record_type {
+    AOA_RECORD_IQ = 1,
+    AOA_RECORD_ANGLE = 2,
+    AOA_RECORD_IQ_PACKED = 3, // 8-bit samples, predicted and Rice coded
+    AOA_RECORD_HISTORY = 4,   // A batch of logged angles, see aoa/history.h
+};
+
+/* A history batch, left in the buffer it was decoded from */
+struct aoa_record_history {
+    const uint8_t *batch;
+    uint16_t len;
+};
+
+struct aoa_record {
+    uint8_t type;             // enum aoa_record_type, or unknown and left unparsed
+    union {
+        struct aoa_iq_report iq;
+        struct aoa_angle_result angle;
+        struct aoa_record_history history;
+    };
+};
+
+/**
+ * @brief Write the stream header for the configured array.
+ *
+ * @return AOA_RECORD_HEADER_SIZE, or -ENOSPC if @p size is too small.
+ */
+int aoa_record_header_encode(uint8_t *buf, size_t size);
+
+/**
+ * @brief Check a stream header against the configured array.
+ *
+ * @return AOA_RECORD_HEADER_SIZE, -EAGAIN if @p len is too short,
+ *         -EBADMSG if it is no record stream or of a newer version, or
+ *         -ENOTSUP if it was recorded with another array.
+ */
+int aoa_record_header_decode(const uint8_t *buf, size_t len);
+
+/** @return Bytes written, or -ENOSPC if @p size is too small. */
+int aoa_record_encode_iq(const struct aoa_iq_report *report, uint8_t *buf, size_t size);
+
+/**
+ * @brief Write an IQ record compactly, for links slower than the radio.
+ *
+ * Samples of 8 bits travel as bytes, or as prediction residuals from the
+ * reference period's phase step where that is shorter; lossless either
+ * way. A report with wider samples falls back to a plain IQ record, so
+ * the result never exceeds AOA_RECORD_IQ_SIZE_MAX.
+ *
+ * @return Bytes written, or -ENOSPC if @p size is too small.
+ */
+int aoa_record_encode_iq_packed(const struct aoa_iq_report *report, uint8_t *buf, size_t size);
+
+/** @return Bytes written, or -ENOSPC if @p size is too small. */
+int aoa_record_encode_angle(const struct aoa_angle_result *result, uint8_t *buf, size_t size);
+
+/**
+ * @brief Wrap a history batch of @p len bytes, at most AOA_HISTORY_BATCH_MAX.
+ *
+ * @return Bytes written, or -ENOSPC if @p size is too small.
+ */
+int aoa_record_encode_history(const uint8_t *batch, size_t len, uint8_t *buf, size_t size);
+
+/**
+ * @brief Parse the record at the start of @p buf.
+ *
+ * A packed IQ record is unpacked into @p record as AOA_RECORD_IQ. A
+ * history record points into @p buf, so it is valid as long as @p buf.
+ *
+ * @return Bytes consumed, also for a record of unknown type, -EAGAIN if
+ *         @p len does not hold the whole record yet, or -EBADMSG if the
+ *         record is malformed.
+ */
+int aoa_record_decode(const uint8_t *buf, size_t len, struct aoa_record *record);
+
+#endif /* AOA_CORE_RECORD_H_ */
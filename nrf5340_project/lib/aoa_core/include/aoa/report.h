@@ -0,0 +1,54 @@
+#ifndef AOA_CORE_REPORT_H_
+#define AOA_CORE_REPORT_H_
+
+#include <stdint.h>
+
+#include "aoa/array.h"
+
+/*
+ * Normalized samples in the longest configured CTE: 8 from the reference
+ * period plus one per switch/sample slot pair after the 4 us guard and
+ * 8 us reference period. 82 for a 160 us CTE with 1 us slots, 45 with
+ * 2 us slots. Oversampled slots are averaged down to one sample on copy.
+ */
+#define AOA_IQ_SAMPLES_MAX \
+    (AOA_REF_SAMPLES + (CONFIG_AOA_RX_CTE_LEN * 8 - 12) / AOA_SAMPLE_SPACING_US)
+
+enum aoa_iq_source {
+    AOA_IQ_SOURCE_PER_ADV,
+    AOA_IQ_SOURCE_CONN,
+};
+
+struct aoa_iq_sample {
+    int16_t i;
+    int16_t q;
+};
+
+/* One CTE's IQ samples, independent of the transport it arrived on */
+struct aoa_iq_report {
+    uint32_t timestamp;       // k_cycle_get_32() at reception
+    uint16_t event_counter;   // Periodic advertising or connection event counter
+    int16_t rssi;             // 0.1 dBm
+    uint8_t source;           // enum aoa_iq_source
+    uint8_t tag_id;           // Index in the tag pool
+    uint8_t chan_idx;
+    uint8_t slot_durations;
+    uint8_t packet_status;
+    uint8_t sample_count;
+    uint8_t priority;         // Scheduling class on the locator, not part of records
+    uint8_t generation;       // Changes when the locator reuses tag_id, not part of records
+    struct aoa_iq_sample samples[AOA_IQ_SAMPLES_MAX];
+};
+
+/* Angle estimate for one report, produced by the DSP side */
+struct aoa_angle_result {
+    uint32_t timestamp;       // Copied from the report
+    uint16_t event_counter;
+    uint8_t source;
+    uint8_t tag_id;
+    float azimuth;            // Degrees from broadside (ULA) or around the array normal (URA)
+    float elevation;          // Degrees above the array plane; 0 for a ULA
+    float quality;            // Estimator confidence, 0..1
+};
+
+#endif /* AOA_CORE_REPORT_H_ */
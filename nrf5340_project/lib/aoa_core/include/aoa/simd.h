@@ -0,0 +1,67 @@
+#ifndef AOA_CORE_SIMD_H_
+#define AOA_CORE_SIMD_H_
+
+#include "aoa/port.h"
+
+/*
+ * Vector kernels of host builds (AOA_CORE_SIMD, with the Bartlett or MUSIC
+ * estimator). The spectrum scan and the covariance update run on the
+ * kernels picked at run time: AVX2 with FMA on x86-64, NEON on AArch64,
+ * or the scalar reference the firmware runs. All threads share the pick.
+ */
+
+enum aoa_simd {
+    AOA_SIMD_SCALAR,
+    AOA_SIMD_AVX2,
+    AOA_SIMD_NEON,
+};
+
+/** @brief Kernels in use: unless set, the best the build and CPU support. */
+enum aoa_simd aoa_simd_get(void);
+
+/**
+ * @brief Use other kernels, e.g. the scalar reference to compare with.
+ *
+ * Only call it while no thread estimates.
+ *
+ * @return 0, or -ENOTSUP if the build or the CPU lacks them.
+ */
+int aoa_simd_set(enum aoa_simd simd);
+
+/** @brief Name of @p simd, such as "avx2". */
+const char *aoa_simd_name(enum aoa_simd simd);
+
+/**
+ * @brief Run kernels and the scalar reference on the same random input.
+ *
+ * @param error Receives the largest difference between the two, relative
+ *              to the largest output of the reference.
+ *
+ * @return 0, or -ENOTSUP if the build or the CPU lacks @p simd.
+ */
+int aoa_simd_check(enum aoa_simd simd, float *error);
+
+/*
+ * Packed Q15 kernels of the fixed-point paths: the phase-difference
+ * estimator, the snapshot and the IQ packer. Every build has them; they
+ * use the DSP extension on Armv8-M cores that have it.
+ */
+
+struct aoa_q15_timing {
+    uint64_t kernels;           // Ticks of the clock given, over the whole run
+    uint64_t reference;
+    bool dsp;                   // The kernels use DSP extension instructions
+};
+
+/**
+ * @brief Run the Q15 kernels and plain C references on the same input.
+ *
+ * The input is pseudo-random and covers the full 16-bit range.
+ *
+ * @param now Clock to time both with, or NULL.
+ *
+ * @return 0 if every result matches bit for bit, else -EDOM.
+ */
+int aoa_q15_check(uint64_t (*now)(void), struct aoa_q15_timing *timing);
+
+#endif /* AOA_CORE_SIMD_H_ */
@@ -0,0 +1,439 @@
+#include <math.h>
+#include <string.h>
+
+#include "kernels.h"
+
+/*
+ * Delay-and-sum steering over the directions of arrival, shared by the
+ * spectrum estimators. Steering vectors are evaluated with Horner's rule
+ * so each direction costs one complex exponential per axis instead of
+ * one per element. Directions are steered in batches through beam_power()
+ * so host builds can spread them across vector lanes; the code here is
+ * the scalar reference (see kernels.h).
+ */
+
+#define DEG_TO_RAD ((float)M_PI / 180.0f)
+
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+
+/*
+ * With a covariance R the output power is a^H R a, the sum over lags of
+ * d[l][k] * wx^k * wy^l, where d[l][k] sums R[m][n] over the element pairs
+ * l rows and k columns apart. Summing the diagonals once per report leaves
+ * one lag polynomial per grid point, about the cost of steering a single
+ * snapshot. Lags with l < 0 are the conjugates of those with l > 0 and
+ * are folded in by taking twice the real part.
+ */
+
+void beam_input_init(struct beam_input *in, const struct cov *cov)
+{
+    memset(in, 0, sizeof(*in));
+
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        for (int n = 0; n < AOA_ANT_COUNT; n++) {
+            const int l = m / AOA_ANT_COLS - n / AOA_ANT_COLS;
+            const int k = m % AOA_ANT_COLS - n % AOA_ANT_COLS;
+
+            if (l < 0 || (l == 0 && k < 0)) {
+                continue;
+            }
+            const struct cplx r = cov_at(cov, m, n);
+            in->d[l][k + AOA_ANT_COLS - 1].re += r.re;
+            in->d[l][k + AOA_ANT_COLS - 1].im += r.im;
+        }
+    }
+}
+
+// sum over j of c[j] * w^j for @p count coefficients
+static inline struct cplx poly_eval(const struct cplx *c, int count, struct cplx w)
+{
+    struct cplx acc = c[count - 1];
+
+    for (int j = count - 2; j >= 0; j--) {
+        const float re = acc.re * w.re - acc.im * w.im + c[j].re;
+        const float im = acc.re * w.im + acc.im * w.re + c[j].im;
+        acc.re = re;
+        acc.im = im;
+    }
+    return acc;
+}
+
+// a * b for complex values
+static inline struct cplx cmul(struct cplx a, struct cplx b)
+{
+    return (struct cplx){ a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+}
+
+static float steer_power(const struct beam_input *in, float psi_x, float psi_y)
+{
+    const struct cplx wx = { cosf(psi_x), -sinf(psi_x) };
+
+    // Row lag 0: positive column lags; the zero lag is added at the end
+    struct cplx acc = cmul(poly_eval(&in->d[0][AOA_ANT_COLS], AOA_ANT_COLS - 1, wx), wx);
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    // Column lags start at -(cols - 1), so each row polynomial is off by wx^-(cols - 1)
+    const float shift = (AOA_ANT_COLS - 1) * psi_x;
+    const struct cplx wx_shift = { cosf(shift), sinf(shift) };
+    const struct cplx wy = { cosf(psi_y), -sinf(psi_y) };
+    struct cplx rows = { 0.0f, 0.0f };
+
+    AOA_UNROLL
+    for (int l = AOA_ANT_ROWS - 1; l >= 1; l--) {
+        const struct cplx q = cmul(poly_eval(in->d[l], BEAM_LAG_COLS, wx), wx_shift);
+
+        rows.re += q.re;
+        rows.im += q.im;
+        rows = cmul(rows, wy);
+    }
+    acc.re += rows.re;
+#else
+    ARG_UNUSED(psi_y);
+#endif
+    return in->d[0][AOA_ANT_COLS - 1].re + 2.0f * acc.re;
+}
+
+#else
+
+void beam_input_init(struct beam_input *in, const struct cplx x[AOA_ANT_COUNT])
+{
+    in->x = x;
+}
+
+// sum over m of x[m] * w^m for one row of elements starting at @p row
+static inline struct cplx row_steer(const struct cplx *row, struct cplx w)
+{
+    struct cplx acc = row[AOA_ANT_COLS - 1];
+
+    AOA_UNROLL
+    for (int m = AOA_ANT_COLS - 2; m >= 0; m--) {
+        const float re = acc.re * w.re - acc.im * w.im + row[m].re;
+        const float im = acc.re * w.im + acc.im * w.re + row[m].im;
+        acc.re = re;
+        acc.im = im;
+    }
+    return acc;
+}
+
+// Output power when the phase step is psi_x along a row and psi_y between rows
+static float steer_power(const struct beam_input *in, float psi_x, float psi_y)
+{
+    const struct cplx *x = in->x;
+    const struct cplx wx = { cosf(psi_x), -sinf(psi_x) };
+    struct cplx acc = row_steer(&x[(AOA_ANT_ROWS - 1) * AOA_ANT_COLS], wx);
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    const struct cplx wy = { cosf(psi_y), -sinf(psi_y) };
+
+    AOA_UNROLL
+    for (int r = AOA_ANT_ROWS - 2; r >= 0; r--) {
+        const struct cplx row = row_steer(&x[r * AOA_ANT_COLS], wx);
+        const float re = acc.re * wy.re - acc.im * wy.im + row.re;
+        const float im = acc.re * wy.im + acc.im * wy.re + row.im;
+        acc.re = re;
+        acc.im = im;
+    }
+#else
+    ARG_UNUSED(psi_y);
+#endif
+    return acc.re * acc.re + acc.im * acc.im;
+}
+
+#endif /* CONFIG_AOA_RX_COVARIANCE */
+
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+
+// Phase steps along a row and between rows, from the lag-one sums
+static void lag_one(const struct beam_input *in, struct cplx *cx, struct cplx *cy)
+{
+    *cx = in->d[0][AOA_ANT_COLS];
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    *cy = in->d[1][AOA_ANT_COLS - 1];
+#else
+    *cy = (struct cplx){ 0.0f, 0.0f };
+#endif
+}
+
+#else
+
+static void lag_one(const struct beam_input *in, struct cplx *cx, struct cplx *cy)
+{
+    const struct cplx *x = in->x;
+
+    *cx = (struct cplx){ 0.0f, 0.0f };
+    *cy = (struct cplx){ 0.0f, 0.0f };
+    AOA_UNROLL
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        if (m % AOA_ANT_COLS != AOA_ANT_COLS - 1) {
+            cx->re += x[m + 1].re * x[m].re + x[m + 1].im * x[m].im;
+            cx->im += x[m + 1].im * x[m].re - x[m + 1].re * x[m].im;
+        }
+        if (m + AOA_ANT_COLS < AOA_ANT_COUNT) {
+            cy->re += x[m + AOA_ANT_COLS].re * x[m].re + x[m + AOA_ANT_COLS].im * x[m].im;
+            cy->im += x[m + AOA_ANT_COLS].im * x[m].re - x[m + AOA_ANT_COLS].re * x[m].im;
+        }
+    }
+}
+
+#endif /* CONFIG_AOA_RX_COVARIANCE */
+
+/*
+ * Coarse-to-fine search: steer over a CONFIG_AOA_RX_SCAN_COARSE_DEG grid,
+ * take its strongest local maxima plus the phase-difference direction as
+ * candidates, and refine each by halving the step around it down to
+ * CONFIG_AOA_RX_SCAN_STEP_DEG, with a parabolic fit per axis at the end.
+ * On a URA with the defaults that is about 500 steering evaluations per
+ * report instead of 33000 for a full 1 degree grid.
+ */
+
+#define COARSE CONFIG_AOA_RX_SCAN_COARSE_DEG
+#define FINE CONFIG_AOA_RX_SCAN_STEP_DEG
+
+BUILD_ASSERT(90 % COARSE == 0, "The coarse grid step must divide 90 degrees");
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+#define AZ_FIRST -180
+#define AZ_CELLS (360 / COARSE) // Wraps around
+#define EL_CELLS (90 / COARSE + 1)
+#define EL_REACH 1
+#else
+#define AZ_FIRST -90
+#define AZ_CELLS (180 / COARSE + 1)
+#define EL_CELLS 1
+#define EL_REACH 0 // Elevation is not scanned
+#endif
+
+// Coarse grid power, and the directions of one grid row
+AOA_SCRATCH float grid[EL_CELLS][AZ_CELLS];
+AOA_SCRATCH float grid_az[AZ_CELLS];
+AOA_SCRATCH float grid_el[AZ_CELLS];
+
+static float power_at(const struct beam_input *in, float k, float az, float el)
+{
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    const float r = k * cosf(el * DEG_TO_RAD);
+    return steer_power(in, r * cosf(az * DEG_TO_RAD), r * sinf(az * DEG_TO_RAD));
+#else
+    ARG_UNUSED(el);
+    return steer_power(in, k * sinf(az * DEG_TO_RAD), 0.0f);
+#endif
+}
+
+void beam_power_scalar(const struct beam_input *in, float k, const float *az, const float *el,
+                       float *power, int count)
+{
+    for (int i = 0; i < count; i++) {
+        power[i] = power_at(in, k, az[i], el[i]);
+    }
+}
+
+// Azimuth wraps on a URA; everything else stops at the edge of the scanned range
+static void direction_norm(float *az, float *el)
+{
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    if (*az >= 180.0f) {
+        *az -= 360.0f;
+    } else if (*az < -180.0f) {
+        *az += 360.0f;
+    }
+    *el = CLAMP(*el, 0.0f, 90.0f);
+#else
+    ARG_UNUSED(el);
+    *az = CLAMP(*az, -90.0f, 90.0f);
+#endif
+}
+
+static float azimuth_dist(float a, float b)
+{
+    float d = fabsf(a - b);
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    d = MIN(d, 360.0f - d);
+#endif
+    return d;
+}
+
+static bool grid_peak(int e, int a)
+{
+    const float p = grid[e][a];
+
+    for (int de = -EL_REACH; de <= EL_REACH; de++) {
+        if (e + de < 0 || e + de >= EL_CELLS) {
+            continue;
+        }
+        for (int da = -1; da <= 1; da++) {
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+            const int na = (a + da + AZ_CELLS) % AZ_CELLS;
+#else
+            const int na = a + da;
+            if (na < 0 || na >= AZ_CELLS) {
+                continue;
+            }
+#endif
+            if (grid[e + de][na] > p) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Insert into @p peaks, strongest first, dropping the weakest when full
+static void peak_insert(struct beam_peak *peaks, int *count, int max, struct beam_peak peak)
+{
+    int i;
+
+    if (*count == max) {
+        if (peak.power <= peaks[max - 1].power) {
+            return;
+        }
+        i = max - 1;
+    } else {
+        i = (*count)++;
+    }
+    for (; i > 0 && peaks[i - 1].power < peak.power; i--) {
+        peaks[i] = peaks[i - 1];
+    }
+    peaks[i] = peak;
+}
+
+// Offset of the vertex of the parabola through (-h, pm), (0, p0), (h, pp)
+static float parabola_vertex(float pm, float p0, float pp, float h)
+{
+    const float curvature = pm - 2.0f * p0 + pp;
+    if (curvature >= 0.0f) {
+        return 0.0f;
+    }
+    return CLAMP(h * (pm - pp) / (2.0f * curvature), -h / 2.0f, h / 2.0f);
+}
+
+// Neighbours of a point at step h: left and right, and diagonally on a URA
+#define RING (EL_REACH ? 8 : 2)
+
+/*
+ * Power at offsets from @p peak, in the units of @p h, and the directions
+ * they land on.
+ */
+static void offsets_power(const struct beam_input *in, float k, const struct beam_peak *peak,
+                          const int8_t (*d)[2], int count, float h, struct beam_peak *out)
+{
+    float az[RING];
+    float el[RING];
+    float power[RING];
+
+    for (int i = 0; i < count; i++) {
+        az[i] = peak->azimuth + d[i][0] * h;
+        el[i] = peak->elevation + d[i][1] * h;
+        direction_norm(&az[i], &el[i]);
+    }
+    beam_power(in, k, az, el, power, count);
+    for (int i = 0; i < count; i++) {
+        out[i] = (struct beam_peak){ az[i], el[i], power[i] };
+    }
+}
+
+static void refine(const struct beam_input *in, float k, struct beam_peak *peak)
+{
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    static const int8_t ring[RING][2] = {
+        { -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 },
+    };
+    static const int8_t axes[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+#else
+    static const int8_t ring[RING][2] = { { -1, 0 }, { 1, 0 } };
+    static const int8_t (*const axes)[2] = ring;
+#endif
+    struct beam_peak p[RING];
+    float h = COARSE / 2.0f;
+
+    for (; h >= FINE; h /= 2.0f) {
+        struct beam_peak best = *peak;
+
+        offsets_power(in, k, peak, ring, RING, h, p);
+        for (int i = 0; i < RING; i++) {
+            if (p[i].power > best.power) {
+                best = p[i];
+            }
+        }
+        *peak = best;
+    }
+
+    // Between grid points: one parabola per axis through the next finer step
+    float az = peak->azimuth;
+    float el = peak->elevation;
+
+    offsets_power(in, k, peak, axes, 2 + 2 * EL_REACH, h, p);
+    az += parabola_vertex(p[0].power, peak->power, p[1].power, h);
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    el += parabola_vertex(p[2].power, peak->power, p[3].power, h);
+#endif
+    direction_norm(&az, &el);
+    peak->azimuth = az;
+    peak->elevation = el;
+    beam_power(in, k, &peak->azimuth, &peak->elevation, &peak->power, 1);
+}
+
+int beam_scan(const struct beam_input *in, uint32_t freq_mhz, struct beam_peak peaks[BEAM_PEAKS])
+{
+    // Phase step per element for a direction cosine of 1
+    const float k = 2.0f * (float)M_PI * AOA_ANT_SPACING_M * freq_mhz * 1e6f / SPEED_OF_LIGHT;
+    struct beam_peak candidates[BEAM_PEAKS + 1];
+    int count = 0;
+
+    for (int e = 0; e < EL_CELLS; e++) {
+        for (int a = 0; a < AZ_CELLS; a++) {
+            grid_az[a] = AZ_FIRST + a * COARSE;
+            grid_el[a] = e * COARSE;
+        }
+        beam_power(in, k, grid_az, grid_el, grid[e], AZ_CELLS);
+    }
+    for (int e = 0; e < EL_CELLS; e++) {
+        // Every azimuth of the zenith row is the same direction
+        const int az_cells = e * COARSE == 90 ? 1 : AZ_CELLS;
+
+        for (int a = 0; a < az_cells; a++) {
+            if (grid_peak(e, a)) {
+                const struct beam_peak peak = { AZ_FIRST + a * COARSE, e * COARSE, grid[e][a] };
+                peak_insert(candidates, &count, BEAM_PEAKS, peak);
+            }
+        }
+    }
+
+    // The phase-difference direction, in case the true peak fell between grid points
+    struct cplx cx, cy;
+    lag_one(in, &cx, &cy);
+    const float u = CLAMP(atan2f(cx.im, cx.re) / k, -1.0f, 1.0f);
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    const float v = CLAMP(atan2f(cy.im, cy.re) / k, -1.0f, 1.0f);
+    float seed_az = atan2f(v, u) / DEG_TO_RAD;
+    float seed_el = acosf(fminf(hypotf(u, v), 1.0f)) / DEG_TO_RAD;
+#else
+    float seed_az = asinf(u) / DEG_TO_RAD;
+    float seed_el = 0.0f;
+#endif
+    direction_norm(&seed_az, &seed_el);
+
+    struct beam_peak *seed = &candidates[count++];
+    *seed = (struct beam_peak){ seed_az, seed_el, 0.0f };
+    beam_power(in, k, &seed->azimuth, &seed->elevation, &seed->power, 1);
+
+    for (int i = 0; i < count; i++) {
+        refine(in, k, &candidates[i]);
+    }
+
+    // Strongest first; candidates that converged on the same peak count once
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        bool duplicate = false;
+
+        for (int j = 0; j < found; j++) {
+            if (azimuth_dist(peaks[j].azimuth, candidates[i].azimuth) <= 2 * FINE &&
+                fabsf(peaks[j].elevation - candidates[i].elevation) <= 2 * FINE) {
+                duplicate = true;
+            }
+        }
+        if (!duplicate) {
+            peak_insert(peaks, &found, BEAM_PEAKS, candidates[i]);
+        }
+    }
+    return found;
+}
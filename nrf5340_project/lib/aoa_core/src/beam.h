@@ -0,0 +1,53 @@
+#ifndef AOA_CORE_BEAM_H_
+#define AOA_CORE_BEAM_H_
+
+#include <stdint.h>
+
+#include "aoa/dsp.h"
+
+/*
+ * Beam scan shared by the spectrum estimators: the directions with the
+ * most steered output power a^H R a, from a tag's covariance or, without
+ * CONFIG_AOA_RX_COVARIANCE, |a^H x|^2 from a single snapshot.
+ */
+
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+#define BEAM_LAG_COLS (2 * AOA_ANT_COLS - 1)
+
+/* Sums of R[m][n] over element pairs l rows and k columns apart */
+struct beam_input {
+    struct cplx d[AOA_ANT_ROWS][BEAM_LAG_COLS]; // d[l][k + AOA_ANT_COLS - 1]
+};
+
+/** @brief Prepare to steer @p cov, or any other Hermitian matrix in the same layout. */
+void beam_input_init(struct beam_input *in, const struct cov *cov);
+#else
+struct beam_input {
+    const struct cplx *x;
+};
+
+void beam_input_init(struct beam_input *in, const struct cplx x[AOA_ANT_COUNT]);
+#endif
+
+#define BEAM_PEAKS CONFIG_AOA_RX_SCAN_PEAKS
+
+struct beam_peak {
+    float azimuth;              // Degrees, as in struct aoa_angle_result
+    float elevation;
+    float power;
+};
+
+/**
+ * @brief Find the directions with the most output power.
+ *
+ * Several peaks can come from reflections, which a coarse grid may also
+ * rank wrongly; each is refined before they are compared.
+ *
+ * @param freq_mhz Carrier frequency the input was received at.
+ * @param peaks Receives up to BEAM_PEAKS distinct peaks, strongest first.
+ *
+ * @return Number of peaks found, at least 1.
+ */
+int beam_scan(const struct beam_input *in, uint32_t freq_mhz, struct beam_peak peaks[BEAM_PEAKS]);
+
+#endif /* AOA_CORE_BEAM_H_ */
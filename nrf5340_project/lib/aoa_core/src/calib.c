@@ -0,0 +1,140 @@
+#include <math.h>
+#include <string.h>
+
+#include "aoa/calib.h"
+#include "aoa/dsp.h"
+
+#define DEG_TO_RAD ((float)M_PI / 180.0f)
+
+// Largest weight part that still rounds into Q14
+#define WEIGHT_MAX (32767.0f / AOA_CALIB_ONE)
+
+void aoa_calib_reset(struct aoa_calib *calib)
+{
+    for (int c = 0; c < AOA_CALIB_CHANNELS; c++) {
+        for (int m = 0; m < AOA_ANT_COUNT; m++) {
+            calib->w[c][m] = (struct aoa_iq_sample){ AOA_CALIB_ONE, 0 };
+        }
+    }
+    calib->channels = 0;
+}
+
+// One complex multiply per element, in the arithmetic of the snapshot
+void calib_apply(const struct aoa_calib *calib, uint8_t chan_idx, struct cplx x[AOA_ANT_COUNT])
+{
+    if (chan_idx >= AOA_CALIB_CHANNELS) {
+        return;
+    }
+    const struct aoa_iq_sample *w = calib->w[chan_idx];
+
+    AOA_UNROLL
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+#if defined(CONFIG_AOA_RX_MATH_FIXED)
+        const int64_t re = (int64_t)x[m].re * w[m].i - (int64_t)x[m].im * w[m].q;
+        const int64_t im = (int64_t)x[m].re * w[m].q + (int64_t)x[m].im * w[m].i;
+        x[m].re = (int32_t)(re / AOA_CALIB_ONE);
+        x[m].im = (int32_t)(im / AOA_CALIB_ONE);
+#else
+        const float wr = w[m].i * (1.0f / AOA_CALIB_ONE);
+        const float wi = w[m].q * (1.0f / AOA_CALIB_ONE);
+        const float re = x[m].re * wr - x[m].im * wi;
+        x[m].im = x[m].re * wi + x[m].im * wr;
+        x[m].re = re;
+#endif
+    }
+}
+
+int aoa_calib_measure(struct aoa_calib_acc *acc, const struct aoa_iq_report *report)
+{
+    struct cplx x[AOA_ANT_COUNT];
+    int samples[AOA_ANT_COUNT] = { 0 };
+
+    if (report->chan_idx >= AOA_CALIB_CHANNELS || snapshot_build(report, x)) {
+        return -EINVAL;
+    }
+    for (int n = AOA_REF_SAMPLES; n < report->sample_count; n++) {
+        samples[aoa_sample_ant(n)]++;
+    }
+
+    // Mean phasor per sample; the snapshot sums the switched slots only, element 0's too
+    float re[AOA_ANT_COUNT];
+    float im[AOA_ANT_COUNT];
+    float energy = 0.0f;
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        if (!samples[m]) {
+            return -EINVAL;
+        }
+        re[m] = (float)x[m].re / samples[m];
+        im[m] = (float)x[m].im / samples[m];
+        energy += re[m] * re[m] + im[m] * im[m];
+    }
+    if (energy <= 0.0f) {
+        return -EINVAL;
+    }
+
+    /*
+     * Phase relative to element 0, so the carrier phase of each report
+     * drops out. What is left of the carrier offset after the snapshot
+     * turns later elements a little further in every report, which
+     * averages out of the phase but would shrink a summed magnitude, so
+     * magnitudes are summed on their own.
+     */
+    const float r0 = re[0] / energy;
+    const float i0 = im[0] / energy;
+    const float scale = 1.0f / sqrtf(energy);
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        acc->re[report->chan_idx][m] += re[m] * r0 + im[m] * i0;
+        acc->im[report->chan_idx][m] += im[m] * r0 - re[m] * i0;
+        acc->mag[report->chan_idx][m] += sqrtf(re[m] * re[m] + im[m] * im[m]) * scale;
+    }
+    acc->count[report->chan_idx]++;
+    return 0;
+}
+
+/*
+ * The sums give the array's response h[m] per sample relative to element
+ * 0, which for an ideal array would be the steering phase e[m] toward the
+ * reference. Weight w[m] = e[m] / h[m] turns one into the other; the
+ * snapshot's unequal sample counts per element stay as they were.
+ */
+int aoa_calib_solve(const struct aoa_calib_acc *acc, uint8_t chan_idx, float azimuth,
+                    float elevation, struct aoa_iq_sample w[AOA_ANT_COUNT])
+{
+    if (chan_idx >= AOA_CALIB_CHANNELS || !acc->count[chan_idx] || acc->mag[chan_idx][0] <= 0.0f) {
+        return -ENODATA;
+    }
+
+    const float k = 2.0f * (float)M_PI * AOA_ANT_SPACING_M * chan_freq_mhz(chan_idx) * 1e6f /
+                    SPEED_OF_LIGHT;
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    const float u = cosf(elevation * DEG_TO_RAD) * cosf(azimuth * DEG_TO_RAD);
+    const float v = cosf(elevation * DEG_TO_RAD) * sinf(azimuth * DEG_TO_RAD);
+#else
+    ARG_UNUSED(elevation);
+    const float u = sinf(azimuth * DEG_TO_RAD);
+    const float v = 0.0f;
+#endif
+    const float *re = acc->re[chan_idx];
+    const float *im = acc->im[chan_idx];
+    const float *mag = acc->mag[chan_idx];
+    struct aoa_iq_sample out[AOA_ANT_COUNT];
+
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        // |h| / |e| is the gain, and e / h turns by the phase difference
+        const float gain = mag[m] / mag[0];
+        const float phase = k * ((m % AOA_ANT_COLS) * u + (m / AOA_ANT_COLS) * v) -
+                            atan2f(im[m], re[m]);
+        if (gain * WEIGHT_MAX < 1.0f) {
+            return -ERANGE;
+        }
+        const float wr = cosf(phase) / gain;
+        const float wi = sinf(phase) / gain;
+        if (fabsf(wr) > WEIGHT_MAX || fabsf(wi) > WEIGHT_MAX) {
+            return -ERANGE;
+        }
+        out[m].i = (int16_t)lroundf(wr * AOA_CALIB_ONE);
+        out[m].q = (int16_t)lroundf(wi * AOA_CALIB_ONE);
+    }
+    memcpy(w, out, sizeof(out));
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include <math.h>
+#include <string.h>
+
+#include "aoa/dsp.h"
+#include "kernels.h"
+
+/*
+ * Per-tag spatial covariance, kept current with one rank-1 update per
+ * snapshot instead of being rebuilt from a history of snapshots. The
+ * exponentially weighted mode forgets old snapshots by decay; the sliding
+ * window mode keeps the last K normalized snapshots and subtracts the
+ * oldest as the newest is added. Only the upper triangle is stored.
+ * Floating point only: the estimators that need a covariance select it.
+ */
+
+#define K CONFIG_AOA_RX_COV_SNAPSHOTS
+
+static int normalize(const struct cplx x[AOA_ANT_COUNT], struct cplx y[AOA_ANT_COUNT])
+{
+    float energy = 0.0f;
+
+    AOA_UNROLL
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        energy += x[m].re * x[m].re + x[m].im * x[m].im;
+    }
+    if (energy == 0.0f) {
+        return -EINVAL;
+    }
+
+    const float scale = 1.0f / sqrtf(energy);
+
+    AOA_UNROLL
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        y[m].re = x[m].re * scale;
+        y[m].im = x[m].im * scale;
+    }
+    return 0;
+}
+
+// a * conj(b)
+static inline struct cplx outer(const struct cplx *a, const struct cplx *b)
+{
+    return (struct cplx){
+        a->re * b->re + a->im * b->im,
+        a->im * b->re - a->re * b->im,
+    };
+}
+
+void cov_rank1_scalar(struct cplx r[COV_ENTRIES], const struct cplx y[AOA_ANT_COUNT], float g,
+                      float h)
+{
+    int k = 0;
+
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        for (int n = m; n < AOA_ANT_COUNT; n++, k++) {
+            const struct cplx p = outer(&y[m], &y[n]);
+            r[k].re += g * (p.re - h * r[k].re);
+            r[k].im += g * (p.im - h * r[k].im);
+        }
+    }
+}
+
+#if defined(CONFIG_AOA_RX_COV_WINDOW)
+
+// R += sign * y * y^H
+static inline void rank1_add(struct cplx r[COV_ENTRIES], const struct cplx y[AOA_ANT_COUNT],
+                             int sign)
+{
+    cov_rank1(r, y, sign, 0.0f);
+}
+
+static void cov_fold(struct cov_state *st, const struct cplx y[AOA_ANT_COUNT], uint32_t freq)
+{
+    if (st->cov.count >= K) {
+        // Rank-1 downdate: the oldest snapshot leaves the window
+        rank1_add(st->cov.r, st->window[st->head], -1);
+        st->freq_sum -= st->window_freq[st->head];
+    }
+    rank1_add(st->cov.r, y, 1);
+    memcpy(st->window[st->head], y, sizeof(st->window[0]));
+    st->window_freq[st->head] = freq;
+    st->freq_sum += freq;
+    st->head = (st->head + 1) % K;
+
+    if (st->cov.count < UINT16_MAX) {
+        st->cov.count++;
+    }
+    st->cov.freq_mhz = st->freq_sum / MIN(st->cov.count, K);
+
+#if defined(COV_REBUILD_INTERVAL)
+    if (++st->since_rebuild >= COV_REBUILD_INTERVAL) {
+        st->since_rebuild = 0;
+        memset(st->cov.r, 0, sizeof(st->cov.r));
+        for (int i = 0; i < K; i++) {
+            rank1_add(st->cov.r, st->window[i], 1);
+        }
+    }
+#endif
+}
+
+#else
+
+// R += (y * y^H - R) / w, the running mean for the first K snapshots
+static void cov_fold(struct cov_state *st, const struct cplx y[AOA_ANT_COUNT], uint32_t freq)
+{
+    const int32_t w = MIN(st->cov.count + 1, K);
+
+    cov_rank1(st->cov.r, y, 1.0f / w, 1.0f);
+    st->freq_q8 += ((int32_t)(freq << 8) - (int32_t)st->freq_q8) / w;
+
+    if (st->cov.count < UINT16_MAX) {
+        st->cov.count++;
+    }
+    st->cov.freq_mhz = (st->freq_q8 + 128) >> 8;
+}
+
+#endif /* CONFIG_AOA_RX_COV_WINDOW */
+
+int cov_update(struct aoa_state *state, const struct aoa_iq_report *report,
+               const struct cplx x[AOA_ANT_COUNT], const struct cov **cov)
+{
+    if (report->tag_id >= ARRAY_SIZE(state->cov)) {
+        return -EINVAL;
+    }
+
+    struct cplx y[AOA_ANT_COUNT];
+    int err = normalize(x, y);
+    if (err) {
+        return err;
+    }
+
+    struct cov_state *st = &state->cov[report->tag_id];
+    const uint16_t dt = report->event_counter - st->event_counter;
+
+    if (!st->valid || st->source != report->source || event_gap(dt, &st->step)) {
+        memset(st, 0, sizeof(*st));
+        st->valid = true;
+        st->source = report->source;
+    }
+    st->event_counter = report->event_counter;
+
+    cov_fold(st, y, chan_freq_mhz(report->chan_idx));
+    *cov = &st->cov;
+    return 0;
+}
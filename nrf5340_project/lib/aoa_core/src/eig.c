@@ -0,0 +1,129 @@
+#include <math.h>
+
+#include "eig.h"
+
+#define N AOA_ANT_COUNT
+
+// Off-diagonal energy, relative to the squared trace, below which a sweep is not worth it
+#define EIG_TOLERANCE 1e-10f
+
+/*
+ * Zero a[p][q] with the unitary rotation J, whose columns p and q are
+ * (c, -s * conj(e)) and (s * e, c) in rows p and q, where e is the phase
+ * of a[p][q]: a = J^H a J, v = v J. c and s are those of the real Jacobi
+ * rotation for the magnitude of a[p][q].
+ */
+static void rotate(struct cplx a[N][N], struct cplx v[N][N], int p, int q)
+{
+    const struct cplx apq = a[p][q];
+    const float mag = hypotf(apq.re, apq.im);
+    if (mag == 0.0f) {
+        return;
+    }
+
+    const struct cplx e = { apq.re / mag, apq.im / mag };
+    const float tau = (a[q][q].re - a[p][p].re) / (2.0f * mag);
+    const float t = copysignf(1.0f, tau) / (fabsf(tau) + sqrtf(1.0f + tau * tau));
+    const float c = 1.0f / sqrtf(1.0f + t * t);
+    const float s = t * c;
+    // s * e and s * conj(e)
+    const struct cplx se = { s * e.re, s * e.im };
+    const struct cplx sec = { s * e.re, -s * e.im };
+
+    // Columns: a J and v J
+    AOA_UNROLL
+    for (int k = 0; k < N; k++) {
+        const struct cplx akp = a[k][p];
+        const struct cplx akq = a[k][q];
+        a[k][p].re = c * akp.re - (akq.re * sec.re - akq.im * sec.im);
+        a[k][p].im = c * akp.im - (akq.re * sec.im + akq.im * sec.re);
+        a[k][q].re = (akp.re * se.re - akp.im * se.im) + c * akq.re;
+        a[k][q].im = (akp.re * se.im + akp.im * se.re) + c * akq.im;
+
+        const struct cplx vkp = v[k][p];
+        const struct cplx vkq = v[k][q];
+        v[k][p].re = c * vkp.re - (vkq.re * sec.re - vkq.im * sec.im);
+        v[k][p].im = c * vkp.im - (vkq.re * sec.im + vkq.im * sec.re);
+        v[k][q].re = (vkp.re * se.re - vkp.im * se.im) + c * vkq.re;
+        v[k][q].im = (vkp.re * se.im + vkp.im * se.re) + c * vkq.im;
+    }
+
+    // Rows: J^H (a J)
+    AOA_UNROLL
+    for (int k = 0; k < N; k++) {
+        const struct cplx apk = a[p][k];
+        const struct cplx aqk = a[q][k];
+        a[p][k].re = c * apk.re - (aqk.re * se.re - aqk.im * se.im);
+        a[p][k].im = c * apk.im - (aqk.re * se.im + aqk.im * se.re);
+        a[q][k].re = (apk.re * sec.re - apk.im * sec.im) + c * aqk.re;
+        a[q][k].im = (apk.re * sec.im + apk.im * sec.re) + c * aqk.im;
+    }
+
+    // Exact in theory; clear the rounding so it cannot grow over sweeps
+    a[p][q] = (struct cplx){ 0.0f, 0.0f };
+    a[q][p] = (struct cplx){ 0.0f, 0.0f };
+    a[p][p].im = 0.0f;
+    a[q][q].im = 0.0f;
+}
+
+static float off_diagonal(const struct cplx a[N][N])
+{
+    float off = 0.0f;
+
+    for (int p = 0; p < N - 1; p++) {
+        for (int q = p + 1; q < N; q++) {
+            off += a[p][q].re * a[p][q].re + a[p][q].im * a[p][q].im;
+        }
+    }
+    return off;
+}
+
+void eig_hermitian(struct cplx a[N][N], struct cplx v[N][N], float w[N])
+{
+    float trace = 0.0f;
+
+    for (int p = 0; p < N; p++) {
+        for (int q = 0; q < N; q++) {
+            v[p][q] = (struct cplx){ p == q ? 1.0f : 0.0f, 0.0f };
+        }
+        trace += fabsf(a[p][p].re);
+    }
+
+    const float tolerance = EIG_TOLERANCE * trace * trace;
+    for (int sweep = 0; sweep < CONFIG_AOA_RX_EIG_SWEEPS; sweep++) {
+        if (off_diagonal(a) <= tolerance) {
+            break;
+        }
+        for (int p = 0; p < N - 1; p++) {
+            for (int q = p + 1; q < N; q++) {
+                rotate(a, v, p, q);
+            }
+        }
+    }
+
+    for (int p = 0; p < N; p++) {
+        w[p] = a[p][p].re;
+    }
+
+    // Selection sort, largest first, moving the eigenvectors along
+    for (int i = 0; i < N - 1; i++) {
+        int max = i;
+        for (int j = i + 1; j < N; j++) {
+            if (w[j] > w[max]) {
+                max = j;
+            }
+        }
+        if (max == i) {
+            continue;
+        }
+
+        const float wt = w[i];
+        w[i] = w[max];
+        w[max] = wt;
+        for (int k = 0; k < N; k++) {
+            const struct cplx vt = v[k][i];
+            v[k][i] = v[k][max];
+            v[k][max] = vt;
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef AOA_CORE_EIG_H_
+#define AOA_CORE_EIG_H_
+
+#include "aoa/dsp.h"
+
+/*
+ * Eigensolver for the AOA_ANT_COUNT square Hermitian matrices of the
+ * subspace estimators. Cyclic Jacobi: each rotation zeroes one
+ * off-diagonal pair, in place, and a fixed number of sweeps over all
+ * pairs bounds the cost per report. Single precision.
+ */
+
+/**
+ * @brief Eigendecomposition of @p a.
+ *
+ * @param a Hermitian matrix, both triangles filled. Overwritten.
+ * @param v Receives the unit eigenvectors as columns, in the order of @p w.
+ * @param w Receives the eigenvalues, largest first.
+ */
+void eig_hermitian(struct cplx a[AOA_ANT_COUNT][AOA_ANT_COUNT],
+                   struct cplx v[AOA_ANT_COUNT][AOA_ANT_COUNT], float w[AOA_ANT_COUNT]);
+
+#endif /* AOA_CORE_EIG_H_ */
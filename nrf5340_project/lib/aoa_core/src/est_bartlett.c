@@ -0,0 +1,67 @@
+#include "beam.h"
+
+/*
+ * Bartlett (delay-and-sum) beamformer: steer the array over a grid of
+ * directions and pick the one with the most output power, |a^H x|^2 for
+ * a single snapshot or a^H R a for a tag's covariance.
+ */
+
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+
+int estimate_angle(const struct cov *cov, struct aoa_angle_result *result)
+{
+    // Trace of R, the mean snapshot energy
+    float energy = 0.0f;
+
+    AOA_UNROLL
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        energy += cov_at(cov, m, m).re;
+    }
+    if (energy <= 0.0f) {
+        return -EINVAL;
+    }
+
+    struct beam_input in;
+    beam_input_init(&in, cov);
+
+    struct beam_peak peaks[BEAM_PEAKS];
+    beam_scan(&in, cov->freq_mhz, peaks);
+
+    const float best = peaks[0].power;
+    result->azimuth = peaks[0].azimuth;
+    result->elevation = peaks[0].elevation;
+    // a^H R a is bounded by N times the trace of R
+    result->quality = best / (AOA_ANT_COUNT * energy);
+    return 0;
+}
+
+#else
+
+int estimate_angle(const struct cplx x[AOA_ANT_COUNT], uint8_t chan_idx,
+                   struct aoa_angle_result *result)
+{
+    float energy = 0.0f;
+
+    AOA_UNROLL
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        energy += x[m].re * x[m].re + x[m].im * x[m].im;
+    }
+    if (energy == 0.0f) {
+        return -EINVAL;
+    }
+
+    struct beam_input in;
+    beam_input_init(&in, x);
+
+    struct beam_peak peaks[BEAM_PEAKS];
+    beam_scan(&in, chan_freq_mhz(chan_idx), peaks);
+
+    const float best = peaks[0].power;
+    result->azimuth = peaks[0].azimuth;
+    result->elevation = peaks[0].elevation;
+    // Cauchy-Schwarz bounds the output power by N times the snapshot energy
+    result->quality = best / (AOA_ANT_COUNT * energy);
+    return 0;
+}
+
+#endif /* CONFIG_AOA_RX_COVARIANCE */
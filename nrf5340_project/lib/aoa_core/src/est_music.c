@@ -0,0 +1,64 @@
+#include "beam.h"
+#include "eig.h"
+
+/*
+ * MUSIC: the eigenvectors of a tag's covariance split into a signal
+ * subspace, the CONFIG_AOA_RX_MUSIC_PATHS strongest, and a noise subspace
+ * orthogonal to every arrival direction. The pseudospectrum
+ * 1 / (a^H En En^H a) peaks where the steering vector has no noise
+ * component. With |a|^2 = N that is where a^H Es Es^H a is largest, so
+ * the beam scan of the signal subspace projector finds the same peaks.
+ */
+
+#define PATHS CONFIG_AOA_RX_MUSIC_PATHS
+
+BUILD_ASSERT(PATHS < AOA_ANT_COUNT, "MUSIC needs at least one noise eigenvector");
+
+// Too large for the DSP thread stack
+AOA_SCRATCH struct cplx a[AOA_ANT_COUNT][AOA_ANT_COUNT];
+AOA_SCRATCH struct cplx v[AOA_ANT_COUNT][AOA_ANT_COUNT];
+AOA_SCRATCH struct cov projector;
+
+int estimate_angle(const struct cov *cov, struct aoa_angle_result *result)
+{
+    float w[AOA_ANT_COUNT];
+
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        for (int n = 0; n < AOA_ANT_COUNT; n++) {
+            a[m][n] = cov_at(cov, m, n);
+        }
+    }
+    eig_hermitian(a, v, w);
+    if (w[0] <= 0.0f) {
+        return -EINVAL;
+    }
+
+    // Es Es^H in the covariance layout, so the scan treats it like any R
+    int k = 0;
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        for (int n = m; n < AOA_ANT_COUNT; n++, k++) {
+            struct cplx p = { 0.0f, 0.0f };
+
+            for (int s = 0; s < PATHS; s++) {
+                p.re += v[m][s].re * v[n][s].re + v[m][s].im * v[n][s].im;
+                p.im += v[m][s].im * v[n][s].re - v[m][s].re * v[n][s].im;
+            }
+            projector.r[k] = p;
+        }
+    }
+    projector.freq_mhz = cov->freq_mhz;
+    projector.count = cov->count;
+
+    struct beam_input in;
+    beam_input_init(&in, &projector);
+
+    struct beam_peak peaks[BEAM_PEAKS];
+    beam_scan(&in, cov->freq_mhz, peaks);
+
+    const float best = peaks[0].power;
+    result->azimuth = peaks[0].azimuth;
+    result->elevation = peaks[0].elevation;
+    // Share of the steering vector inside the signal subspace, 1 on an exact match
+    result->quality = best / AOA_ANT_COUNT;
+    return 0;
+}
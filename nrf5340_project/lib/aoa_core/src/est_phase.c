@@ -0,0 +1,224 @@
+#include <math.h>
+
+#include "aoa/dsp.h"
+
+#if defined(CONFIG_AOA_RX_MATH_FIXED)
+#include "fixed.h"
+#include "q15.h"
+#endif
+
+/*
+ * Phase-difference estimator: the phase step between neighbouring
+ * elements, averaged over every pair, gives the direction cosine along
+ * that axis. A ULA has one axis; a URA adds the step between rows.
+ */
+
+#define COL_STEP 1
+#define ROW_STEP AOA_ANT_COLS
+
+// True if element m has a neighbour @p step elements further along the same axis
+static inline bool pair_valid(int m, int step)
+{
+    if (step == COL_STEP) {
+        return m % AOA_ANT_COLS != AOA_ANT_COLS - 1;
+    }
+    return m + step < AOA_ANT_COUNT;
+}
+
+#if defined(CONFIG_AOA_RX_MATH_FIXED)
+
+/*
+ * The snapshot as packed 16-bit I/Q for the Q15 kernels, every part
+ * shifted down by the same amount until the largest fits. A common shift
+ * leaves the phases and the coherence as they were.
+ */
+static void snapshot_q15(const struct cplx x[AOA_ANT_COUNT], struct aoa_iq_sample q[AOA_ANT_COUNT])
+{
+    uint32_t peak = 0;
+
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        peak = MAX(peak, (uint32_t)(x[m].re < 0 ? -(int64_t)x[m].re : x[m].re));
+        peak = MAX(peak, (uint32_t)(x[m].im < 0 ? -(int64_t)x[m].im : x[m].im));
+    }
+
+    int shift = 0;
+    while ((peak >> shift) > INT16_MAX) {
+        shift++;
+    }
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        q[m].i = x[m].re >> shift;
+        q[m].q = x[m].im >> shift;
+    }
+}
+
+/*
+ * Mean phase step along one axis and its coherence, |sum of steps| over
+ * the sum of their magnitudes in Q15.
+ */
+static int axis_estimate(const struct aoa_iq_sample q[AOA_ANT_COUNT],
+                         const uint32_t mag[AOA_ANT_COUNT], int step, int32_t *phase,
+                         uint32_t *coherence)
+{
+    int64_t c_re = 0;
+    int64_t c_im = 0;
+    int64_t norm = 0;
+
+    // Neighbours along a row pair up within each row; between rows, all at once
+    if (step == COL_STEP) {
+        for (int r = 0; r < AOA_ANT_ROWS; r++) {
+            int64_t re, im;
+
+            q15_corr(&q[r * AOA_ANT_COLS], &q[r * AOA_ANT_COLS + 1], AOA_ANT_COLS - 1, &re, &im);
+            c_re += re;
+            c_im += im;
+        }
+    } else {
+        q15_corr(q, &q[step], AOA_ANT_COUNT - step, &c_re, &c_im);
+    }
+
+    AOA_UNROLL
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        if (pair_valid(m, step)) {
+            norm += (int64_t)mag[m + step] * mag[m];
+        }
+    }
+    if (norm == 0) {
+        return -EINVAL;
+    }
+
+    int32_t re, im;
+    uint32_t c_mag;
+    const int shift = fx_narrow(c_re, c_im, &re, &im);
+    *phase = fx_atan2(im, re, &c_mag);
+
+    // Same shift on the denominator keeps the ratio
+    norm >>= shift;
+    *coherence = norm ? MIN(((uint64_t)c_mag << 15) / norm, FX_Q15_ONE) : FX_Q15_ONE;
+    return 0;
+}
+
+// Direction cosine in Q15 from a phase step in binary angle units
+static int32_t direction_cosine(int32_t phase, uint32_t lambda_over_d_q16)
+{
+    const int64_t u = ((int64_t)phase * lambda_over_d_q16) >> 33;
+    return CLAMP(u, -FX_Q15_ONE, FX_Q15_ONE);
+}
+
+int estimate_phase_diff(const struct cplx x[AOA_ANT_COUNT], uint8_t chan_idx,
+                        struct aoa_angle_result *result)
+{
+    struct aoa_iq_sample q[AOA_ANT_COUNT];
+    uint32_t mag[AOA_ANT_COUNT];
+
+    snapshot_q15(x, q);
+
+    AOA_UNROLL
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        mag[m] = fx_isqrt((int64_t)q[m].i * q[m].i + (int64_t)q[m].q * q[m].q);
+    }
+
+    // Wavelength over element spacing; MHz times um cancels the 1e6 factors
+    const uint32_t lambda_over_d_q16 =
+        ((uint64_t)SPEED_OF_LIGHT << 16) / (chan_freq_mhz(chan_idx) * AOA_ANT_SPACING_UM);
+
+    int32_t phase_x;
+    uint32_t coherence_x;
+    int err = axis_estimate(q, mag, COL_STEP, &phase_x, &coherence_x);
+    if (err) {
+        return err;
+    }
+    const int32_t u = direction_cosine(phase_x, lambda_over_d_q16);
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    int32_t phase_y;
+    uint32_t coherence_y;
+    err = axis_estimate(q, mag, ROW_STEP, &phase_y, &coherence_y);
+    if (err) {
+        return err;
+    }
+    const int32_t v = direction_cosine(phase_y, lambda_over_d_q16);
+
+    // Horizontal component of the arrival direction, cosine of the elevation
+    const uint32_t r = MIN(fx_isqrt((int64_t)u * u + (int64_t)v * v), FX_Q15_ONE);
+    const uint32_t h = fx_isqrt((uint64_t)FX_Q15_ONE * FX_Q15_ONE - (uint64_t)r * r);
+
+    result->azimuth = fx_to_deg(fx_atan2(v, u, NULL));
+    result->elevation = fx_to_deg(fx_atan2(h, r, NULL));
+    result->quality = (coherence_x + coherence_y) / (2.0f * FX_Q15_ONE);
+#else
+    const uint32_t h = fx_isqrt((uint64_t)FX_Q15_ONE * FX_Q15_ONE - (int64_t)u * u);
+
+    result->azimuth = fx_to_deg(fx_atan2(u, h, NULL));
+    result->elevation = 0.0f;
+    result->quality = coherence_x / (float)FX_Q15_ONE;
+#endif
+    return 0;
+}
+
+#else
+
+// Mean phase step along one axis and its coherence, 0..1
+static int axis_estimate(const struct cplx x[AOA_ANT_COUNT], int step, float *phase,
+                         float *coherence)
+{
+    struct cplx c = { 0.0f, 0.0f };
+    float norm = 0.0f;
+
+    AOA_UNROLL
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        if (!pair_valid(m, step)) {
+            continue;
+        }
+        const struct cplx *a = &x[m];
+        const struct cplx *b = &x[m + step];
+        c.re += b->re * a->re + b->im * a->im;
+        c.im += b->im * a->re - b->re * a->im;
+        norm += hypotf(b->re, b->im) * hypotf(a->re, a->im);
+    }
+    if (norm == 0.0f) {
+        return -EINVAL;
+    }
+
+    *phase = atan2f(c.im, c.re);
+    *coherence = hypotf(c.re, c.im) / norm;
+    return 0;
+}
+
+static float direction_cosine(float phase, float lambda_over_d)
+{
+    return fminf(fmaxf(phase * lambda_over_d / (2.0f * (float)M_PI), -1.0f), 1.0f);
+}
+
+int estimate_phase_diff(const struct cplx x[AOA_ANT_COUNT], uint8_t chan_idx,
+                        struct aoa_angle_result *result)
+{
+    const float lambda_over_d =
+        SPEED_OF_LIGHT / (chan_freq_mhz(chan_idx) * 1e6f * AOA_ANT_SPACING_M);
+
+    float phase_x, coherence_x;
+    int err = axis_estimate(x, COL_STEP, &phase_x, &coherence_x);
+    if (err) {
+        return err;
+    }
+    const float u = direction_cosine(phase_x, lambda_over_d);
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    float phase_y, coherence_y;
+    err = axis_estimate(x, ROW_STEP, &phase_y, &coherence_y);
+    if (err) {
+        return err;
+    }
+    const float v = direction_cosine(phase_y, lambda_over_d);
+
+    result->azimuth = atan2f(v, u) * (180.0f / (float)M_PI);
+    result->elevation = acosf(fminf(hypotf(u, v), 1.0f)) * (180.0f / (float)M_PI);
+    result->quality = (coherence_x + coherence_y) / 2.0f;
+#else
+    result->azimuth = asinf(u) * (180.0f / (float)M_PI);
+    result->elevation = 0.0f;
+    result->quality = coherence_x;
+#endif
+    return 0;
+}
+
+#endif /* CONFIG_AOA_RX_MATH_FIXED */
@@ -0,0 +1,110 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#include "fixed.h"
+
+#define CORDIC_ITERATIONS 16
+#define CORDIC_GAIN_INV_Q15 19898 // 1 / 1.6468 after 16 iterations
+
+// atan(2^-i) in binary angle units
+static const int32_t cordic_atan[CORDIC_ITERATIONS] = {
+    536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+    2670163,   1335087,   667544,    333772,   166886,   83443,    41722,    20861,
+};
+
+void fx_rotate(int32_t *x, int32_t *y, int32_t angle)
+{
+    int32_t xi = *x;
+    int32_t yi = *y;
+
+    // CORDIC converges within +-99 degrees; turn the rest around first
+    if (angle > FX_QUARTER_TURN || angle < -FX_QUARTER_TURN) {
+        xi = -xi;
+        yi = -yi;
+        angle = (int32_t)((uint32_t)angle + (uint32_t)FX_HALF_TURN);
+    }
+
+    for (int i = 0; i < CORDIC_ITERATIONS; i++) {
+        const int32_t dx = yi >> i;
+        const int32_t dy = xi >> i;
+
+        if (angle >= 0) {
+            xi -= dx;
+            yi += dy;
+            angle -= cordic_atan[i];
+        } else {
+            xi += dx;
+            yi -= dy;
+            angle += cordic_atan[i];
+        }
+    }
+
+    *x = xi;
+    *y = yi;
+}
+
+int32_t fx_atan2(int32_t y, int32_t x, uint32_t *mag)
+{
+    uint32_t angle = 0;
+
+    if (x < 0) {
+        x = -x;
+        y = -y;
+        angle = (uint32_t)FX_HALF_TURN;
+    }
+
+    for (int i = 0; i < CORDIC_ITERATIONS; i++) {
+        const int32_t dx = y >> i;
+        const int32_t dy = x >> i;
+
+        if (y < 0) {
+            x -= dx;
+            y += dy;
+            angle -= cordic_atan[i];
+        } else {
+            x += dx;
+            y -= dy;
+            angle += cordic_atan[i];
+        }
+    }
+
+    if (mag) {
+        *mag = (uint32_t)(((uint64_t)x * CORDIC_GAIN_INV_Q15) >> 15);
+    }
+    return (int32_t)angle;
+}
+
+uint32_t fx_isqrt(uint64_t v)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+int fx_narrow(int64_t re, int64_t im, int32_t *re32, int32_t *im32)
+{
+    const int64_t limit = (int64_t)1 << 28;
+    int shift = 0;
+
+    while (re >= limit || re < -limit || im >= limit || im < -limit) {
+        re >>= 1;
+        im >>= 1;
+        shift++;
+    }
+    *re32 = (int32_t)re;
+    *im32 = (int32_t)im;
+    return shift;
+}
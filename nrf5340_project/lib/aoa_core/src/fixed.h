@@ -0,0 +1,51 @@
+#ifndef AOA_CORE_FIXED_H_
+#define AOA_CORE_FIXED_H_
+
+#include <stdint.h>
+
+/*
+ * Fixed-point helpers for CONFIG_AOA_RX_MATH_FIXED and the IQ packer,
+ * which runs on locators without an FPU. Angles are binary
+ * angle units: a full turn is 2^32, so int32_t arithmetic wraps the same
+ * way the phase does.
+ */
+
+#define FX_QUARTER_TURN 0x40000000
+#define FX_HALF_TURN ((int32_t)0x80000000)
+
+/* Sines, cosines and direction cosines use Q15 */
+#define FX_Q15_ONE 32768
+
+/**
+ * @brief Rotate (*x, *y) by @p angle.
+ *
+ * The result is scaled by the CORDIC gain (about 1.647), the same for
+ * every call, so inputs must stay below 2^29.
+ */
+void fx_rotate(int32_t *x, int32_t *y, int32_t angle);
+
+/**
+ * @brief Angle of (x, y), like atan2(y, x).
+ *
+ * Inputs must stay below 2^29.
+ *
+ * @param mag If not NULL, receives the magnitude of (x, y).
+ */
+int32_t fx_atan2(int32_t y, int32_t x, uint32_t *mag);
+
+uint32_t fx_isqrt(uint64_t v);
+
+/**
+ * @brief Shift a 64-bit complex value down until both parts fit fx_atan2().
+ *
+ * @return The number of bits shifted out.
+ */
+int fx_narrow(int64_t re, int64_t im, int32_t *re32, int32_t *im32);
+
+static inline float fx_to_deg(int32_t angle)
+{
+    // Hundredths of a degree in integer, one conversion at the end
+    return (int32_t)(((int64_t)angle * 36000) >> 32) / 100.0f;
+}
+
+#endif /* AOA_CORE_FIXED_H_ */
@@ -0,0 +1,132 @@
+#include <string.h>
+
+#include "aoa/frame.h"
+
+// CRC-16/CCITT, four bits at a time
+static const uint16_t crc_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+};
+
+uint16_t aoa_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xffff;
+
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (data[i] & 0x0f)];
+    }
+    return crc;
+}
+
+struct cobs {
+    uint8_t *out;
+    uint8_t *code;              // Where the current block's code byte goes
+};
+
+static inline void cobs_put(struct cobs *c, uint8_t b)
+{
+    if (b == 0) {
+        *c->code = c->out - c->code;
+        c->code = c->out++;
+        return;
+    }
+    *c->out++ = b;
+    if (c->out - c->code == 0xff) {
+        *c->code = 0xff;
+        c->code = c->out++;
+    }
+}
+
+int aoa_frame_encode(const uint8_t *payload, size_t len, uint8_t *buf, size_t size)
+{
+    if (size < AOA_FRAME_SIZE(len)) {
+        return -ENOSPC;
+    }
+
+    const uint16_t crc = aoa_crc16(payload, len);
+    struct cobs c = { .out = buf + 1, .code = buf };
+
+    for (size_t i = 0; i < len; i++) {
+        cobs_put(&c, payload[i]);
+    }
+    cobs_put(&c, crc);
+    cobs_put(&c, crc >> 8);
+    *c.code = c.out - c.code;
+    *c.out++ = 0;
+    return c.out - buf;
+}
+
+// Undo COBS in place; the output never overtakes the input
+static int cobs_decode(uint8_t *buf, size_t len)
+{
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < len) {
+        const uint8_t code = buf[in++];
+        if (code == 0 || in + code - 1 > len) {
+            return -EBADMSG;
+        }
+        for (int i = 1; i < code; i++) {
+            buf[out++] = buf[in++];
+        }
+        if (code < 0xff && in < len) {
+            buf[out++] = 0;
+        }
+    }
+    return out;
+}
+
+static int frame_finish(struct aoa_frame_decoder *dec, const uint8_t **payload)
+{
+    const int len = cobs_decode(dec->buf, dec->len);
+    dec->len = 0;
+
+    if (len < 2) {
+        return -EBADMSG;
+    }
+    const uint16_t crc = dec->buf[len - 2] | dec->buf[len - 1] << 8;
+    if (aoa_crc16(dec->buf, len - 2) != crc) {
+        return -EBADMSG;
+    }
+    *payload = dec->buf;
+    return len - 2;
+}
+
+int aoa_frame_decode(struct aoa_frame_decoder *dec, const uint8_t *data, size_t len,
+                     size_t *consumed, const uint8_t **payload)
+{
+    size_t used = 0;
+
+    while (used < len) {
+        const uint8_t *end = memchr(&data[used], 0, len - used);
+        const size_t chunk = (end ? (size_t)(end - data) : len) - used;
+
+        if (!dec->overflow && dec->len + chunk <= sizeof(dec->buf)) {
+            memcpy(&dec->buf[dec->len], &data[used], chunk);
+            dec->len += chunk;
+        } else {
+            dec->overflow = true;
+        }
+        used += chunk;
+        if (!end) {
+            break;
+        }
+
+        // Delimiter: a frame is complete, unless it is empty
+        used++;
+        if (dec->overflow) {
+            aoa_frame_decoder_init(dec);
+            *consumed = used;
+            return -EBADMSG;
+        }
+        if (dec->len > 0) {
+            *consumed = used;
+            return frame_finish(dec, payload);
+        }
+    }
+
+    *consumed = used;
+    return 0;
+}
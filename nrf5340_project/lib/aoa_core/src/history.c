@@ -0,0 +1,157 @@
+#include <string.h>
+
+#include "aoa/history.h"
+
+static size_t varint_put(uint8_t *p, uint32_t v)
+{
+    size_t n = 0;
+
+    while (v >= 0x80) {
+        p[n++] = (v & 0x7f) | 0x80;
+        v >>= 7;
+    }
+    p[n++] = v;
+    return n;
+}
+
+static int varint_get(struct aoa_history_decoder *dec, uint32_t *v)
+{
+    *v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (dec->p == dec->end) {
+            return -EBADMSG;
+        }
+        const uint8_t b = *dec->p++;
+        *v |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return 0;
+        }
+    }
+    return -EBADMSG;
+}
+
+static inline uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Tenths of a degree, rounded, saturating at the int16 range
+static int16_t deci(float deg)
+{
+    const float d = CLAMP(deg * 10.0f, -32768.0f, 32767.0f);
+    return (int16_t)(d < 0.0f ? d - 0.5f : d + 0.5f);
+}
+
+void aoa_history_encoder_init(struct aoa_history_encoder *enc, uint8_t *buf, size_t size,
+                              uint16_t boot, uint8_t flags)
+{
+    buf[0] = AOA_HISTORY_VERSION;
+    buf[1] = flags;
+    buf[2] = boot;
+    buf[3] = boot >> 8;
+    memset(&buf[4], 0, 4);
+    enc->buf = buf;
+    enc->size = size;
+    enc->len = AOA_HISTORY_HEADER_SIZE;
+    enc->time_ms = 0;
+    enc->tags = 0;
+    enc->count = 0;
+    enc->boot = boot;
+    enc->flags = flags;
+}
+
+int aoa_history_append(struct aoa_history_encoder *enc, const struct aoa_history_entry *entry)
+{
+    const uint8_t tag = entry->tag_id;
+    if (tag >= AOA_HISTORY_TAGS_MAX) {
+        return -EINVAL;
+    }
+    if (enc->count && entry->time_ms < enc->time_ms) {
+        return -ERANGE;
+    }
+
+    // The first entry's time goes in the header, so its own delta is zero
+    const bool first = enc->count == 0;
+    const bool seen = enc->tags & (1u << tag);
+    const int16_t az = deci(entry->azimuth);
+    const int16_t el = deci(entry->elevation);
+    const float quality = CLAMP(entry->quality, 0.0f, 1.0f);
+    uint8_t e[AOA_HISTORY_ENTRY_SIZE_MAX];
+    size_t n = 0;
+
+    e[n++] = tag;
+    n += varint_put(&e[n], first ? 0 : entry->time_ms - enc->time_ms);
+    n += varint_put(&e[n], zigzag(az - (seen ? enc->azimuth[tag] : 0)));
+    if (enc->flags & AOA_HISTORY_ELEVATION) {
+        n += varint_put(&e[n], zigzag(el - (seen ? enc->elevation[tag] : 0)));
+    }
+    e[n++] = (uint8_t)(quality * 255.0f + 0.5f);
+
+    if (enc->len + n > enc->size) {
+        return -ENOSPC;
+    }
+
+    if (first) {
+        enc->buf[4] = entry->time_ms;
+        enc->buf[5] = entry->time_ms >> 8;
+        enc->buf[6] = entry->time_ms >> 16;
+        enc->buf[7] = entry->time_ms >> 24;
+    }
+    memcpy(&enc->buf[enc->len], e, n);
+    enc->len += n;
+    enc->time_ms = entry->time_ms;
+    enc->tags |= 1u << tag;
+    enc->azimuth[tag] = az;
+    enc->elevation[tag] = el;
+    enc->count++;
+    return 0;
+}
+
+int aoa_history_decoder_init(struct aoa_history_decoder *dec, const uint8_t *buf, size_t len)
+{
+    if (len < AOA_HISTORY_HEADER_SIZE || buf[0] > AOA_HISTORY_VERSION) {
+        return -EBADMSG;
+    }
+
+    dec->flags = buf[1];
+    dec->boot = buf[2] | (uint16_t)buf[3] << 8;
+    dec->time_ms = buf[4] | (uint32_t)buf[5] << 8 | (uint32_t)buf[6] << 16 |
+                   (uint32_t)buf[7] << 24;
+    dec->tags = 0;
+    dec->p = &buf[AOA_HISTORY_HEADER_SIZE];
+    dec->end = &buf[len];
+    return 0;
+}
+
+int aoa_history_next(struct aoa_history_decoder *dec, struct aoa_history_entry *entry)
+{
+    if (dec->p == dec->end) {
+        return 0;
+    }
+
+    const uint8_t tag = *dec->p++;
+    uint32_t dt, az, el = 0;
+    if (tag >= AOA_HISTORY_TAGS_MAX || varint_get(dec, &dt) || varint_get(dec, &az) ||
+        ((dec->flags & AOA_HISTORY_ELEVATION) && varint_get(dec, &el)) || dec->p == dec->end) {
+        return -EBADMSG;
+    }
+
+    const bool seen = dec->tags & (1u << tag);
+    dec->time_ms += dt;
+    dec->azimuth[tag] = unzigzag(az) + (seen ? dec->azimuth[tag] : 0);
+    dec->elevation[tag] = unzigzag(el) + (seen ? dec->elevation[tag] : 0);
+    dec->tags |= 1u << tag;
+
+    entry->time_ms = dec->time_ms;
+    entry->boot = dec->boot;
+    entry->tag_id = tag;
+    entry->azimuth = dec->azimuth[tag] / 10.0f;
+    entry->elevation = dec->elevation[tag] / 10.0f;
+    entry->quality = *dec->p++ / 255.0f;
+    return 1;
+}
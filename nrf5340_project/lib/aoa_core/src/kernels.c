@@ -0,0 +1,181 @@
+#include <math.h>
+#include <string.h>
+
+#include "aoa/simd.h"
+#include "kernels.h"
+
+/*
+ * Kernel dispatch of host builds. The pick is made once, on first use,
+ * from what the CPU reports; the vector kernels are only built for the
+ * instruction set of the target (see CMakeLists.txt).
+ */
+
+const struct kernels kernels_scalar = {
+    .beam_power = beam_power_scalar,
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+    .cov_rank1 = cov_rank1_scalar,
+#endif
+};
+
+static const struct kernels *const tables[] = {
+    [AOA_SIMD_SCALAR] = &kernels_scalar,
+#if defined(AOA_CORE_SIMD_AVX2)
+    [AOA_SIMD_AVX2] = &kernels_avx2,
+#endif
+#if defined(AOA_CORE_SIMD_NEON)
+    [AOA_SIMD_NEON] = &kernels_neon,
+#endif
+};
+
+static const char *const names[] = {
+    [AOA_SIMD_SCALAR] = "scalar",
+    [AOA_SIMD_AVX2] = "avx2",
+    [AOA_SIMD_NEON] = "neon",
+};
+
+// enum aoa_simd, or -1 until the first use
+static int active = -1;
+
+static bool supported(enum aoa_simd simd)
+{
+    switch (simd) {
+    case AOA_SIMD_SCALAR:
+        return true;
+#if defined(AOA_CORE_SIMD_AVX2)
+    case AOA_SIMD_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#if defined(AOA_CORE_SIMD_NEON)
+    case AOA_SIMD_NEON:
+        return true; // Part of the AArch64 base architecture
+#endif
+    default:
+        return false;
+    }
+}
+
+enum aoa_simd aoa_simd_get(void)
+{
+    int simd = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+
+    if (simd < 0) {
+        simd = supported(AOA_SIMD_AVX2)   ? AOA_SIMD_AVX2
+               : supported(AOA_SIMD_NEON) ? AOA_SIMD_NEON
+                                          : AOA_SIMD_SCALAR;
+        __atomic_store_n(&active, simd, __ATOMIC_RELEASE);
+    }
+    return simd;
+}
+
+int aoa_simd_set(enum aoa_simd simd)
+{
+    if (!supported(simd)) {
+        return -ENOTSUP;
+    }
+    __atomic_store_n(&active, simd, __ATOMIC_RELEASE);
+    return 0;
+}
+
+const char *aoa_simd_name(enum aoa_simd simd)
+{
+    return (unsigned)simd < ARRAY_SIZE(names) ? names[simd] : "unknown";
+}
+
+const struct kernels *kernels_get(void)
+{
+    return tables[aoa_simd_get()];
+}
+
+// xorshift32, uniform in [-1, 1)
+static float uniform(uint32_t *seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return (int32_t)*seed * (1.0f / 2147483648.0f);
+}
+
+static void snapshot(uint32_t *seed, struct cplx y[AOA_ANT_COUNT])
+{
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        y[m].re = uniform(seed);
+        y[m].im = uniform(seed);
+    }
+}
+
+// Largest |a - b| relative to the largest |a|
+static float difference(const float *a, const float *b, int count)
+{
+    float scale = 0.0f;
+    float diff = 0.0f;
+
+    for (int i = 0; i < count; i++) {
+        scale = fmaxf(scale, fabsf(a[i]));
+        diff = fmaxf(diff, fabsf(a[i] - b[i]));
+    }
+    return scale > 0.0f ? diff / scale : diff;
+}
+
+#define CHECK_ROUNDS 16
+#define CHECK_DIRECTIONS 203     // Not a multiple of any vector width
+
+int aoa_simd_check(enum aoa_simd simd, float *error)
+{
+    if (!supported(simd)) {
+        return -ENOTSUP;
+    }
+
+    const struct kernels *kern = tables[simd];
+    uint32_t seed = 0x2545f491;
+    struct beam_input in;
+    float az[CHECK_DIRECTIONS];
+    float el[CHECK_DIRECTIONS];
+    float ref[CHECK_DIRECTIONS];
+    float out[CHECK_DIRECTIONS];
+
+    *error = 0.0f;
+    for (int round = 0; round < CHECK_ROUNDS; round++) {
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+        struct cov a;
+        struct cov b;
+        struct cplx y[AOA_ANT_COUNT];
+
+        // Both update rules from the same matrix: running mean, then window add and remove
+        memset(&a, 0, sizeof(a));
+        for (int i = 0; i < 8; i++) {
+            snapshot(&seed, y);
+            cov_rank1_scalar(a.r, y, 1.0f / (i + 1), 1.0f);
+        }
+        b = a;
+        snapshot(&seed, y);
+        cov_rank1_scalar(a.r, y, 0.125f, 1.0f);
+        kern->cov_rank1(b.r, y, 0.125f, 1.0f);
+        snapshot(&seed, y);
+        cov_rank1_scalar(a.r, y, -1.0f, 0.0f);
+        kern->cov_rank1(b.r, y, -1.0f, 0.0f);
+        *error = fmaxf(*error, difference(&a.r[0].re, &b.r[0].re, 2 * COV_ENTRIES));
+
+        beam_input_init(&in, &a);
+#else
+        struct cplx x[AOA_ANT_COUNT];
+
+        snapshot(&seed, x);
+        beam_input_init(&in, x);
+#endif
+        // Directions over the scanned range, element spacings around half a wavelength
+        const float k = 2.5f + uniform(&seed);
+        for (int i = 0; i < CHECK_DIRECTIONS; i++) {
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+            az[i] = 180.0f * uniform(&seed);
+            el[i] = 45.0f + 45.0f * uniform(&seed);
+#else
+            az[i] = 90.0f * uniform(&seed);
+            el[i] = 0.0f;
+#endif
+        }
+        beam_power_scalar(&in, k, az, el, ref, CHECK_DIRECTIONS);
+        kern->beam_power(&in, k, az, el, out, CHECK_DIRECTIONS);
+        *error = fmaxf(*error, difference(ref, out, CHECK_DIRECTIONS));
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+#ifndef AOA_CORE_KERNELS_H_
+#define AOA_CORE_KERNELS_H_
+
+#include "beam.h"
+
+/*
+ * The inner loops of the spectrum estimators: steering power over a batch
+ * of directions, and the rank-1 covariance update. The scalar versions
+ * live next to their callers. They are the reference, and the only
+ * version in firmware. Host builds with AOA_CORE_SIMD also build vector
+ * versions for each instruction set (kernels_vec.h) and call the set that
+ * aoa_simd_get() picks through a table.
+ */
+
+/** @brief Output power at @p count directions, in degrees. */
+typedef void (*beam_power_fn)(const struct beam_input *in, float k, const float *az,
+                              const float *el, float *power, int count);
+
+void beam_power_scalar(const struct beam_input *in, float k, const float *az, const float *el,
+                       float *power, int count);
+
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+/** @brief r += g * (y y^H - h * r) over the upper triangle. */
+typedef void (*cov_rank1_fn)(struct cplx r[COV_ENTRIES], const struct cplx y[AOA_ANT_COUNT],
+                             float g, float h);
+
+void cov_rank1_scalar(struct cplx r[COV_ENTRIES], const struct cplx y[AOA_ANT_COUNT], float g,
+                      float h);
+#endif
+
+#if defined(AOA_CORE_SIMD)
+
+struct kernels {
+    beam_power_fn beam_power;
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+    cov_rank1_fn cov_rank1;
+#endif
+};
+
+extern const struct kernels kernels_scalar;
+#if defined(AOA_CORE_SIMD_AVX2)
+extern const struct kernels kernels_avx2;
+#endif
+#if defined(AOA_CORE_SIMD_NEON)
+extern const struct kernels kernels_neon;
+#endif
+
+/** @brief The kernels aoa_simd_get() picked. */
+const struct kernels *kernels_get(void);
+
+#endif /* AOA_CORE_SIMD */
+
+static inline void beam_power(const struct beam_input *in, float k, const float *az,
+                              const float *el, float *power, int count)
+{
+#if defined(AOA_CORE_SIMD)
+    kernels_get()->beam_power(in, k, az, el, power, count);
+#else
+    beam_power_scalar(in, k, az, el, power, count);
+#endif
+}
+
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+static inline void cov_rank1(struct cplx r[COV_ENTRIES], const struct cplx y[AOA_ANT_COUNT],
+                             float g, float h)
+{
+#if defined(AOA_CORE_SIMD)
+    kernels_get()->cov_rank1(r, y, g, h);
+#else
+    cov_rank1_scalar(r, y, g, h);
+#endif
+}
+#endif
+
+#endif /* AOA_CORE_KERNELS_H_ */
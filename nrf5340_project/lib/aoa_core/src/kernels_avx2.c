@@ -0,0 +1,6 @@
+/* Kernels for x86-64 with AVX2 and FMA, built with -mavx2 -mfma */
+
+#define VEC_LANES 8
+#define KERNELS kernels_avx2
+
+#include "kernels_vec.h"
@@ -0,0 +1,6 @@
+/* Kernels for AArch64, where NEON is always present */
+
+#define VEC_LANES 4
+#define KERNELS kernels_neon
+
+#include "kernels_vec.h"
@@ -0,0 +1,285 @@
+#ifndef AOA_CORE_KERNELS_VEC_H_
+#define AOA_CORE_KERNELS_VEC_H_
+
+#include <math.h>
+#include <string.h>
+
+#include "kernels.h"
+
+/*
+ * Vector kernels, written once with GCC vector extensions and compiled
+ * once per instruction set: the including file defines VEC_LANES and
+ * KERNELS, the name of the table to define. The beam kernel steers
+ * VEC_LANES directions at a time, one per lane, and follows the scalar
+ * reference in beam.c step for step; the covariance kernel updates
+ * VEC_LANES / 2 entries at a time. Results differ from the reference by
+ * rounding only: sines and cosines come from the polynomials below, and
+ * the compiler may fuse multiplies and adds (aoa_simd_check() measures
+ * it).
+ */
+
+#define DEG_TO_RAD ((float)M_PI / 180.0f)
+
+typedef float vf __attribute__((vector_size(4 * VEC_LANES)));
+typedef int32_t vi __attribute__((vector_size(4 * VEC_LANES)));
+typedef uint32_t vu __attribute__((vector_size(4 * VEC_LANES)));
+
+static inline vf splat(float s)
+{
+    return (vf){ 0 } + s;
+}
+
+static inline vf load(const float *p)
+{
+    vf v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store(float *p, vf v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+/*
+ * sin and cos of every lane, to a few ulp over the few hundred radians
+ * the scan can reach. x is reduced to a quarter turn in three steps
+ * (Cody-Waite), so the reduction stays exact, and the quadrant picks the
+ * polynomial and sign of each result (Cephes sinf and cosf).
+ */
+static inline void vsincos(vf x, vf *s, vf *c)
+{
+    const float magic = 12582912.0f; // 1.5 * 2^23: adding it rounds to an integer
+    const vf j = (x * (float)(2.0 / M_PI) + magic) - magic;
+    const vu q = (vu)__builtin_convertvector(j, vi);
+    const vf r = ((x - j * 1.5703125f) - j * 4.837512969970703125e-4f) - j * 7.54978995489188216e-8f;
+    const vf z = r * r;
+
+    const vf sr = r + r * z * ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f);
+    const vf cr = 1.0f - 0.5f * z +
+                  z * z * ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z +
+                           4.166664568298827e-2f);
+
+    // Odd quadrants swap sin and cos; the sign bit follows the quadrant
+    const vu swap = -(q & 1);
+    const vu sin_sign = (q & 2) << 30;
+    const vu cos_sign = ((q + 1) & 2) << 30;
+    const vu sb = (vu)sr;
+    const vu cb = (vu)cr;
+
+    *s = (vf)(((sb & ~swap) | (cb & swap)) ^ sin_sign);
+    *c = (vf)(((cb & ~swap) | (sb & swap)) ^ cos_sign);
+}
+
+struct vcplx {
+    vf re;
+    vf im;
+};
+
+static inline struct vcplx vcmul(struct vcplx a, struct vcplx b)
+{
+    return (struct vcplx){ a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+}
+
+// e^(-i psi)
+static inline struct vcplx vturn(vf psi)
+{
+    struct vcplx w;
+
+    vsincos(psi, &w.im, &w.re);
+    w.im = -w.im;
+    return w;
+}
+
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+
+// sum over j of c[j] * w^j for @p count coefficients, the same in every lane
+static inline struct vcplx vpoly_eval(const struct cplx *c, int count, struct vcplx w)
+{
+    struct vcplx acc = { splat(c[count - 1].re), splat(c[count - 1].im) };
+
+    for (int j = count - 2; j >= 0; j--) {
+        const vf re = acc.re * w.re - acc.im * w.im + c[j].re;
+        const vf im = acc.re * w.im + acc.im * w.re + c[j].im;
+        acc.re = re;
+        acc.im = im;
+    }
+    return acc;
+}
+
+static inline vf vsteer_power(const struct beam_input *in, vf psi_x, vf psi_y)
+{
+    const struct vcplx wx = vturn(psi_x);
+    struct vcplx acc = vcmul(vpoly_eval(&in->d[0][AOA_ANT_COLS], AOA_ANT_COLS - 1, wx), wx);
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    const struct vcplx wx_shift = vturn(-(AOA_ANT_COLS - 1) * psi_x);
+    const struct vcplx wy = vturn(psi_y);
+    struct vcplx rows = { splat(0.0f), splat(0.0f) };
+
+    AOA_UNROLL
+    for (int l = AOA_ANT_ROWS - 1; l >= 1; l--) {
+        const struct vcplx q = vcmul(vpoly_eval(in->d[l], BEAM_LAG_COLS, wx), wx_shift);
+
+        rows.re += q.re;
+        rows.im += q.im;
+        rows = vcmul(rows, wy);
+    }
+    acc.re += rows.re;
+#else
+    ARG_UNUSED(psi_y);
+#endif
+    return in->d[0][AOA_ANT_COLS - 1].re + 2.0f * acc.re;
+}
+
+#else
+
+static inline struct vcplx vrow_steer(const struct cplx *row, struct vcplx w)
+{
+    struct vcplx acc = { splat(row[AOA_ANT_COLS - 1].re), splat(row[AOA_ANT_COLS - 1].im) };
+
+    AOA_UNROLL
+    for (int m = AOA_ANT_COLS - 2; m >= 0; m--) {
+        const vf re = acc.re * w.re - acc.im * w.im + row[m].re;
+        const vf im = acc.re * w.im + acc.im * w.re + row[m].im;
+        acc.re = re;
+        acc.im = im;
+    }
+    return acc;
+}
+
+static inline vf vsteer_power(const struct beam_input *in, vf psi_x, vf psi_y)
+{
+    const struct cplx *x = in->x;
+    const struct vcplx wx = vturn(psi_x);
+    struct vcplx acc = vrow_steer(&x[(AOA_ANT_ROWS - 1) * AOA_ANT_COLS], wx);
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    const struct vcplx wy = vturn(psi_y);
+
+    AOA_UNROLL
+    for (int r = AOA_ANT_ROWS - 2; r >= 0; r--) {
+        const struct vcplx row = vrow_steer(&x[r * AOA_ANT_COLS], wx);
+        const vf re = acc.re * wy.re - acc.im * wy.im + row.re;
+        const vf im = acc.re * wy.im + acc.im * wy.re + row.im;
+        acc.re = re;
+        acc.im = im;
+    }
+#else
+    ARG_UNUSED(psi_y);
+#endif
+    return acc.re * acc.re + acc.im * acc.im;
+}
+
+#endif /* CONFIG_AOA_RX_COVARIANCE */
+
+static inline vf vpower_at(const struct beam_input *in, float k, vf az, vf el)
+{
+    vf saz, caz;
+
+    vsincos(az * DEG_TO_RAD, &saz, &caz);
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    vf sel, cel;
+
+    vsincos(el * DEG_TO_RAD, &sel, &cel);
+    const vf r = k * cel;
+    return vsteer_power(in, r * caz, r * saz);
+#else
+    ARG_UNUSED(el);
+    return vsteer_power(in, k * saz, splat(0.0f));
+#endif
+}
+
+static void beam_power_vec(const struct beam_input *in, float k, const float *az, const float *el,
+                           float *power, int count)
+{
+    int i = 0;
+
+    for (; i + VEC_LANES <= count; i += VEC_LANES) {
+        store(&power[i], vpower_at(in, k, load(&az[i]), load(&el[i])));
+    }
+    if (i < count) {
+        // The last few directions, padded with copies of the first
+        float a[VEC_LANES];
+        float e[VEC_LANES];
+        float p[VEC_LANES];
+
+        for (int j = 0; j < VEC_LANES; j++) {
+            a[j] = az[i + (i + j < count ? j : 0)];
+            e[j] = el[i + (i + j < count ? j : 0)];
+        }
+        store(p, vpower_at(in, k, load(a), load(e)));
+        memcpy(&power[i], p, (count - i) * sizeof(float));
+    }
+}
+
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+
+// (re, im) pairs swapped to (im, re)
+static inline vf swap_pairs(vf v)
+{
+#if VEC_LANES == 8
+#define PAIRS 1, 0, 3, 2, 5, 4, 7, 6
+#else
+#define PAIRS 1, 0, 3, 2
+#endif
+#if defined(__clang__)
+    return __builtin_shufflevector(v, v, PAIRS);
+#else
+    return __builtin_shuffle(v, (vi){ PAIRS });
+#endif
+#undef PAIRS
+}
+
+/*
+ * One row of the upper triangle at a time: entry (m, n) gains
+ * y[m] * conj(y[n]), which over interleaved (re, im) lanes of y[n] is
+ * re(y[m]) * (re, -im) + im(y[m]) * (im, re).
+ */
+static void cov_rank1_vec(struct cplx r[COV_ENTRIES], const struct cplx y[AOA_ANT_COUNT], float g,
+                          float h)
+{
+    int k = 0;
+
+    for (int m = 0; m < AOA_ANT_COUNT; m++) {
+        vf a = splat(y[m].re);
+        const vf b = splat(y[m].im);
+        float *row = &r[k].re;
+        const float *yn = &y[m].re;
+        const int len = 2 * (AOA_ANT_COUNT - m);
+        int i = 0;
+
+        for (int j = 1; j < VEC_LANES; j += 2) {
+            a[j] = -a[j];
+        }
+        for (; i + VEC_LANES <= len; i += VEC_LANES) {
+            const vf v = load(&yn[i]);
+            const vf rv = load(&row[i]);
+            store(&row[i], rv + g * ((a * v + b * swap_pairs(v)) - h * rv));
+        }
+        if (i < len) {
+            float t[VEC_LANES] = { 0 };
+            float u[VEC_LANES] = { 0 };
+
+            memcpy(t, &yn[i], (len - i) * sizeof(float));
+            memcpy(u, &row[i], (len - i) * sizeof(float));
+
+            const vf v = load(t);
+            const vf rv = load(u);
+            store(u, rv + g * ((a * v + b * swap_pairs(v)) - h * rv));
+            memcpy(&row[i], u, (len - i) * sizeof(float));
+        }
+        k += AOA_ANT_COUNT - m;
+    }
+}
+
+#endif /* CONFIG_AOA_RX_COVARIANCE */
+
+const struct kernels KERNELS = {
+    .beam_power = beam_power_vec,
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+    .cov_rank1 = cov_rank1_vec,
+#endif
+};
+
+#endif /* AOA_CORE_KERNELS_VEC_H_ */
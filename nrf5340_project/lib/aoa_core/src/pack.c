@@ -0,0 +1,308 @@
+#include "fixed.h"
+#include "pack.h"
+#include "q15.h"
+
+/*
+ * Packed IQ samples. Each sample of a CTE is close to an earlier one
+ * turned by the tone and carrier offset: the previous sample during the
+ * reference period, and the previous sample of the same element while
+ * switching. The encoder measures the phase step per microsecond over the
+ * reference period and sends it. Both ends then predict every sample from
+ * samples already decoded with the same integer arithmetic, so only the
+ * residuals travel. An element's first sample is predicted from the one
+ * before it and its residual carries the element's phase offset.
+ *
+ * Residuals are Rice coded in blocks of BLOCK, each with the parameter
+ * that suits its mean. Coding takes a table lookup, a complex multiply
+ * (two instructions with the DSP extension, see q15.h) and a few shifts
+ * per sample and no floating point, so a locator without an FPU packs as
+ * fast as it sends. Reports whose residuals would not beat
+ * raw bytes, such as pure noise, go raw.
+ */
+
+#define BLOCK 16                // Residuals per Rice parameter, 8 samples
+#define K_BITS 4
+#define K_MAX 8
+#define ESCAPE 16               // Quotients from here on are sent as a raw residual
+#define RAW_BITS 9              // Residual of 8-bit samples, zigzagged
+
+// sin over a quarter turn in 64 steps, Q14
+static const int16_t sin_quarter[65] = {
+    0, 402, 804, 1205, 1606, 2006, 2404, 2801,
+    3196, 3590, 3981, 4370, 4756, 5139, 5520, 5897,
+    6270, 6639, 7005, 7366, 7723, 8076, 8423, 8765,
+    9102, 9434, 9760, 10080, 10394, 10702, 11003, 11297,
+    11585, 11866, 12140, 12406, 12665, 12916, 13160, 13395,
+    13623, 13842, 14053, 14256, 14449, 14635, 14811, 14978,
+    15137, 15286, 15426, 15557, 15679, 15791, 15893, 15986,
+    16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379,
+    16384,
+};
+
+// Angle in 1/256 turn
+static inline int32_t sin8(uint8_t a)
+{
+    const int k = a & 63;
+    const int32_t s = (a & 64) ? sin_quarter[64 - k] : sin_quarter[k];
+    return (a & 128) ? -s : s;
+}
+
+static inline int32_t clamp8(int32_t v)
+{
+    return CLAMP(v, INT8_MIN, INT8_MAX);
+}
+
+/*
+ * Sample n is predicted from its predecessor: the sample before it during
+ * the reference period and in the first switching round, then the
+ * previous sample of the same element. Element 0's first one in the
+ * switching rounds follows the last reference sample.
+ */
+static inline int predecessor(int n)
+{
+    return n >= AOA_REF_SAMPLES + AOA_ANT_COUNT - 1 ? n - AOA_ANT_COUNT : n - 1;
+}
+
+static inline struct aoa_iq_sample predict(uint16_t step, const struct aoa_iq_sample *x, int n)
+{
+    const int m = predecessor(n);
+    struct aoa_iq_sample p = { 0, 0 };
+
+    if (m < 0) {
+        return p;
+    }
+
+    const int dt = aoa_sample_time_us(n) - aoa_sample_time_us(m);
+    const uint8_t a = (uint16_t)(step * dt + 128) >> 8;
+    const struct aoa_iq_sample w = { sin8(a + 64), sin8(a) };
+    int32_t re, im;
+
+    q15_cmul(x[m], w, &re, &im);
+    p.i = clamp8((re + (1 << 13)) >> 14);
+    p.q = clamp8((im + (1 << 13)) >> 14);
+    return p;
+}
+
+static inline uint32_t zigzag(int32_t r)
+{
+    return r >= 0 ? 2 * (uint32_t)r : 2 * (uint32_t)-r - 1;
+}
+
+static inline int32_t unzigzag(uint32_t u)
+{
+    return (u & 1) ? -(int32_t)(u >> 1) - 1 : (int32_t)(u >> 1);
+}
+
+struct bit_writer {
+    uint8_t *p;
+    uint8_t *end;
+    uint32_t acc;
+    int n;
+    bool overflow;
+};
+
+// At most 24 bits at a time, least significant first
+static inline void bits_put(struct bit_writer *w, uint32_t v, int bits)
+{
+    w->acc |= v << w->n;
+    w->n += bits;
+    while (w->n >= 8) {
+        if (w->p < w->end) {
+            *w->p++ = w->acc;
+        } else {
+            w->overflow = true;
+        }
+        w->acc >>= 8;
+        w->n -= 8;
+    }
+}
+
+static inline void rice_put(struct bit_writer *w, uint32_t u, int k)
+{
+    const uint32_t q = u >> k;
+
+    if (q >= ESCAPE) {
+        bits_put(w, 0, ESCAPE);
+        bits_put(w, u, RAW_BITS);
+        return;
+    }
+    bits_put(w, 1u << q, q + 1);
+    bits_put(w, u & ((1u << k) - 1), k);
+}
+
+// Rice parameter for a mean residual of sum / count
+static inline int rice_k(uint32_t sum, int count)
+{
+    int k = 0;
+
+    while (k < K_MAX && ((uint32_t)count << (k + 1)) <= sum) {
+        k++;
+    }
+    return k;
+}
+
+struct bit_reader {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint32_t acc;
+    int n;
+    int pad;                    // Zero bytes fed in past the end
+};
+
+static inline void bits_fill(struct bit_reader *r)
+{
+    while (r->n <= 24) {
+        uint32_t b = 0;
+
+        if (r->p < r->end) {
+            b = *r->p++;
+        } else {
+            r->pad++;
+        }
+        r->acc |= b << r->n;
+        r->n += 8;
+    }
+}
+
+static inline uint32_t bits_get(struct bit_reader *r, int bits)
+{
+    bits_fill(r);
+
+    const uint32_t v = r->acc & ((1u << bits) - 1);
+    r->acc >>= bits;
+    r->n -= bits;
+    return v;
+}
+
+static inline uint32_t rice_get(struct bit_reader *r, int k)
+{
+    bits_fill(r);
+    if ((r->acc & ((1u << ESCAPE) - 1)) == 0) {
+        r->acc >>= ESCAPE;
+        r->n -= ESCAPE;
+        return bits_get(r, RAW_BITS);
+    }
+
+    const int q = __builtin_ctz(r->acc);
+    r->acc >>= q + 1;
+    r->n -= q + 1;
+    return (uint32_t)q << k | bits_get(r, k);
+}
+
+static void pack_raw(const struct aoa_iq_sample *x, int count, uint8_t *buf)
+{
+    buf[0] = IQ_CODING_RAW8;
+    for (int n = 0; n < count; n++) {
+        buf[1 + 2 * n] = (uint8_t)x[n].i;
+        buf[2 + 2 * n] = (uint8_t)x[n].q;
+    }
+}
+
+int iq_pack(const struct aoa_iq_sample *x, int count, uint8_t *buf, size_t size)
+{
+    const size_t raw_len = IQ_PACK_SIZE_MAX(count);
+
+    for (int n = 0; n < count; n++) {
+        if (x[n].i != clamp8(x[n].i) || x[n].q != clamp8(x[n].q)) {
+            return -ERANGE;
+        }
+    }
+    if (size < raw_len) {
+        return -ENOSPC;
+    }
+
+    // Phase step per microsecond over the reference period, scaled up for precision
+    int64_t re, im;
+    q15_corr(x, &x[1], MIN(count, AOA_REF_SAMPLES) - 1, &re, &im);
+
+    int32_t re32, im32;
+    fx_narrow(re * 4096, im * 4096, &re32, &im32);
+
+    const uint16_t step = ((uint32_t)fx_atan2(im32, re32, NULL) + 0x8000) >> 16;
+
+    uint16_t u[2 * AOA_IQ_SAMPLES_MAX];
+    for (int n = 0; n < count; n++) {
+        const struct aoa_iq_sample p = predict(step, x, n);
+        u[2 * n] = zigzag(x[n].i - p.i);
+        u[2 * n + 1] = zigzag(x[n].q - p.q);
+    }
+
+    // Rice code, unless it ends up no shorter than raw bytes
+    struct bit_writer w = { .p = &buf[3], .end = &buf[raw_len - 1] };
+    for (int b = 0; b < 2 * count && !w.overflow; b += BLOCK) {
+        const int len = MIN(BLOCK, 2 * count - b);
+        uint32_t sum = 0;
+        for (int c = b; c < b + len; c++) {
+            sum += u[c];
+        }
+        const int k = rice_k(sum, len);
+        bits_put(&w, k, K_BITS);
+        for (int c = b; c < b + len; c++) {
+            rice_put(&w, u[c], k);
+        }
+    }
+    if (w.n > 0) {
+        bits_put(&w, 0, 8 - w.n);
+    }
+    if (w.overflow || (size_t)(w.p - buf) >= raw_len) {
+        pack_raw(x, count, buf);
+        return raw_len;
+    }
+
+    buf[0] = IQ_CODING_RICE;
+    buf[1] = step;
+    buf[2] = step >> 8;
+    return w.p - buf;
+}
+
+static int unpack_rice(const uint8_t *buf, size_t len, struct aoa_iq_sample *x, int count)
+{
+    if (len < 3) {
+        return -EBADMSG;
+    }
+
+    const uint16_t step = buf[1] | buf[2] << 8;
+    struct bit_reader r = { .p = &buf[3], .end = &buf[len] };
+    int k = 0;
+
+    for (int n = 0; n < count; n++) {
+        if ((2 * n) % BLOCK == 0) {
+            k = bits_get(&r, K_BITS);
+        }
+        const struct aoa_iq_sample p = predict(step, x, n);
+        const int32_t i = p.i + unzigzag(rice_get(&r, k));
+        const int32_t q = p.q + unzigzag(rice_get(&r, k));
+        if (i != clamp8(i) || q != clamp8(q)) {
+            return -EBADMSG;
+        }
+        x[n].i = i;
+        x[n].q = q;
+    }
+
+    // Every byte used, the last one only partly, and no padding
+    const int left = r.n - 8 * r.pad;
+    return r.p == r.end && left >= 0 && left < 8 ? 0 : -EBADMSG;
+}
+
+int iq_unpack(const uint8_t *buf, size_t len, struct aoa_iq_sample *x, int count)
+{
+    if (len < 1) {
+        return -EBADMSG;
+    }
+
+    switch (buf[0]) {
+    case IQ_CODING_RAW8:
+        if (len != (size_t)IQ_PACK_SIZE_MAX(count)) {
+            return -EBADMSG;
+        }
+        for (int n = 0; n < count; n++) {
+            x[n].i = (int8_t)buf[1 + 2 * n];
+            x[n].q = (int8_t)buf[2 + 2 * n];
+        }
+        return 0;
+    case IQ_CODING_RICE:
+        return unpack_rice(buf, len, x, count);
+    default:
+        return -EBADMSG;
+    }
+}
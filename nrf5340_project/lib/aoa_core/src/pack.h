@@ -0,0 +1,28 @@
+#ifndef AOA_CORE_PACK_H_
+#define AOA_CORE_PACK_H_
+
+#include <stdint.h>
+
+#include "aoa/report.h"
+
+/* Sample coding of a packed IQ record, its first byte */
+enum iq_coding {
+    IQ_CODING_RAW8,           // I and Q as signed bytes
+    IQ_CODING_RICE,           // Phase step, then Rice coded prediction residuals
+};
+
+/* Packed samples at most: the coding byte and two bytes per sample */
+#define IQ_PACK_SIZE_MAX(count) (1 + 2 * (count))
+
+/**
+ * @brief Pack IQ samples, Rice coded if that is shorter than raw bytes.
+ *
+ * @return Bytes written, -ERANGE if a sample does not fit in 8 bits, or
+ *         -ENOSPC if @p size is below IQ_PACK_SIZE_MAX(count).
+ */
+int iq_pack(const struct aoa_iq_sample *x, int count, uint8_t *buf, size_t size);
+
+/** @return 0, or -EBADMSG if @p buf does not hold exactly @p count samples. */
+int iq_unpack(const uint8_t *buf, size_t len, struct aoa_iq_sample *x, int count);
+
+#endif /* AOA_CORE_PACK_H_ */
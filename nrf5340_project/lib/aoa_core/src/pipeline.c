@@ -0,0 +1,83 @@
+#include "aoa/dsp.h"
+
+// RF centre frequency of a BLE channel index in MHz
+uint32_t chan_freq_mhz(uint8_t chan_idx)
+{
+    if (chan_idx <= 10) {
+        return 2404 + 2 * chan_idx;
+    } else if (chan_idx <= 36) {
+        return 2428 + 2 * (chan_idx - 11);
+    } else if (chan_idx == 37) {
+        return 2402;
+    } else if (chan_idx == 38) {
+        return 2426;
+    }
+    return 2480;
+}
+
+// Configured estimator, on the snapshot or on the tag's covariance
+static int estimate_full(struct aoa_state *state, const struct aoa_iq_report *report,
+                         const struct cplx x[AOA_ANT_COUNT], struct aoa_angle_result *result)
+{
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+    const struct cov *cov;
+    int err = cov_update(state, report, x, &cov);
+    if (err) {
+        return err;
+    }
+    return estimate_angle(cov, result);
+#else
+    ARG_UNUSED(state);
+    return estimate_angle(x, report->chan_idx, result);
+#endif
+}
+
+// A report from a new holder of its tag id restarts the covariance and track of that id
+static void state_claim(struct aoa_state *state, const struct aoa_iq_report *report)
+{
+    const uint8_t id = report->tag_id;
+
+    if (id >= ARRAY_SIZE(state->generation) || state->generation[id] == report->generation) {
+        return;
+    }
+    state->generation[id] = report->generation;
+#if defined(CONFIG_AOA_RX_COVARIANCE)
+    state->cov[id].valid = false;
+#endif
+#if !defined(CONFIG_AOA_RX_TRACK_NONE)
+    state->track[id].valid = false;
+#endif
+}
+
+// Snapshot, estimator and tracking filter are all fixed at build time
+int aoa_process(struct aoa_state *state, const struct aoa_iq_report *report, bool downgrade,
+                struct aoa_angle_result *result)
+{
+    state_claim(state, report);
+
+    struct cplx x[AOA_ANT_COUNT];
+    int err = snapshot_build(report, x);
+    if (err) {
+        return err;
+    }
+    if (state->calib) {
+        calib_apply(state->calib, report->chan_idx, x);
+    }
+
+    if (downgrade) {
+        err = estimate_phase_diff(x, report->chan_idx, result);
+    } else {
+        err = estimate_full(state, report, x, result);
+    }
+    if (err) {
+        return err;
+    }
+
+    result->timestamp = report->timestamp;
+    result->event_counter = report->event_counter;
+    result->source = report->source;
+    result->tag_id = report->tag_id;
+    track_update(state, result);
+    state->reports++;
+    return 0;
+}
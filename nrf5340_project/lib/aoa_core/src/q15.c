@@ -0,0 +1,99 @@
+#include "aoa/simd.h"
+#include "q15.h"
+
+void q15_corr_ref(const struct aoa_iq_sample *x, const struct aoa_iq_sample *y, int count,
+                  int64_t *re, int64_t *im)
+{
+    *re = 0;
+    *im = 0;
+    for (int n = 0; n < count; n++) {
+        *re += (int64_t)y[n].i * x[n].i + (int64_t)y[n].q * x[n].q;
+        *im += (int64_t)y[n].q * x[n].i - (int64_t)y[n].i * x[n].q;
+    }
+}
+
+void q15_cmul_ref(struct aoa_iq_sample x, struct aoa_iq_sample w, int32_t *re, int32_t *im)
+{
+    *re = (int32_t)x.i * w.i - (int32_t)x.q * w.q;
+    *im = (int32_t)x.i * w.q + (int32_t)x.q * w.i;
+}
+
+#define CHECK_SAMPLES AOA_IQ_SAMPLES_MAX
+#define CHECK_ROUNDS 32
+
+static uint32_t xorshift(uint32_t *seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+/*
+ * One pass over @p x: correlations at every element lag, and rotations.
+ * Returns a fingerprint of every result, so the two passes compare in one.
+ */
+static uint64_t run(const struct aoa_iq_sample *x, const struct aoa_iq_sample *w, bool ref)
+{
+    uint64_t sum = 0;
+    int64_t re, im;
+    int32_t re32, im32;
+
+    for (int lag = 1; lag <= AOA_ANT_MAX; lag++) {
+        if (ref) {
+            q15_corr_ref(x, &x[lag], CHECK_SAMPLES - lag, &re, &im);
+        } else {
+            q15_corr(x, &x[lag], CHECK_SAMPLES - lag, &re, &im);
+        }
+        sum = sum * 31 + (uint64_t)re;
+        sum = sum * 31 + (uint64_t)im;
+    }
+    for (int n = 0; n < CHECK_SAMPLES; n++) {
+        if (ref) {
+            q15_cmul_ref(x[n], w[n], &re32, &im32);
+        } else {
+            q15_cmul(x[n], w[n], &re32, &im32);
+        }
+        sum = sum * 31 + (uint32_t)re32;
+        sum = sum * 31 + (uint32_t)im32;
+    }
+    return sum;
+}
+
+int aoa_q15_check(uint64_t (*now)(void), struct aoa_q15_timing *timing)
+{
+    static struct aoa_iq_sample x[CHECK_SAMPLES];
+    static struct aoa_iq_sample w[CHECK_SAMPLES];
+    uint32_t seed = 0x9e3779b9;
+    int err = 0;
+
+    if (timing) {
+        *timing = (struct aoa_q15_timing){ .dsp = Q15_DSP };
+    }
+    for (int round = 0; round < CHECK_ROUNDS; round++) {
+        // Full-scale samples, with the extremes in the first round; Q14 rotations
+        for (int n = 0; n < CHECK_SAMPLES; n++) {
+            const uint32_t r = xorshift(&seed);
+
+            x[n].i = round ? (int16_t)r : (n & 1 ? INT16_MIN : INT16_MAX);
+            x[n].q = round ? (int16_t)(r >> 16) : (n & 2 ? INT16_MIN : INT16_MAX);
+            w[n].i = (int16_t)xorshift(&seed) >> 1;
+            w[n].q = (int16_t)xorshift(&seed) >> 1;
+        }
+
+        const uint64_t t0 = now ? now() : 0;
+        const uint64_t fast = run(x, w, false);
+        const uint64_t t1 = now ? now() : 0;
+        const uint64_t slow = run(x, w, true);
+        const uint64_t t2 = now ? now() : 0;
+
+        if (fast != slow) {
+            err = -EDOM;
+        }
+        if (timing) {
+            timing->kernels += t1 - t0;
+            timing->reference += t2 - t1;
+        }
+    }
+    return err;
+}
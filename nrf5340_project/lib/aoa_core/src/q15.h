@@ -0,0 +1,123 @@
+#ifndef AOA_CORE_Q15_H_
+#define AOA_CORE_Q15_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "aoa/report.h"
+
+/* ACLE names the dual 16-bit multiplies SIMD32; the M33 has them with the DSP extension */
+#if defined(__ARM_FEATURE_DSP) && defined(__ARM_FEATURE_SIMD32)
+#define Q15_DSP 1
+#include <arm_acle.h>
+#else
+#define Q15_DSP 0
+#endif
+
+/*
+ * Complex kernels on packed 16-bit I/Q. An aoa_iq_sample is one word with
+ * I in the low half and Q in the high half, the operand layout of the
+ * dual 16-bit multiplies of the Armv8-M DSP extension. SMLALD adds both
+ * products of a pair to a 64-bit sum and SMLSLDX their crossed
+ * difference, so a complex multiply-accumulate takes two instructions.
+ * With __ARM_FEATURE_DSP, as on the nRF5340 application core, the kernels
+ * issue them through ACLE. Everywhere else, native_sim and the host tools
+ * included, the same kernels run on C versions of the instructions.
+ * q15.c keeps plain references that aoa_q15_check() compares them with.
+ */
+
+BUILD_ASSERT(sizeof(struct aoa_iq_sample) == 4 && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+             "Packed I/Q needs I in the low half of a word");
+
+static inline int32_t q15_word(const struct aoa_iq_sample *s)
+{
+    int32_t w;
+
+    memcpy(&w, s, sizeof(w));
+    return w;
+}
+
+#if Q15_DSP
+
+#define q15_smlald __smlald
+#define q15_smlsldx __smlsldx
+#define q15_smusd __smusd
+#define q15_smuadx __smuadx
+
+#else
+
+static inline int32_t q15_lo(int32_t w)
+{
+    return (int16_t)w;
+}
+
+static inline int32_t q15_hi(int32_t w)
+{
+    return (int16_t)(w >> 16);
+}
+
+// acc + lo(x) * lo(y) + hi(x) * hi(y)
+static inline int64_t q15_smlald(int32_t x, int32_t y, int64_t acc)
+{
+    return acc + (int64_t)(q15_lo(x) * q15_lo(y)) + q15_hi(x) * q15_hi(y);
+}
+
+// acc + lo(x) * hi(y) - hi(x) * lo(y)
+static inline int64_t q15_smlsldx(int32_t x, int32_t y, int64_t acc)
+{
+    return acc + (int64_t)(q15_lo(x) * q15_hi(y)) - q15_hi(x) * q15_lo(y);
+}
+
+// lo(x) * lo(y) - hi(x) * hi(y), wrapping like the instruction
+static inline int32_t q15_smusd(int32_t x, int32_t y)
+{
+    return (int32_t)((uint32_t)(q15_lo(x) * q15_lo(y)) - (uint32_t)(q15_hi(x) * q15_hi(y)));
+}
+
+// lo(x) * hi(y) + hi(x) * lo(y), wrapping like the instruction
+static inline int32_t q15_smuadx(int32_t x, int32_t y)
+{
+    return (int32_t)((uint32_t)(q15_lo(x) * q15_hi(y)) + (uint32_t)(q15_hi(x) * q15_lo(y)));
+}
+
+#endif /* Q15_DSP */
+
+/** @brief Sum of y[n] * conj(x[n]) over @p count samples, exact. */
+static inline void q15_corr(const struct aoa_iq_sample *x, const struct aoa_iq_sample *y,
+                            int count, int64_t *re, int64_t *im)
+{
+    int64_t r = 0;
+    int64_t i = 0;
+
+    for (int n = 0; n < count; n++) {
+        const int32_t a = q15_word(&x[n]);
+        const int32_t b = q15_word(&y[n]);
+
+        r = q15_smlald(b, a, r);    // y.i x.i + y.q x.q
+        i = q15_smlsldx(a, b, i);   // x.i y.q - x.q y.i
+    }
+    *re = r;
+    *im = i;
+}
+
+/**
+ * @brief x * w, unscaled: with w in Q14 the product is in Q14 too.
+ *
+ * Parts of @p w must stay within +-2^14 so the sums cannot wrap.
+ */
+static inline void q15_cmul(struct aoa_iq_sample x, struct aoa_iq_sample w, int32_t *re,
+                            int32_t *im)
+{
+    const int32_t a = q15_word(&x);
+    const int32_t b = q15_word(&w);
+
+    *re = q15_smusd(a, b);          // x.i w.i - x.q w.q
+    *im = q15_smuadx(a, b);         // x.i w.q + x.q w.i
+}
+
+/* Plain C, term by term, for checking the kernels */
+void q15_corr_ref(const struct aoa_iq_sample *x, const struct aoa_iq_sample *y, int count,
+                  int64_t *re, int64_t *im);
+void q15_cmul_ref(struct aoa_iq_sample x, struct aoa_iq_sample w, int32_t *re, int32_t *im);
+
+#endif /* AOA_CORE_Q15_H_ */
@@ -0,0 +1,268 @@
+#include <string.h>
+
+#include "aoa/record.h"
+#include "pack.h"
+
+// Report fields ahead of the samples in an IQ record
+#define IQ_FIELDS_SIZE (AOA_RECORD_IQ_SIZE_MIN - AOA_RECORD_PREFIX_SIZE)
+
+/*
+ * Byte order helpers; the record format is little endian whatever the
+ * host is, and floats travel as their IEEE 754 bit patterns.
+ */
+
+static inline void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v)
+{
+    put_le16(p, v);
+    put_le16(p + 2, v >> 16);
+}
+
+static inline uint16_t get_le16(const uint8_t *p)
+{
+    return p[0] | (uint16_t)p[1] << 8;
+}
+
+static inline uint32_t get_le32(const uint8_t *p)
+{
+    return get_le16(p) | (uint32_t)get_le16(p + 2) << 16;
+}
+
+static inline void put_float(uint8_t *p, float f)
+{
+    uint32_t v;
+
+    memcpy(&v, &f, sizeof(v));
+    put_le32(p, v);
+}
+
+static inline float get_float(const uint8_t *p)
+{
+    const uint32_t v = get_le32(p);
+    float f;
+
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
+
+int aoa_record_header_encode(uint8_t *buf, size_t size)
+{
+    if (size < AOA_RECORD_HEADER_SIZE) {
+        return -ENOSPC;
+    }
+
+    put_le32(&buf[0], AOA_RECORD_MAGIC);
+    buf[4] = AOA_RECORD_VERSION;
+    buf[5] = AOA_SLOT_DURATION;
+    buf[6] = AOA_ANT_ROWS;
+    buf[7] = AOA_ANT_COLS;
+    put_le32(&buf[8], AOA_ANT_SPACING_UM);
+    return AOA_RECORD_HEADER_SIZE;
+}
+
+int aoa_record_header_decode(const uint8_t *buf, size_t len)
+{
+    if (len < AOA_RECORD_HEADER_SIZE) {
+        return -EAGAIN;
+    }
+    if (get_le32(&buf[0]) != AOA_RECORD_MAGIC || buf[4] > AOA_RECORD_VERSION) {
+        return -EBADMSG;
+    }
+    if (buf[5] != AOA_SLOT_DURATION || buf[6] != AOA_ANT_ROWS || buf[7] != AOA_ANT_COLS ||
+        get_le32(&buf[8]) != AOA_ANT_SPACING_UM) {
+        return -ENOTSUP;
+    }
+    return AOA_RECORD_HEADER_SIZE;
+}
+
+static void prefix_put(uint8_t *buf, size_t len, enum aoa_record_type type)
+{
+    put_le16(&buf[0], len);
+    buf[2] = type;
+}
+
+static void iq_fields_put(uint8_t *p, const struct aoa_iq_report *report)
+{
+    put_le32(&p[0], report->timestamp);
+    put_le16(&p[4], report->event_counter);
+    put_le16(&p[6], report->rssi);
+    p[8] = report->source;
+    p[9] = report->tag_id;
+    p[10] = report->chan_idx;
+    p[11] = report->slot_durations;
+    p[12] = report->packet_status;
+    p[13] = report->sample_count;
+}
+
+int aoa_record_encode_iq(const struct aoa_iq_report *report, uint8_t *buf, size_t size)
+{
+    const size_t len = AOA_RECORD_IQ_SIZE_MIN + 4 * report->sample_count;
+    if (size < len) {
+        return -ENOSPC;
+    }
+
+    prefix_put(buf, len, AOA_RECORD_IQ);
+    iq_fields_put(&buf[AOA_RECORD_PREFIX_SIZE], report);
+    uint8_t *p = &buf[AOA_RECORD_IQ_SIZE_MIN];
+    for (int n = 0; n < report->sample_count; n++, p += 4) {
+        put_le16(&p[0], report->samples[n].i);
+        put_le16(&p[2], report->samples[n].q);
+    }
+    return len;
+}
+
+int aoa_record_encode_iq_packed(const struct aoa_iq_report *report, uint8_t *buf, size_t size)
+{
+    if (size < AOA_RECORD_IQ_SIZE_MIN) {
+        return -ENOSPC;
+    }
+
+    const int n = iq_pack(report->samples, report->sample_count, &buf[AOA_RECORD_IQ_SIZE_MIN],
+                          size - AOA_RECORD_IQ_SIZE_MIN);
+    if (n == -ERANGE) {
+        return aoa_record_encode_iq(report, buf, size);
+    }
+    if (n < 0) {
+        return n;
+    }
+
+    const size_t len = AOA_RECORD_IQ_SIZE_MIN + n;
+    prefix_put(buf, len, AOA_RECORD_IQ_PACKED);
+    iq_fields_put(&buf[AOA_RECORD_PREFIX_SIZE], report);
+    return len;
+}
+
+int aoa_record_encode_angle(const struct aoa_angle_result *result, uint8_t *buf, size_t size)
+{
+    if (size < AOA_RECORD_ANGLE_SIZE) {
+        return -ENOSPC;
+    }
+
+    prefix_put(buf, AOA_RECORD_ANGLE_SIZE, AOA_RECORD_ANGLE);
+    uint8_t *p = &buf[AOA_RECORD_PREFIX_SIZE];
+    put_le32(&p[0], result->timestamp);
+    put_le16(&p[4], result->event_counter);
+    p[6] = result->source;
+    p[7] = result->tag_id;
+    put_float(&p[8], result->azimuth);
+    put_float(&p[12], result->elevation);
+    put_float(&p[16], result->quality);
+    return AOA_RECORD_ANGLE_SIZE;
+}
+
+int aoa_record_encode_history(const uint8_t *batch, size_t len, uint8_t *buf, size_t size)
+{
+    if (len > AOA_HISTORY_BATCH_MAX || size < AOA_RECORD_PREFIX_SIZE + len) {
+        return -ENOSPC;
+    }
+
+    prefix_put(buf, AOA_RECORD_PREFIX_SIZE + len, AOA_RECORD_HISTORY);
+    memcpy(&buf[AOA_RECORD_PREFIX_SIZE], batch, len);
+    return AOA_RECORD_PREFIX_SIZE + len;
+}
+
+static void iq_fields_get(const uint8_t *p, struct aoa_iq_report *report)
+{
+    report->timestamp = get_le32(&p[0]);
+    report->event_counter = get_le16(&p[4]);
+    report->rssi = (int16_t)get_le16(&p[6]);
+    report->source = p[8];
+    report->tag_id = p[9];
+    report->chan_idx = p[10];
+    report->slot_durations = p[11];
+    report->packet_status = p[12];
+    report->sample_count = p[13];
+    report->priority = 0;
+    report->generation = 0;
+}
+
+static int iq_decode(const uint8_t *p, size_t len, struct aoa_iq_report *report)
+{
+    if (len < IQ_FIELDS_SIZE || p[13] > AOA_IQ_SAMPLES_MAX ||
+        len != IQ_FIELDS_SIZE + 4 * (size_t)p[13]) {
+        return -EBADMSG;
+    }
+
+    iq_fields_get(p, report);
+    p += IQ_FIELDS_SIZE;
+    for (int n = 0; n < report->sample_count; n++, p += 4) {
+        report->samples[n].i = (int16_t)get_le16(&p[0]);
+        report->samples[n].q = (int16_t)get_le16(&p[2]);
+    }
+    return 0;
+}
+
+static int iq_packed_decode(const uint8_t *p, size_t len, struct aoa_iq_report *report)
+{
+    if (len < IQ_FIELDS_SIZE || p[13] > AOA_IQ_SAMPLES_MAX) {
+        return -EBADMSG;
+    }
+
+    iq_fields_get(p, report);
+    return iq_unpack(&p[IQ_FIELDS_SIZE], len - IQ_FIELDS_SIZE, report->samples,
+                     report->sample_count);
+}
+
+static int angle_decode(const uint8_t *p, size_t len, struct aoa_angle_result *result)
+{
+    if (len != AOA_RECORD_ANGLE_SIZE - AOA_RECORD_PREFIX_SIZE) {
+        return -EBADMSG;
+    }
+
+    result->timestamp = get_le32(&p[0]);
+    result->event_counter = get_le16(&p[4]);
+    result->source = p[6];
+    result->tag_id = p[7];
+    result->azimuth = get_float(&p[8]);
+    result->elevation = get_float(&p[12]);
+    result->quality = get_float(&p[16]);
+    return 0;
+}
+
+int aoa_record_decode(const uint8_t *buf, size_t len, struct aoa_record *record)
+{
+    if (len < AOA_RECORD_PREFIX_SIZE) {
+        return -EAGAIN;
+    }
+
+    const size_t rec_len = get_le16(&buf[0]);
+    if (rec_len < AOA_RECORD_PREFIX_SIZE) {
+        return -EBADMSG;
+    }
+    if (len < rec_len) {
+        return -EAGAIN;
+    }
+
+    const uint8_t *body = &buf[AOA_RECORD_PREFIX_SIZE];
+    const size_t body_len = rec_len - AOA_RECORD_PREFIX_SIZE;
+    int err = 0;
+
+    record->type = buf[2];
+    switch (record->type) {
+    case AOA_RECORD_IQ:
+        err = iq_decode(body, body_len, &record->iq);
+        break;
+    case AOA_RECORD_IQ_PACKED:
+        record->type = AOA_RECORD_IQ;
+        err = iq_packed_decode(body, body_len, &record->iq);
+        break;
+    case AOA_RECORD_ANGLE:
+        err = angle_decode(body, body_len, &record->angle);
+        break;
+    case AOA_RECORD_HISTORY:
+        if (body_len < AOA_HISTORY_HEADER_SIZE || body_len > AOA_HISTORY_BATCH_MAX) {
+            err = -EBADMSG;
+        }
+        record->history.batch = body;
+        record->history.len = body_len;
+        break;
+    default:
+        break;
+    }
+    return err ? err : (int)rec_len;
+}
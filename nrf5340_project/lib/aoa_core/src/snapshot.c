@@ -0,0 +1,126 @@
+#include <math.h>
+#include <string.h>
+
+#include "aoa/dsp.h"
+
+#if defined(CONFIG_AOA_RX_MATH_FIXED)
+#include "fixed.h"
+#include "q15.h"
+#endif
+
+/*
+ * The carrier offset comes from two lags. Neighbouring reference samples,
+ * 1 us apart, give an unambiguous but noisy value. Switched samples of the
+ * same element, one round of AOA_ANT_COUNT slots apart, see it over a span
+ * many times longer, and refine it once the coarse rotation is taken out;
+ * that holds while the coarse error stays below half a turn per round.
+ */
+#define ROUND_SLOTS AOA_ANT_COUNT
+#define ROUND_US (AOA_ANT_COUNT * AOA_SAMPLE_SPACING_US)
+
+// Every element needs a switched sample; element 0 comes last in the first round
+static int report_check(const struct aoa_iq_report *report)
+{
+    if (report->sample_count < AOA_REF_SAMPLES + AOA_ANT_COUNT ||
+        report->slot_durations != AOA_SLOT_DURATION) {
+        return -EINVAL;
+    }
+    return 0;
+}
+
+#if defined(CONFIG_AOA_RX_MATH_FIXED)
+
+int snapshot_build(const struct aoa_iq_report *report, struct cplx x[AOA_ANT_COUNT])
+{
+    int err = report_check(report);
+    if (err) {
+        return err;
+    }
+
+    // Phase rotation per microsecond over the reference period
+    int64_t acc_re, acc_im;
+    q15_corr(report->samples, &report->samples[1], AOA_REF_SAMPLES - 1, &acc_re, &acc_im);
+
+    int32_t re, im;
+    fx_narrow(acc_re, acc_im, &re, &im);
+    uint32_t cfo = fx_atan2(im, re, NULL);
+
+    const int rounds = report->sample_count - AOA_REF_SAMPLES - ROUND_SLOTS;
+    if (rounds > 0) {
+        const struct aoa_iq_sample *sw = &report->samples[AOA_REF_SAMPLES];
+
+        q15_corr(sw, &sw[ROUND_SLOTS], rounds, &acc_re, &acc_im);
+        fx_narrow(acc_re, acc_im, &re, &im);
+
+        // Halved so the CORDIC gain keeps the rotated value within fx_atan2()'s range
+        re >>= 1;
+        im >>= 1;
+        fx_rotate(&re, &im, -(int32_t)(cfo * ROUND_US));
+        cfo += (int32_t)fx_atan2(im, re, NULL) / ROUND_US;
+    }
+
+    // Element 0 is taken from the switched slots only, like every other element
+    memset(x, 0, sizeof(struct cplx) * AOA_ANT_COUNT);
+    for (int n = AOA_REF_SAMPLES; n < report->sample_count; n++) {
+        // 16-bit samples scaled by 2^8 keep CORDIC precision and stay below 2^29
+        int32_t i = report->samples[n].i * 256;
+        int32_t q = report->samples[n].q * 256;
+
+        fx_rotate(&i, &q, -(int32_t)(cfo * (uint32_t)aoa_sample_time_us(n)));
+        x[aoa_sample_ant(n)].re += i >> 4;
+        x[aoa_sample_ant(n)].im += q >> 4;
+    }
+    return 0;
+}
+
+#else
+
+// Sum of s[n + lag] * conj(s[n]) over @p count samples
+static struct cplx corr(const struct aoa_iq_sample *s, int lag, int count)
+{
+    struct cplx acc = { 0.0f, 0.0f };
+
+    for (int n = 0; n < count; n++) {
+        const struct aoa_iq_sample *a = &s[n];
+        const struct aoa_iq_sample *b = &s[n + lag];
+        acc.re += (float)b->i * a->i + (float)b->q * a->q;
+        acc.im += (float)b->q * a->i - (float)b->i * a->q;
+    }
+    return acc;
+}
+
+int snapshot_build(const struct aoa_iq_report *report, struct cplx x[AOA_ANT_COUNT])
+{
+    int err = report_check(report);
+    if (err) {
+        return err;
+    }
+
+    // Phase rotation per microsecond over the reference period
+    const struct cplx coarse = corr(report->samples, 1, AOA_REF_SAMPLES - 1);
+    float cfo = atan2f(coarse.im, coarse.re);
+
+    const int rounds = report->sample_count - AOA_REF_SAMPLES - ROUND_SLOTS;
+    if (rounds > 0) {
+        const struct cplx fine = corr(&report->samples[AOA_REF_SAMPLES], ROUND_SLOTS, rounds);
+        const float c = cosf(cfo * ROUND_US);
+        const float s = sinf(cfo * ROUND_US);
+
+        cfo += atan2f(fine.im * c - fine.re * s, fine.re * c + fine.im * s) / ROUND_US;
+    }
+
+    // Element 0 is taken from the switched slots only, like every other element
+    memset(x, 0, sizeof(struct cplx) * AOA_ANT_COUNT);
+    for (int n = AOA_REF_SAMPLES; n < report->sample_count; n++) {
+        const float t = (float)aoa_sample_time_us(n);
+        const float c = cosf(cfo * t);
+        const float s = sinf(cfo * t);
+        const float i = report->samples[n].i;
+        const float q = report->samples[n].q;
+        x[aoa_sample_ant(n)].re += i * c + q * s;
+        x[aoa_sample_ant(n)].im += q * c - i * s;
+    }
+    return 0;
+}
+
+#endif /* CONFIG_AOA_RX_MATH_FIXED */
@@ -0,0 +1,96 @@
+#include <math.h>
+
+#include "aoa/dsp.h"
+
+/*
+ * Per-tag angle filter. Time is counted in events of the tag's own
+ * periodic advertising or connection, which both images agree on, rather
+ * than in core cycles, which they do not.
+ */
+
+#define ALPHA (CONFIG_AOA_RX_TRACK_ALPHA / 100.0f)
+#if defined(CONFIG_AOA_RX_TRACK_ALPHA_BETA)
+#define BETA (CONFIG_AOA_RX_TRACK_BETA / 100.0f)
+#endif
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+#define AZIMUTH_MIN -180.0f
+#define AZIMUTH_MAX 180.0f
+#else
+#define AZIMUTH_MIN -90.0f
+#define AZIMUTH_MAX 90.0f
+#endif
+
+// Shortest signed difference between two azimuths
+static float azimuth_diff(float a, float b)
+{
+    float d = a - b;
+
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    if (d >= 180.0f) {
+        d -= 360.0f;
+    } else if (d < -180.0f) {
+        d += 360.0f;
+    }
+#endif
+    return d;
+}
+
+// Back into the azimuth range after a prediction or correction step
+static float azimuth_norm(float a)
+{
+#if defined(CONFIG_AOA_RX_ARRAY_URA)
+    return azimuth_diff(a, 0.0f);
+#else
+    return fminf(fmaxf(a, AZIMUTH_MIN), AZIMUTH_MAX);
+#endif
+}
+
+static float elevation_norm(float e)
+{
+    return fminf(fmaxf(e, 0.0f), 90.0f);
+}
+
+void track_update(struct aoa_state *state, struct aoa_angle_result *result)
+{
+    if (result->tag_id >= ARRAY_SIZE(state->track)) {
+        return;
+    }
+
+    struct track *t = &state->track[result->tag_id];
+    const uint16_t dt = result->event_counter - t->event_counter;
+
+    if (!t->valid || t->source != result->source || event_gap(dt, &t->step)) {
+        *t = (struct track){
+            .valid = true,
+            .source = result->source,
+            .event_counter = result->event_counter,
+            .azimuth = result->azimuth,
+            .elevation = result->elevation,
+        };
+        return;
+    }
+    t->event_counter = result->event_counter;
+
+#if defined(CONFIG_AOA_RX_TRACK_ALPHA_BETA)
+    // Predict over dt events, then correct by the residual
+    const float az = azimuth_norm(t->azimuth + t->azimuth_rate * dt);
+    const float el = elevation_norm(t->elevation + t->elevation_rate * dt);
+    const float az_res = azimuth_diff(result->azimuth, az);
+    const float el_res = result->elevation - el;
+
+    t->azimuth = azimuth_norm(az + ALPHA * az_res);
+    t->elevation = elevation_norm(el + ALPHA * el_res);
+    // Several CTEs in one event give dt 0: correct the angle but not the rate
+    if (dt) {
+        t->azimuth_rate += BETA * az_res / dt;
+        t->elevation_rate += BETA * el_res / dt;
+    }
+#else
+    t->azimuth = azimuth_norm(t->azimuth + ALPHA * azimuth_diff(result->azimuth, t->azimuth));
+    t->elevation = elevation_norm(t->elevation + ALPHA * (result->elevation - t->elevation));
+#endif
+
+    result->azimuth = t->azimuth;
+    result->elevation = t->elevation;
+}